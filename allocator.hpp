@@ -0,0 +1,363 @@
+#ifndef M_ALLOCATOR
+#define M_ALLOCATOR
+
+#include <cstddef>    // size_t, max_align_t
+#include <cstdint>    // uintptr_t
+#include <cstdlib>    // malloc(), realloc(), free(), posix_memalign()
+#include <cstring>    // memcpy()
+#include <new>        // bad_alloc
+
+#ifdef __linux__
+#include <sys/mman.h> // mmap(), mremap(), munmap(), madvise()
+#endif
+
+/*
+ * Allocators for my::vector. An allocator only has to provide
+ *     T* allocate(size_t n);
+ *     void deallocate(T* p, size_t n);
+ * and may provide
+ *     T* reallocate(T* p, size_t old_n, size_t new_n);
+ * which returns a block of new_n slots holding the bytes of the old
+ * one; my::vector uses it to grow trivially relocatable elements.
+ */
+namespace my {
+    /* @class allocator
+     * The default allocator: plain malloc()/realloc()/free().
+     */
+    template <typename T>
+    class allocator {
+    public:
+        typedef T         value_type;
+        typedef size_t    size_type;
+
+        allocator() = default;
+        template <typename U>
+        allocator(const allocator<U>&) {}
+
+        T* allocate(size_type n) {
+            if (void *p = std::malloc(n * sizeof(T)))
+                return static_cast<T*>(p);
+            throw std::bad_alloc();
+        }
+
+        void deallocate(T *p, size_type) { std::free(p); }
+
+        T* reallocate(T *p, size_type, size_type n) {
+            if (void *np = std::realloc(static_cast<void*>(p), n * sizeof(T)))
+                return static_cast<T*>(np);
+            throw std::bad_alloc();
+        }
+
+        bool operator==(const allocator&) const { return true; }
+        bool operator!=(const allocator&) const { return false; }
+    };
+
+    /* @class aligned_allocator
+     * Blocks aligned to Align bytes (a cache line by default) whose
+     * size is padded to a multiple of Align, so that SIMD kernels
+     * never straddle a line at either end of the buffer.
+     */
+    template <typename T, size_t Align = 64>
+    class aligned_allocator {
+        static_assert((Align & (Align - 1)) == 0, "alignment must be a power of two");
+        static_assert(Align >= alignof(T), "alignment weaker than the type's");
+    public:
+        typedef T         value_type;
+        typedef size_t    size_type;
+        static const size_t    alignment = Align;
+
+        aligned_allocator() = default;
+        template <typename U>
+        aligned_allocator(const aligned_allocator<U, Align>&) {}
+
+        T* allocate(size_type n) {
+            void *p = nullptr;
+            size_t bytes = (n * sizeof(T) + Align - 1) & ~(Align - 1);
+            if (posix_memalign(&p, Align < sizeof(void*) ? sizeof(void*) : Align, bytes))
+                throw std::bad_alloc();
+            return static_cast<T*>(p);
+        }
+
+        void deallocate(T *p, size_type) { std::free(p); }
+
+        bool operator==(const aligned_allocator&) const { return true; }
+        bool operator!=(const aligned_allocator&) const { return false; }
+    };
+
+#ifdef __linux__
+    /* @class huge_page_allocator
+     * Blocks of Threshold bytes or more (2 MB by default) are mapped
+     * directly, aligned to 2 MB and marked MADV_HUGEPAGE, so that the
+     * kernel can back them with transparent huge pages and a multi-GB
+     * array needs 512 times fewer TLB entries. Smaller blocks come
+     * from malloc(). A large block grows with mremap(), which moves
+     * page table entries rather than bytes. Linux only; when THP is
+     * disabled the blocks are still valid, just with small pages.
+     */
+    template <typename T, size_t Threshold = (size_t(2) << 20)>
+    class huge_page_allocator {
+    public:
+        typedef T         value_type;
+        typedef size_t    size_type;
+        static const size_t    huge_page = size_t(2) << 20;
+
+        huge_page_allocator() = default;
+        template <typename U>
+        huge_page_allocator(const huge_page_allocator<U, Threshold>&) {}
+
+        T* allocate(size_type n) {
+            size_t bytes = n * sizeof(T);
+            if (bytes < Threshold)
+                return static_cast<T*>(small_allocate(bytes));
+            return static_cast<T*>(map(round(bytes)));
+        }
+
+        void deallocate(T *p, size_type n) {
+            size_t bytes = n * sizeof(T);
+            if (bytes < Threshold)
+                std::free(p);
+            else
+                munmap(p, round(bytes));
+        }
+
+        T* reallocate(T *p, size_type old_n, size_type n) {
+            size_t old_bytes = old_n * sizeof(T), bytes = n * sizeof(T);
+
+            if (old_bytes < Threshold && bytes < Threshold) {
+                if (void *np = std::realloc(static_cast<void*>(p), bytes ? bytes : 1))
+                    return static_cast<T*>(np);
+                throw std::bad_alloc();
+            }
+            if (old_bytes >= Threshold && bytes >= Threshold)
+                return static_cast<T*>(remap(p, round(old_bytes), round(bytes)));
+
+            T *np = allocate(n);
+            std::memcpy(static_cast<void*>(np), static_cast<void*>(p),
+                        old_bytes < bytes ? old_bytes : bytes);
+            deallocate(p, old_n);
+            return np;
+        }
+
+        bool operator==(const huge_page_allocator&) const { return true; }
+        bool operator!=(const huge_page_allocator&) const { return false; }
+
+    private:
+        static size_t round(size_t bytes) {
+            return (bytes + huge_page - 1) & ~(huge_page - 1);
+        }
+
+        static void* small_allocate(size_t bytes) {
+            if (void *p = std::malloc(bytes ? bytes : 1))
+                return p;
+            throw std::bad_alloc();
+        }
+
+        /*
+         * Over-map by one huge page and trim both ends so the block
+         * starts on a 2 MB boundary; the hint may fail harmlessly.
+         */
+        static void* map(size_t bytes) {
+            void *raw = mmap(nullptr, bytes + huge_page, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED)
+                throw std::bad_alloc();
+
+            char *begin = static_cast<char*>(raw);
+            char *p = reinterpret_cast<char*>(
+                (reinterpret_cast<uintptr_t>(begin) + huge_page - 1) & ~(uintptr_t)(huge_page - 1));
+            if (p != begin)
+                munmap(begin, p - begin);
+            if (size_t tail = huge_page - (p - begin))
+                munmap(p + bytes, tail);
+            madvise(p, bytes, MADV_HUGEPAGE);
+            return p;
+        }
+
+        /*
+         * Grow or shrink in place when the address space allows it;
+         * otherwise map a fresh aligned block and move the old pages
+         * onto its start, still without copying them.
+         */
+        static void* remap(void *p, size_t old_bytes, size_t bytes) {
+            if (old_bytes == bytes)
+                return p;
+            if (mremap(p, old_bytes, bytes, 0) != MAP_FAILED) {
+                madvise(p, bytes, MADV_HUGEPAGE);
+                return p;
+            }
+            void *np = map(bytes);
+            if (mremap(p, old_bytes, old_bytes, MREMAP_MAYMOVE | MREMAP_FIXED, np) == MAP_FAILED) {
+                munmap(np, bytes);
+                throw std::bad_alloc();
+            }
+            return np;
+        }
+    };
+#endif
+
+    /* @class arena
+     * A monotonic bump-pointer arena. Memory is carved out of large
+     * chunks and individual frees are ignored (except for the most
+     * recent block, which can be given back or grown in place).
+     * release() drops everything at once and keeps the largest chunk
+     * for the next batch, so a steady workload stops calling malloc()
+     * after its first batch. An arena is not thread-safe; give each
+     * thread its own, e.g. a thread_local one.
+     */
+    class arena {
+    public:
+        explicit arena(size_t chunk_size = 64 * 1024)
+        : head(nullptr), cur(nullptr), last(nullptr), top(nullptr),
+          next_size(chunk_size), total(0) {}
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+        ~arena() { free_chunks(head); }
+
+        void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+        void deallocate(void *p, size_t bytes);
+        void* reallocate(void *p, size_t old_bytes, size_t new_bytes,
+                         size_t align = alignof(std::max_align_t));
+        void release(void);
+
+        // bytes handed out since the last release().
+        size_t used(void) const { return total; }
+
+    private:
+        struct chunk {
+            chunk     *next;
+            size_t    size;     // usable bytes after the header.
+        };
+
+        static char* align_up(char *p, size_t align) {
+            uintptr_t v = reinterpret_cast<uintptr_t>(p);
+            return reinterpret_cast<char*>((v + align - 1) & ~(uintptr_t)(align - 1));
+        }
+        static char* chunk_begin(chunk *c) { return reinterpret_cast<char*>(c + 1); }
+        static void free_chunks(chunk *c);
+        void new_chunk(size_t bytes, size_t align);
+
+    private:
+        chunk     *head;        // most recent (and largest) chunk first.
+        char      *cur;         // next free byte in head.
+        char      *last;        // end of head.
+        char      *top;         // start of the most recent block.
+        size_t    next_size;
+        size_t    total;
+    };
+
+    inline void
+    arena::free_chunks(chunk *c) {
+        while (c) {
+            chunk *next = c->next;
+            std::free(c);
+            c = next;
+        }
+    }
+
+    inline void
+    arena::new_chunk(size_t bytes, size_t align) {
+        size_t size = next_size;
+
+        while (size < bytes + align)
+            size *= 2;
+        chunk *c = static_cast<chunk*>(std::malloc(sizeof(chunk) + size));
+        if (c == nullptr)
+            throw std::bad_alloc();
+        c->next = head;
+        c->size = size;
+        head = c;
+        cur = chunk_begin(c);
+        last = cur + size;
+        next_size = size * 2;
+    }
+
+    inline void*
+    arena::allocate(size_t bytes, size_t align) {
+        char *p = cur ? align_up(cur, align) : nullptr;
+
+        // aligning can step past the end of the chunk.
+        if (p == nullptr || p > last || bytes > static_cast<size_t>(last - p)) {
+            new_chunk(bytes, align);
+            p = align_up(cur, align);
+        }
+        cur = p + bytes;
+        top = p;
+        total += bytes;
+        return p;
+    }
+
+    inline void
+    arena::deallocate(void *p, size_t bytes) {
+        if (p != nullptr && p == top) {
+            cur = top;
+            top = nullptr;
+            total -= bytes;
+        }
+    }
+
+    inline void*
+    arena::reallocate(void *p, size_t old_bytes, size_t new_bytes, size_t align) {
+        if (p != nullptr && p == top && top <= last &&
+            new_bytes <= static_cast<size_t>(last - top)) {
+            cur = top + new_bytes;
+            total += new_bytes - old_bytes;
+            return p;
+        }
+        void *np = allocate(new_bytes, align);
+        if (p != nullptr)
+            std::memcpy(np, p, old_bytes < new_bytes ? old_bytes : new_bytes);
+        return np;
+    }
+
+    /*
+     * Keep only the newest chunk, which is also the largest, and
+     * rewind into it. With a single chunk this is O(1).
+     */
+    inline void
+    arena::release(void) {
+        if (head == nullptr)
+            return;
+        free_chunks(head->next);
+        head->next = nullptr;
+        cur = chunk_begin(head);
+        last = cur + head->size;
+        top = nullptr;
+        total = 0;
+    }
+
+    /* @class arena_allocator
+     * Allocator handle that draws from a my::arena; copies share
+     * the arena. The arena must outlive every container using it.
+     */
+    template <typename T>
+    class arena_allocator {
+    public:
+        typedef T         value_type;
+        typedef size_t    size_type;
+
+        explicit arena_allocator(arena &a): ar(&a) {}
+        template <typename U>
+        arena_allocator(const arena_allocator<U> &a): ar(a.get_arena()) {}
+
+        T* allocate(size_type n) {
+            return static_cast<T*>(ar->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T *p, size_type n) { ar->deallocate(p, n * sizeof(T)); }
+
+        T* reallocate(T *p, size_type old_n, size_type n) {
+            return static_cast<T*>(ar->reallocate(p, old_n * sizeof(T),
+                                                  n * sizeof(T), alignof(T)));
+        }
+
+        arena* get_arena(void) const { return ar; }
+
+        bool operator==(const arena_allocator &a) const { return ar == a.ar; }
+        bool operator!=(const arena_allocator &a) const { return ar != a.ar; }
+
+    private:
+        arena    *ar;
+    };
+}
+
+#endif
@@ -0,0 +1,213 @@
+/*
+ * Nearest-neighbor candidate lists for tour construction.
+ */
+
+#ifndef ACO_CANDIDATES_H
+#define ACO_CANDIDATES_H
+
+#include <vector>
+#include <cmath>         // sqrt(), ceil()
+#include <algorithm>     // min(), max(), sort(), nth_element()
+#include <utility>       // pair
+#include <stdexcept>     // invalid_argument
+#include <cstdint>       // uint32_t
+#include <limits>        // numeric_limits
+
+#include "header.h"
+#include "csr_graph.h"
+#include "thread_pool.h"
+
+namespace aco {
+    /* @class CandidateLists
+     * For every vertex, up to k other vertices, nearest first, kept
+     * in one flat n x k array. A vertex with fewer than k neighbors
+     * has a shorter list.
+     */
+    class CandidateLists {
+    public:
+        typedef uint32_t    index_t;
+
+        CandidateLists(): _k(0) {}
+        CandidateLists(size_type vertices, size_type k)
+        : _k(k), _lists(vertices * k), _sizes(vertices, 0) {}
+
+        size_type vertexSize() const { return static_cast<size_type>(_sizes.size()); }
+        size_type k() const { return _k; }
+        size_type size(size_type v) const { return _sizes[v]; }
+        const index_t* list(size_type v) const { return _lists.data() + v * _k; }
+
+        // for the builders: room for k entries, and how many are used.
+        index_t* list(size_type v) { return _lists.data() + v * _k; }
+        void setSize(size_type v, size_type n) { _sizes[v] = static_cast<index_t>(n); }
+
+    private:
+        size_type                _k;
+        std::vector<index_t>     _lists;
+        std::vector<index_t>     _sizes;
+    };
+
+    /* @fn nearestCandidates
+     * The k nearest other points of every point in the plane, by
+     * Euclidean distance, ties to the smaller index. The points go
+     * into a uniform grid of about two per cell; each query looks at
+     * rings of cells around its own until the k-th nearest so far is
+     * closer than any cell outside them. Queries run in
+     * parallel on pool, in blocks of 256 points in cell order.
+     */
+    inline CandidateLists
+    nearestCandidates(const std::vector<double>& x, const std::vector<double>& y,
+                      size_type k, ThreadPool& pool) {
+        typedef std::pair<double, CandidateLists::index_t> item;
+        size_type n = static_cast<size_type>(x.size());
+
+        if (static_cast<size_type>(y.size()) != n || k < 0)
+            throw std::invalid_argument("nearestCandidates: bad coordinates or k");
+        k = std::min(k, std::max<size_type>(n - 1, 0));
+        CandidateLists lists(n, k);
+        if (n == 0 || k == 0)
+            return lists;
+
+        // cells about as wide as they are high, one row or column if the points are.
+        double x0 = *std::min_element(x.begin(), x.end()), w = *std::max_element(x.begin(), x.end()) - x0;
+        double y0 = *std::min_element(y.begin(), y.end()), h = *std::max_element(y.begin(), y.end()) - y0;
+        size_type cells = std::max<size_type>(1, n / 2), sx = 1, sy = 1;
+        if (w > 0 && h > 0) {
+            sx = static_cast<size_type>(std::ceil(std::sqrt(cells * (w / h))));
+            sx = std::max<size_type>(1, std::min(sx, cells));
+            sy = std::max<size_type>(1, cells / sx);
+        } else if (w > 0)
+            sx = cells;
+        else if (h > 0)
+            sy = cells;
+        double cw = w > 0 ? w / sx : 1, ch = h > 0 ? h / sy : 1;
+        auto cellOf = [](double v, double lo, double size, size_type count) {
+            return std::min(count - 1, static_cast<size_type>((v - lo) / size));
+        };
+
+        // the points by cell, as a counting sort.
+        std::vector<size_type> start(sx * sy + 1, 0);
+        std::vector<size_type> cell(n);
+        for (size_type i = 0; i < n; ++i) {
+            cell[i] = cellOf(y[i], y0, ch, sy) * sx + cellOf(x[i], x0, cw, sx);
+            ++start[cell[i] + 1];
+        }
+        for (size_type c = 0; c < sx * sy; ++c)
+            start[c + 1] += start[c];
+        // with their coordinates alongside, so a cell is read in one sweep.
+        std::vector<CandidateLists::index_t> points(n);
+        std::vector<double> px(n), py(n);
+        {
+            std::vector<size_type> next(start.begin(), start.end() - 1);
+            for (size_type i = 0; i < n; ++i) {
+                size_type p = next[cell[i]]++;
+                points[p] = static_cast<CandidateLists::index_t>(i);
+                px[p] = x[i];
+                py[p] = y[i];
+            }
+        }
+
+        // how far v is from the cells beyond r of its own, c, on one
+        // axis; a hair less, for the rounding of cellOf().
+        auto gap = [](double v, double lo, double size, size_type c, size_type r, size_type count) {
+            double g = std::numeric_limits<double>::infinity();
+            if (c - r > 0)
+                g = v - (lo + (c - r) * size);
+            if (c + r < count - 1)
+                g = std::min(g, lo + (c + r + 1) * size - v);
+            return g - 1e-9 * size;
+        };
+
+        // queries in cell order too, so that neighbors share cells in cache.
+        const size_type block = 256;
+        pool.parallelFor((n + block - 1) / block, [&](size_type b) {
+            std::vector<item> best;     // the nearest so far, sorted.
+            for (size_type q = b * block; q < std::min(n, (b + 1) * block); ++q) {
+                size_type i = points[q];
+                size_type cx = cell[i] % sx, cy = cell[i] / sx;
+                best.clear();
+                auto visit = [&](size_type gx, size_type gy) {
+                    size_type c = gy * sx + gx;
+                    for (size_type p = start[c]; p < start[c + 1]; ++p) {
+                        CandidateLists::index_t j = points[p];
+                        if (j == i)
+                            continue;
+                        double dx = px[p] - x[i], dy = py[p] - y[i];
+                        item it(dx * dx + dy * dy, j);
+                        size_type m = static_cast<size_type>(best.size());
+                        if (m == k && !(it < best.back()))
+                            continue;
+                        if (m < k)
+                            best.push_back(it);
+                        size_type at = m < k ? m : k - 1;
+                        for (; at > 0 && it < best[at - 1]; --at)
+                            best[at] = best[at - 1];
+                        best[at] = it;
+                    }
+                };
+                for (size_type r = 0; ; ++r) {
+                    // the cells at Chebyshev distance r from the point's own.
+                    for (size_type gy = cy - r; gy <= cy + r; ++gy) {
+                        if (gy < 0 || gy >= sy)
+                            continue;
+                        bool edge = gy == cy - r || gy == cy + r;
+                        for (size_type gx = cx - r; gx <= cx + r; gx += edge ? 1 : 2 * r) {
+                            if (gx >= 0 && gx < sx)
+                                visit(gx, gy);
+                            if (r == 0)
+                                break;
+                        }
+                    }
+                    // done when strictly closer than anything left, so that
+                    // ties beyond still go by index; or when nothing is left.
+                    double g = std::min(gap(x[i], x0, cw, cx, r, sx), gap(y[i], y0, ch, cy, r, sy));
+                    if (g == std::numeric_limits<double>::infinity() ||
+                        (static_cast<size_type>(best.size()) == k && best.back().first < g * g))
+                        break;
+                }
+                CandidateLists::index_t* out = lists.list(i);
+                for (size_t j = 0; j < best.size(); ++j)
+                    out[j] = best[j].second;
+                lists.setSize(i, best.size());
+            }
+        });
+        return lists;
+    }
+
+    /* @fn nearestCandidates
+     * The targets of the k lightest arcs out of every vertex, lightest
+     * first, ties to the smaller target; loops are left out and
+     * parallel arcs count once. For any graph, not only Euclidean
+     * ones, at O(degree) a vertex.
+     */
+    inline CandidateLists
+    nearestCandidates(const CsrGraph& graph, size_type k, ThreadPool& pool) {
+        typedef std::pair<double, CandidateLists::index_t> item;
+        size_type n = graph.vertexSize();
+
+        if (k < 0)
+            throw std::invalid_argument("nearestCandidates: bad k");
+        CandidateLists lists(n, k);
+        pool.parallelFor(n, [&](size_type v) {
+            std::vector<item> arcs;
+            // arcs come sorted by target; of parallel ones, the lightest.
+            for (CsrGraph::Arc a : graph.neighbors(v)) {
+                if (a.to == v)
+                    continue;
+                if (!arcs.empty() && arcs.back().second == a.to)
+                    arcs.back().first = std::min(arcs.back().first, a.weight);
+                else
+                    arcs.push_back(item(a.weight, a.to));
+            }
+            size_type m = std::min(k, static_cast<size_type>(arcs.size()));
+            std::nth_element(arcs.begin(), arcs.begin() + m, arcs.end());
+            std::sort(arcs.begin(), arcs.begin() + m);
+            CandidateLists::index_t* out = lists.list(v);
+            for (size_type j = 0; j < m; ++j)
+                out[j] = arcs[j].second;
+            lists.setSize(v, m);
+        });
+        return lists;
+    }
+}
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * Candidate lists for aco::Colony. First the time to build the 10
+ * nearest of 10^5 random points with the grid, against the lightest
+ * arcs of a complete graph on 5000 of them. Then a 2000-city random
+ * Euclidean TSP solved with no lists and with 10 and 20 candidates:
+ * construction ms per iteration and the best tour, averaged over a
+ * few seeds.
+ *
+ * build: g++ -std=c++14 -O2 -pthread candidates_bench.cc -o candidates_bench
+ */
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+
+#include "header.h"
+#include "graph.h"
+#include "csr_graph.h"
+#include "thread_pool.h"
+#include "candidates.h"
+#include "colony.h"
+
+typedef aco::Vertex<int>                 vertex;
+typedef std::chrono::steady_clock        clock_type;
+
+void
+points(aco::size_type n, std::vector<double>& x, std::vector<double>& y) {
+    std::mt19937_64 e(42);
+    std::uniform_real_distribution<double> coord(0, 1000);
+
+    x.resize(n);
+    y.resize(n);
+    for (aco::size_type i = 0; i < n; ++i) {
+        x[i] = coord(e);
+        y[i] = coord(e);
+    }
+}
+
+// the complete graph on the points.
+std::vector<vertex>
+cities(const std::vector<double>& x, const std::vector<double>& y) {
+    aco::size_type n = x.size();
+    std::vector<vertex> g;
+
+    for (aco::size_type i = 0; i < n; ++i)
+        g.push_back(vertex(0, i));
+    for (aco::size_type i = 0; i < n; ++i)
+        for (aco::size_type j = 0; j < n; ++j)
+            if (i != j)
+                g[i].pushNeighbor(g[j], std::hypot(x[i] - x[j], y[i] - y[j]));
+    return g;
+}
+
+double
+seconds(clock_type::time_point start) {
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+int
+main(void) {
+    aco::ThreadPool pool;
+    std::vector<double> x, y;
+
+    points(100000, x, y);
+    auto start = clock_type::now();
+    aco::CandidateLists lists = aco::nearestCandidates(x, y, 10, pool);
+    std::cout << "grid, 10^5 points, k = 10: " << std::fixed << std::setprecision(1)
+              << seconds(start) * 1e3 << " ms on " << pool.size() << " threads" << std::endl;
+
+    points(5000, x, y);
+    std::vector<vertex> g = cities(x, y);
+    aco::CsrGraph csr(g);
+    start = clock_type::now();
+    lists = aco::nearestCandidates(x, y, 10, pool);
+    double grid = seconds(start);
+    start = clock_type::now();
+    lists = aco::nearestCandidates(csr, 10, pool);
+    std::cout << "5000 points, k = 10: grid " << grid * 1e3 << " ms, lightest arcs "
+              << seconds(start) * 1e3 << " ms" << std::endl << std::endl;
+
+    const aco::size_type n = 2000, seeds = 3;
+    points(n, x, y);
+    g = cities(x, y);
+    std::cout << n << " cities" << std::endl;
+    std::cout << std::setw(12) << "candidates" << std::setw(14) << "construct ms"
+              << std::setw(12) << "update ms" << std::setw(14) << "best" << std::endl;
+    for (aco::size_type k : { 0, 10, 20 }) {
+        double construct = 0, update = 0, best = 0;
+        for (aco::size_type s = 1; s <= seeds; ++s) {
+            aco::ColonyParams p;
+            p.ants = 32;
+            p.iterations = 30;
+            p.seed = s;
+            p.candidates = k;
+            aco::Colony<int> colony(g, p);
+            aco::ColonyResult r = colony.solveTour();
+            for (const auto& it : r.iterations) {
+                construct += it.constructMs;
+                update += it.updateMs;
+            }
+            best += r.cost;
+        }
+        double runs = static_cast<double>(seeds * 30);
+        std::cout << std::setw(12) << k << std::setprecision(2) << std::setw(14) << construct / runs
+                  << std::setw(12) << update / runs << std::setprecision(1)
+                  << std::setw(14) << best / seeds << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+#include <cassert>
+
+#include "header.h"
+#include "csr_graph.h"
+#include "thread_pool.h"
+#include "candidates.h"
+
+typedef std::pair<double, aco::size_type>    item;
+
+// every point's k nearest the slow way, ties to the smaller index.
+std::vector<std::vector<aco::size_type>>
+brute(const std::vector<double>& x, const std::vector<double>& y, aco::size_type k) {
+    aco::size_type n = x.size();
+    std::vector<std::vector<aco::size_type>> lists(n);
+
+    for (aco::size_type i = 0; i < n; ++i) {
+        std::vector<item> all;
+        for (aco::size_type j = 0; j < n; ++j)
+            if (j != i)
+                all.push_back(item((x[j] - x[i]) * (x[j] - x[i]) + (y[j] - y[i]) * (y[j] - y[i]), j));
+        std::sort(all.begin(), all.end());
+        for (aco::size_type j = 0; j < std::min<aco::size_type>(k, all.size()); ++j)
+            lists[i].push_back(all[j].second);
+    }
+    return lists;
+}
+
+void
+check(const std::vector<double>& x, const std::vector<double>& y, aco::size_type k,
+      aco::ThreadPool& pool) {
+    aco::CandidateLists lists = aco::nearestCandidates(x, y, k, pool);
+    std::vector<std::vector<aco::size_type>> expect = brute(x, y, k);
+
+    assert(lists.vertexSize() == static_cast<aco::size_type>(x.size()));
+    for (aco::size_type i = 0; i < lists.vertexSize(); ++i) {
+        assert(lists.size(i) == static_cast<aco::size_type>(expect[i].size()));
+        for (aco::size_type j = 0; j < lists.size(i); ++j)
+            assert(lists.list(i)[j] == expect[i][j]);
+    }
+}
+
+// the grid search finds what the brute force does, however the points lie.
+void grid_test(void) {
+    aco::ThreadPool pool(3);
+    std::mt19937_64 e(7);
+    std::uniform_real_distribution<double> u(0, 100);
+    std::normal_distribution<double> g(0, 1);
+    std::vector<double> x, y;
+
+    for (int i = 0; i < 2000; ++i) {
+        x.push_back(u(e));
+        y.push_back(u(e));
+    }
+    check(x, y, 10, pool);
+
+    // a few tight clusters far apart, and duplicates.
+    x.clear();
+    y.clear();
+    for (int i = 0; i < 1500; ++i) {
+        double c = (i % 3) * 1000;
+        x.push_back(c + g(e));
+        y.push_back(c * 0.5 + g(e));
+    }
+    for (int i = 0; i < 100; ++i) {
+        x.push_back(x[i]);
+        y.push_back(y[i]);
+    }
+    check(x, y, 8, pool);
+
+    // integer points, full of ties.
+    x.clear();
+    y.clear();
+    for (int i = 0; i < 900; ++i) {
+        x.push_back(static_cast<double>(e() % 20));
+        y.push_back(static_cast<double>(e() % 20));
+    }
+    check(x, y, 12, pool);
+
+    // all on a line, all on one spot, and too few for k.
+    x.assign(500, 3);
+    y.clear();
+    for (int i = 0; i < 500; ++i)
+        y.push_back(u(e));
+    check(x, y, 6, pool);
+    check(y, x, 6, pool);
+    y.assign(500, 3);
+    check(x, y, 4, pool);
+    check(std::vector<double>(5, 1), std::vector<double>{ 0, 1, 2, 3, 4 }, 10, pool);
+    check(std::vector<double>(1, 1), std::vector<double>(1, 1), 3, pool);
+    check(std::vector<double>(), std::vector<double>(), 3, pool);
+
+    assert(aco::nearestCandidates(std::vector<double>(5, 1), std::vector<double>(5, 1), 10, pool).k() == 4);
+    bool threw = false;
+    try {
+        aco::nearestCandidates(std::vector<double>(2), std::vector<double>(3), 1, pool);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+// from a graph, the lightest arcs, without loops and counting parallel arcs once.
+void graph_test(void) {
+    typedef aco::CsrGraph::Link link;
+    aco::ThreadPool pool(2);
+    std::vector<link> links = { {0, 1, 5}, {0, 2, 1}, {0, 3, 3}, {0, 0, 0}, {0, 4, 3},
+                                {0, 2, 0.5}, {1, 2, 2} };
+    aco::CsrGraph g(5, links, false);
+
+    aco::CandidateLists lists = aco::nearestCandidates(g, 3, pool);
+    assert(lists.k() == 3 && lists.vertexSize() == 5);
+    assert(lists.size(0) == 3);
+    assert(lists.list(0)[0] == 2 && lists.list(0)[1] == 3 && lists.list(0)[2] == 4);
+    assert(lists.size(1) == 1 && lists.list(1)[0] == 2);
+    assert(lists.size(4) == 0);
+
+    lists = aco::nearestCandidates(g, 0, pool);
+    assert(lists.k() == 0 && lists.size(0) == 0);
+}
+
+int main(void) {
+    grid_test();
+    graph_test();
+    std::cout << "all candidates tests passed" << std::endl;
+    return 0;
+}
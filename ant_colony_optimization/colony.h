@@ -0,0 +1,405 @@
+/*
+ * An ant colony solver over a graph of aco::Vertex.
+ */
+
+#ifndef ACO_COLONY_H
+#define ACO_COLONY_H
+
+#include <vector>
+#include <limits>        // numeric_limits
+#include <chrono>
+#include <algorithm>     // upper_bound(), max()
+#include <stdexcept>     // invalid_argument
+#include <cstdint>       // uint64_t
+
+#include "header.h"
+#include "graph.h"
+#include "csr_graph.h"
+#include "pheromone.h"
+#include "candidates.h"
+#include "thread_pool.h"
+
+namespace aco {
+    /* @struct ColonyParams
+     * Settings of an Ant System run. An ant at vertex i moves to an
+     * unvisited neighbor j with probability proportional to
+     * tau(i, j)^alpha * (1 / w(i, j))^beta.
+     */
+    struct ColonyParams {
+        size_type    ants = 32;
+        size_type    iterations = 100;
+        double       alpha = 1.0;    // weight of the pheromone.
+        double       beta = 2.0;     // weight of the heuristic.
+        double       rho = 0.1;      // share of the pheromone evaporating per iteration.
+        double       q = 1.0;        // pheromone an ant lays, divided by its cost.
+        double       tau0 = 1.0;     // initial pheromone on every edge.
+        size_type    candidates = 0; // nearest neighbors tried first; 0: all of them.
+        unsigned     threads = 0;    // 0: one per hardware thread.
+        uint64_t     seed = 1;
+    };
+
+    struct IterationStats {
+        double    constructMs;      // building every ant's solution.
+        double    updateMs;         // evaporation, deposits and choice weights.
+        double    iterationCost;    // best cost of this iteration.
+        double    bestCost;         // best cost so far.
+    };
+
+    /* @struct ColonyResult
+     * The best solution, as indices into the vertex vector. A tour
+     * visits every vertex once and closes back to path[0]; a path
+     * runs from the source to the destination. The cost is infinite
+     * if no ant ever got through.
+     */
+    struct ColonyResult {
+        std::vector<size_type>         path;
+        double                         cost;
+        std::vector<IterationStats>    iterations;
+    };
+
+    /* @class Colony
+     * Ant System over the vertices and edges of an aco graph. Each
+     * iteration, every ant builds a solution on its own, in parallel
+     * over a thread pool, reading pheromone that stays fixed until
+     * all are done; the deposits are then merged, and evaporation and
+     * the next choice weights are computed in one parallel pass over
+     * the vertices. Every ant draws from its own random stream,
+     * seeded by the iteration and its number, so a run gives the
+     * same result on any number of threads.
+     *
+     * The edges are copied once into a CsrGraph, and the pheromone
+     * kept in a PheromoneMatrix: dense when at least half of all
+     * vertex pairs are arcs, sparse over the CSR arcs otherwise.
+     *
+     * With candidate lists, an ant picks among the unvisited ones of
+     * the k nearest neighbors of its vertex, and looks at all of the
+     * neighbors only when those are used up; a tour then costs about
+     * O(n * k) rather than O(n^2) on a complete graph. The lists are
+     * the k lightest arcs of each vertex (params.candidates), or
+     * given, as built from coordinates by nearestCandidates(). They
+     * are meant for tours: on a path, short lists steer the ants by
+     * weight alone and can keep them from the destination.
+     *
+     * Edges are directed as stored in the vertices; an undirected
+     * edge is stored at both ends and its two directions share
+     * their deposits. solve*() leaves the best solution marked on
+     * the vertices: SELECTED, with the parent set to the id of the
+     * vertex before it.
+     */
+    template <class O>
+    class Colony {
+    public:
+        typedef Vertex<O>    vertex_t;
+
+        Colony(std::vector<vertex_t>& vertices, const ColonyParams& params = ColonyParams());
+        // with these candidate lists, whatever params.candidates says.
+        Colony(std::vector<vertex_t>& vertices, const CandidateLists& candidates,
+               const ColonyParams& params = ColonyParams());
+
+        // a closed tour through every vertex, as in the TSP.
+        ColonyResult solveTour();
+        // a path from the SOURCE vertex to the DESTINATION vertex.
+        ColonyResult solvePath();
+
+        const ColonyParams& params() const { return _params; }
+        unsigned threads() const { return _pool.size(); }
+
+    private:
+        struct Ant {
+            std::vector<size_type>    path;
+            std::vector<size_type>    steps;      // arc taken out of path[i], by graph index.
+            std::vector<uint8_t>      visited;
+            std::vector<double>       cumulative;
+            double                    cost;
+        };
+
+        /* @struct Random
+         * splitmix64; cheap to seed afresh for every ant.
+         */
+        struct Random {
+            uint64_t    x;
+            explicit Random(uint64_t seed): x(seed) {}
+            uint64_t next() {
+                uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+                return z ^ (z >> 31);
+            }
+            double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+        };
+
+        void setCandidates(const CandidateLists& candidates);
+        ColonyResult solve(bool tour, size_type source, size_type destination);
+        void construct(Ant& ant, bool tour, size_type source, size_type destination,
+                       Random& rng) const;
+        size_type pick(Ant& ant, size_type cur, Random& rng) const;
+        void updatePheromone();
+        void markPath(const ColonyResult& result, bool tour);
+
+    private:
+        std::vector<vertex_t>&    _vertices;
+        ColonyParams              _params;
+        size_type                 _n;
+        CsrGraph                  _graph;
+        PheromoneMatrix           _pheromone;
+        std::vector<size_type>    _reverse;   // per arc of _graph, the arc back or -1.
+        size_type                 _k;
+        std::vector<size_type>    _candidates;    // k arcs per vertex, nearest first; -1 pads.
+        ThreadPool                _pool;
+    };
+
+    template <class O>
+    Colony<O>::Colony(std::vector<vertex_t>& vertices, const ColonyParams& params)
+    : _vertices(vertices), _params(params), _n(static_cast<size_type>(vertices.size())),
+      _graph(vertices),
+      _pheromone(_graph, 2 * _graph.arcSize() >= _n * _n ? PheromoneLayout::DENSE
+                                                        : PheromoneLayout::SPARSE,
+                 params.tau0, params.beta),
+      _k(0), _pool(params.threads) {
+        if (_n == 0 || _params.ants <= 0 || _params.iterations < 0)
+            throw std::invalid_argument("Colony: empty graph or no ants");
+        if (!(_params.rho > 0 && _params.rho < 1))
+            throw std::invalid_argument("Colony: rho must be in (0, 1)");
+
+        _reverse.resize(_graph.arcSize());
+        for (size_type i = 0; i < _n; ++i)
+            for (size_type a = _graph.offset(i); a < _graph.offset(i + 1); ++a)
+                _reverse[a] = _graph.findArc(_graph.target(a), i);
+        _pheromone.updateChoice(_params.alpha);
+        if (_params.candidates > 0)
+            setCandidates(nearestCandidates(_graph, _params.candidates, _pool));
+    }
+
+    template <class O>
+    Colony<O>::Colony(std::vector<vertex_t>& vertices, const CandidateLists& candidates,
+                      const ColonyParams& params)
+    : Colony(vertices, [&params] { ColonyParams p = params; p.candidates = 0; return p; }()) {
+        if (candidates.vertexSize() != _n)
+            throw std::invalid_argument("Colony: candidate lists for another graph");
+        _params.candidates = candidates.k();
+        setCandidates(candidates);
+    }
+
+    /*
+     * The lists as arc indices, so that a step finds its weight and
+     * pheromone directly; candidates with no arc to them are dropped.
+     */
+    template <class O>
+    void
+    Colony<O>::setCandidates(const CandidateLists& candidates) {
+        _k = candidates.k();
+        _candidates.assign(_n * _k, -1);
+        _pool.parallelFor(_n, [&](size_type i) {
+            size_type* out = _candidates.data() + i * _k;
+            const CandidateLists::index_t* list = candidates.list(i);
+            for (size_type j = 0; j < candidates.size(i); ++j) {
+                size_type a = list[j] < _n ? _graph.findArc(i, list[j]) : -1;
+                if (a >= 0)
+                    *out++ = a;
+            }
+        });
+    }
+
+    /*
+     * Evaporation, the queued deposits and the new choice weights, in
+     * blocks of rows of about 16K table entries spread over the pool.
+     */
+    template <class O>
+    void
+    Colony<O>::updatePheromone() {
+        size_type rows = std::max<size_type>(1, 16384 * _n / std::max<size_type>(1, _pheromone.entries()));
+        size_type blocks = (_n + rows - 1) / rows;
+
+        _pool.parallelFor(blocks, [&](size_type b) {
+            _pheromone.update(_params.rho, _params.alpha, b * rows, std::min(_n, (b + 1) * rows));
+        });
+    }
+
+    /*
+     * One roulette-wheel step over the unvisited neighbors of cur:
+     * prefix sums of their choice weights, then a binary search for a
+     * uniform draw below the total; if rounding lands the draw on the
+     * total, the last unvisited one. The unvisited candidates go first;
+     * the whole row only when there are none. Gives the arc taken, or
+     * -1 with nowhere left to go.
+     */
+    template <class O>
+    size_type
+    Colony<O>::pick(Ant& ant, size_type cur, Random& rng) const {
+        std::vector<double>& cumulative = ant.cumulative;
+        double sum = 0;
+
+        if (_k > 0) {
+            const size_type* arcs = _candidates.data() + cur * _k;
+            size_type m = 0;
+            cumulative.resize(_k);
+            for (; m < _k && arcs[m] >= 0; ++m) {
+                size_type to = _graph.target(arcs[m]);
+                if (!ant.visited[to])
+                    sum += _pheromone.choice()[_pheromone.entry(cur, to, arcs[m])];
+                cumulative[m] = sum;
+            }
+            if (sum > 0) {
+                double r = rng.uniform() * sum;
+                size_type k = std::upper_bound(cumulative.begin(), cumulative.begin() + m, r) -
+                              cumulative.begin();
+                while (k == m || ant.visited[_graph.target(arcs[k])])
+                    --k;
+                return arcs[k];
+            }
+        }
+
+        CsrGraph::Neighbors arcs = _graph.neighbors(cur);
+        const double* choice = _pheromone.choice() + _pheromone.rowStart(cur);
+        bool dense = _pheromone.layout() == PheromoneLayout::DENSE;
+
+        cumulative.resize(arcs.size());
+        for (size_type k = 0; k < arcs.size(); ++k) {
+            size_type to = arcs.targets()[k];
+            if (!ant.visited[to])
+                sum += choice[dense ? to : k];
+            cumulative[k] = sum;
+        }
+        if (!(sum > 0))
+            return -1;
+        double r = rng.uniform() * sum;
+        size_type k = std::upper_bound(cumulative.begin(), cumulative.end(), r) - cumulative.begin();
+        while (k == arcs.size() || ant.visited[arcs.targets()[k]])
+            --k;
+        return _graph.offset(cur) + k;
+    }
+
+    /*
+     * Steps from the start until every vertex, or the destination, is
+     * reached. An ant with nowhere left to go fails.
+     */
+    template <class O>
+    void
+    Colony<O>::construct(Ant& ant, bool tour, size_type source, size_type destination,
+                         Random& rng) const {
+        const double inf = std::numeric_limits<double>::infinity();
+        size_type cur = tour ? static_cast<size_type>(rng.next() % _n) : source;
+
+        ant.visited.assign(_n, 0);
+        ant.path.clear();
+        ant.steps.clear();
+        ant.cost = 0;
+        ant.visited[cur] = 1;
+        ant.path.push_back(cur);
+
+        while (tour ? static_cast<size_type>(ant.path.size()) < _n : cur != destination) {
+            size_type a = pick(ant, cur, rng);
+            if (a < 0) {
+                ant.cost = inf;
+                return;
+            }
+            ant.steps.push_back(a);
+            ant.cost += _graph.weight(a);
+            cur = _graph.target(a);
+            ant.visited[cur] = 1;
+            ant.path.push_back(cur);
+        }
+
+        if (tour) {
+            size_type a = _graph.findArc(cur, ant.path[0]);
+            if (a < 0) {
+                ant.cost = inf;
+                return;
+            }
+            ant.steps.push_back(a);
+            ant.cost += _graph.weight(a);
+        }
+    }
+
+    template <class O>
+    ColonyResult
+    Colony<O>::solve(bool tour, size_type source, size_type destination) {
+        typedef std::chrono::steady_clock clock;
+        const double inf = std::numeric_limits<double>::infinity();
+        std::vector<Ant> ants(_params.ants);
+        ColonyResult result;
+
+        result.cost = inf;
+        for (size_type it = 0; it < _params.iterations; ++it) {
+            auto start = clock::now();
+            _pool.parallelFor(_params.ants, [&](size_type a) {
+                Random rng(_params.seed ^ (static_cast<uint64_t>(it) * _params.ants + a) *
+                           0xd1b54a32d192ed03ull);
+                construct(ants[a], tour, source, destination, rng);
+            });
+            auto built = clock::now();
+
+            IterationStats stats;
+            stats.iterationCost = inf;
+            for (const Ant& ant : ants) {
+                stats.iterationCost = std::min(stats.iterationCost, ant.cost);
+                if (ant.cost < result.cost) {
+                    result.cost = ant.cost;
+                    result.path = ant.path;
+                }
+            }
+
+            for (const Ant& ant : ants) {
+                if (ant.cost == inf)
+                    continue;
+                double d = _params.q / std::max(ant.cost, 1e-12);
+                for (size_t s = 0; s < ant.steps.size(); ++s) {
+                    size_type a = ant.steps[s], from = ant.path[s], to = _graph.target(a);
+                    _pheromone.deposit(_pheromone.entry(from, to, a), d);
+                    if (_reverse[a] >= 0)
+                        _pheromone.deposit(_pheromone.entry(to, from, _reverse[a]), d);
+                }
+            }
+            updatePheromone();
+            auto updated = clock::now();
+
+            stats.constructMs = std::chrono::duration<double, std::milli>(built - start).count();
+            stats.updateMs = std::chrono::duration<double, std::milli>(updated - built).count();
+            stats.bestCost = result.cost;
+            result.iterations.push_back(stats);
+        }
+        markPath(result, tour);
+        return result;
+    }
+
+    template <class O>
+    void
+    Colony<O>::markPath(const ColonyResult& result, bool tour) {
+        for (auto& v : _vertices) {
+            v.setStatus(VertexStatus::UNSELECTED);
+            v.setParent(-1);
+        }
+        const std::vector<size_type>& p = result.path;
+        for (size_t i = 0; i < p.size(); ++i) {
+            _vertices[p[i]].setStatus(VertexStatus::SELECTED);
+            if (i > 0)
+                _vertices[p[i]].setParent(_vertices[p[i - 1]].id());
+        }
+        if (tour && !p.empty())
+            _vertices[p[0]].setParent(_vertices[p.back()].id());
+    }
+
+    template <class O>
+    ColonyResult
+    Colony<O>::solveTour() {
+        return solve(true, -1, -1);
+    }
+
+    template <class O>
+    ColonyResult
+    Colony<O>::solvePath() {
+        size_type source = -1, destination = -1;
+
+        for (size_type i = 0; i < _n; ++i) {
+            if (_vertices[i].type() == VertexType::SOURCE && source < 0)
+                source = i;
+            else if (_vertices[i].type() == VertexType::DESTINATION && destination < 0)
+                destination = i;
+        }
+        if (source < 0 || destination < 0)
+            throw std::invalid_argument("Colony: no SOURCE or no DESTINATION vertex");
+        return solve(false, source, destination);
+    }
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * Time per iteration of aco::Colony on a 1000-city random Euclidean
+ * TSP (a complete graph), from one thread up to one per hardware
+ * thread, split into tour construction and the pheromone update.
+ * The runs share a seed, so every thread count finds the same tour.
+ *
+ * build: g++ -std=c++14 -O2 -pthread colony_bench.cc -o colony_bench
+ */
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <thread>
+#include <cmath>
+#include <algorithm>
+
+#include "header.h"
+#include "graph.h"
+#include "colony.h"
+
+typedef aco::Vertex<int>    vertex;
+
+std::vector<vertex>
+cities(aco::size_type n) {
+    std::mt19937_64 e(42);
+    std::uniform_real_distribution<double> coord(0, 1000);
+    std::vector<double> x(n), y(n);
+    std::vector<vertex> g;
+
+    for (aco::size_type i = 0; i < n; ++i) {
+        x[i] = coord(e);
+        y[i] = coord(e);
+        g.push_back(vertex(0, i));
+    }
+    for (aco::size_type i = 0; i < n; ++i)
+        for (aco::size_type j = 0; j < n; ++j)
+            if (i != j)
+                g[i].pushNeighbor(g[j], std::hypot(x[i] - x[j], y[i] - y[j]));
+    return g;
+}
+
+int
+main(void) {
+    const aco::size_type n = 1000;
+    std::vector<vertex> g = cities(n);
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    double base = 0;
+
+    std::cout << "hardware threads: " << hw << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "construct ms"
+              << std::setw(12) << "update ms" << std::setw(10) << "speedup"
+              << std::setw(14) << "best" << std::endl;
+    std::vector<unsigned> counts;
+    for (unsigned t = 1; t < hw; t *= 2)
+        counts.push_back(t);
+    counts.push_back(hw);
+
+    for (unsigned t : counts) {
+        aco::ColonyParams p;
+        p.ants = 64;
+        p.iterations = 10;
+        p.threads = t;
+        aco::Colony<int> colony(g, p);
+        aco::ColonyResult r = colony.solveTour();
+
+        double construct = 0, update = 0;
+        for (const auto& s : r.iterations) {
+            construct += s.constructMs;
+            update += s.updateMs;
+        }
+        construct /= r.iterations.size();
+        update /= r.iterations.size();
+        if (t == 1)
+            base = construct + update;
+        std::cout << std::setw(8) << t << std::fixed << std::setprecision(2)
+                  << std::setw(14) << construct << std::setw(12) << update
+                  << std::setw(10) << base / (construct + update)
+                  << std::setw(14) << r.cost << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,227 @@
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <cmath>
+#include <cassert>
+
+#include "header.h"
+#include "graph.h"
+#include "colony.h"
+
+typedef aco::Vertex<int>    vertex;
+
+// undirected edge between vertices a and b.
+void
+connect(std::vector<vertex>& g, aco::size_type a, aco::size_type b, double w) {
+    g[a].pushNeighbor(g[b], w);
+    g[b].pushNeighbor(g[a], w);
+}
+
+// n cities evenly spaced on the unit circle, all connected.
+std::vector<vertex>
+circle(aco::size_type n) {
+    const double pi = std::acos(-1.0);
+    std::vector<vertex> g;
+
+    for (aco::size_type i = 0; i < n; ++i)
+        g.push_back(vertex(0, i));
+    for (aco::size_type i = 0; i < n; ++i)
+        for (aco::size_type j = i + 1; j < n; ++j) {
+            double dx = std::cos(2 * pi * i / n) - std::cos(2 * pi * j / n);
+            double dy = std::sin(2 * pi * i / n) - std::sin(2 * pi * j / n);
+            connect(g, i, j, std::sqrt(dx * dx + dy * dy));
+        }
+    return g;
+}
+
+// a side x side grid with 4-neighbor edges of pseudo-random weights.
+std::vector<vertex>
+grid(aco::size_type side) {
+    std::vector<vertex> g;
+
+    for (aco::size_type i = 0; i < side * side; ++i)
+        g.push_back(vertex(0, i));
+    for (aco::size_type r = 0; r < side; ++r)
+        for (aco::size_type c = 0; c < side; ++c) {
+            aco::size_type v = r * side + c;
+            if (c + 1 < side)
+                connect(g, v, v + 1, 1 + (v * 7 + 3) % 5);
+            if (r + 1 < side)
+                connect(g, v, v + side, 1 + (v * 11 + 5) % 5);
+        }
+    g.front().setType(aco::VertexType::SOURCE);
+    g.back().setType(aco::VertexType::DESTINATION);
+    return g;
+}
+
+double
+dijkstra(const std::vector<vertex>& g, aco::size_type from, aco::size_type to) {
+    typedef std::pair<double, aco::size_type> item;
+    std::vector<double> dist(g.size(), 1e300);
+    std::priority_queue<item, std::vector<item>, std::greater<item>> q;
+
+    dist[from] = 0;
+    q.push(item(0, from));
+    while (!q.empty()) {
+        item t = q.top();
+        q.pop();
+        if (t.first > dist[t.second])
+            continue;
+        for (const auto& e : g[t.second].neighbors()) {
+            aco::size_type u = e.end() - g.data();
+            if (t.first + e.weight() < dist[u]) {
+                dist[u] = t.first + e.weight();
+                q.push(item(dist[u], u));
+            }
+        }
+    }
+    return dist[to];
+}
+
+void tour_test(void) {
+    const aco::size_type n = 12;
+    const double pi = std::acos(-1.0);
+    std::vector<vertex> g = circle(n);
+    aco::ColonyParams p;
+    p.ants = 16;
+    p.iterations = 60;
+
+    aco::Colony<int> colony(g, p);
+    aco::ColonyResult r = colony.solveTour();
+
+    // the optimum goes round the circle.
+    assert(std::fabs(r.cost - 2 * n * std::sin(pi / n)) < 1e-9);
+    assert(r.path.size() == static_cast<size_t>(n));
+    assert(r.iterations.size() == static_cast<size_t>(p.iterations));
+    for (size_t i = 1; i < r.iterations.size(); ++i)
+        assert(r.iterations[i].bestCost <= r.iterations[i - 1].bestCost);
+
+    // every city selected once, parents following the tour.
+    for (size_t i = 0; i < r.path.size(); ++i) {
+        const vertex& v = g[r.path[i]];
+        assert(v.status() == aco::VertexStatus::SELECTED);
+        assert(v.parent() == g[r.path[(i + n - 1) % n]].id());
+    }
+}
+
+void path_test(void) {
+    std::vector<vertex> g = grid(6);
+    aco::ColonyParams p;
+    p.ants = 32;
+    p.iterations = 150;
+
+    aco::Colony<int> colony(g, p);
+    aco::ColonyResult r = colony.solvePath();
+
+    assert(r.cost == dijkstra(g, 0, g.size() - 1));
+    assert(r.path.front() == 0);
+    assert(r.path.back() == static_cast<aco::size_type>(g.size() - 1));
+    for (size_t i = 1; i < r.path.size(); ++i)
+        assert(g[r.path[i]].parent() == g[r.path[i - 1]].id());
+
+    // without a destination there is nothing to solve.
+    g.back().setType(aco::VertexType::MEDIATE);
+    aco::Colony<int> lost(g, p);
+    bool threw = false;
+    try {
+        lost.solvePath();
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+// the same seed gives the same run on any number of threads.
+void determinism_test(void) {
+    std::vector<vertex> a = circle(30), b = circle(30);
+    aco::ColonyParams p;
+    p.iterations = 20;
+    p.threads = 1;
+    aco::Colony<int> one(a, p);
+    p.threads = 3;
+    aco::Colony<int> three(b, p);
+
+    assert(one.threads() == 1 && three.threads() == 3);
+    aco::ColonyResult r1 = one.solveTour(), r3 = three.solveTour();
+    assert(r1.path == r3.path);
+    assert(r1.cost == r3.cost);
+    for (size_t i = 0; i < r1.iterations.size(); ++i)
+        assert(r1.iterations[i].iterationCost == r3.iterations[i].iterationCost);
+}
+
+// a dead end that every ant must back out of fails, not hangs.
+void stuck_test(void) {
+    std::vector<vertex> g;
+    for (aco::size_type i = 0; i < 4; ++i)
+        g.push_back(vertex(0, i));
+    connect(g, 0, 1, 1);
+    connect(g, 1, 2, 1);
+    connect(g, 1, 3, 1);
+    aco::ColonyParams p;
+    p.iterations = 5;
+
+    aco::Colony<int> colony(g, p);
+    aco::ColonyResult r = colony.solveTour();
+    assert(std::isinf(r.cost));
+    assert(r.path.empty());
+    for (const auto& v : g)
+        assert(v.status() == aco::VertexStatus::UNSELECTED);
+}
+
+// with candidate lists the circle is still solved, alike on any number
+// of threads, and ants whose candidates are used up carry on.
+void candidates_test(void) {
+    const aco::size_type n = 40;
+    const double pi = std::acos(-1.0);
+    std::vector<vertex> a = circle(n), b = circle(n);
+    aco::ColonyParams p;
+    p.ants = 16;
+    p.iterations = 60;
+    p.candidates = 6;
+    p.threads = 1;
+
+    aco::Colony<int> one(a, p);
+    aco::ColonyResult r1 = one.solveTour();
+    assert(std::fabs(r1.cost - 2 * n * std::sin(pi / n)) < 1e-9);
+    p.threads = 3;
+    aco::Colony<int> three(b, p);
+    aco::ColonyResult r3 = three.solveTour();
+    assert(r1.path == r3.path && r1.cost == r3.cost);
+
+    // one candidate each: the fallback finishes every tour.
+    p.candidates = 1;
+    p.iterations = 3;
+    aco::Colony<int> narrow(a, p);
+    assert(std::isfinite(narrow.solveTour().cost));
+
+    // lists from the coordinates, as for a Euclidean instance.
+    std::vector<double> x, y;
+    for (aco::size_type i = 0; i < n; ++i) {
+        x.push_back(std::cos(2 * pi * i / n));
+        y.push_back(std::sin(2 * pi * i / n));
+    }
+    aco::ThreadPool pool(2);
+    aco::CandidateLists lists = aco::nearestCandidates(x, y, 6, pool);
+    p.iterations = 60;
+    aco::Colony<int> given(b, lists, p);
+    assert(given.params().candidates == 6);
+    assert(std::fabs(given.solveTour().cost - r1.cost) < 1e-9);
+
+    bool threw = false;
+    try {
+        aco::Colony<int> wrong(b, aco::CandidateLists(n - 1, 6), p);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main(void) {
+    tour_test();
+    path_test();
+    determinism_test();
+    stuck_test();
+    candidates_test();
+    std::cout << "all colony tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * Memory and traversal time of a 10^5-vertex graph with 10^6 random
+ * arcs, stored as aco::Vertex edge vectors and as an aco::CsrGraph.
+ * "copied" walks the vertices the way the old const neighbors() did,
+ * copying every edge list before reading it. Sweeps read every arc
+ * in vertex order, random visits the vertices in shuffled order, and
+ * bfs is a breadth-first search from vertex 0.
+ *
+ * build: g++ -std=c++14 -O2 csr_bench.cc -o csr_bench
+ */
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+#include "header.h"
+#include "graph.h"
+#include "csr_graph.h"
+
+typedef std::chrono::steady_clock    clock_type;
+typedef aco::Vertex<int>             vertex;
+
+const aco::size_type    n = 100000;
+const aco::size_type    degree = 10;
+volatile double         sink;    // keeps the walks from being optimized out.
+
+template <class F>
+double ns_per_arc(F f) {
+    auto start = clock_type::now();
+    sink = f();
+    return std::chrono::duration<double, std::nano>(clock_type::now() - start).count() /
+           (n * degree);
+}
+
+void report(const char *what, double vertices, double csr, double copied = -1) {
+    std::cout << std::setw(12) << what << std::fixed << std::setprecision(2)
+              << std::setw(12) << vertices << std::setw(12) << csr;
+    if (copied >= 0)
+        std::cout << std::setw(12) << copied;
+    std::cout << std::endl;
+}
+
+int
+main(void) {
+    std::mt19937_64 e(7);
+    std::uniform_real_distribution<double> w(1, 100);
+    std::vector<vertex> g;
+
+    for (aco::size_type i = 0; i < n; ++i)
+        g.push_back(vertex(0, i));
+    for (aco::size_type i = 0; i < n; ++i)
+        for (aco::size_type k = 0; k < degree; ++k)
+            g[i].pushNeighbor(g[e() % n], w(e));
+    const std::vector<vertex>& cg = g;
+    aco::CsrGraph csr(g);
+
+    std::vector<aco::size_type> order(n);
+    for (aco::size_type i = 0; i < n; ++i)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), e);
+
+    size_t edge_bytes = 0;
+    for (const auto& v : g)
+        edge_bytes += v.neighbors().capacity() * sizeof(aco::Edge<int>);
+    size_t vertex_bytes = edge_bytes + g.capacity() * sizeof(vertex);
+
+    std::cout << std::setw(12) << "" << std::setw(12) << "vertices" << std::setw(12) << "csr"
+              << std::setw(12) << "copied" << std::endl;
+    report("B/arc", double(edge_bytes) / (n * degree),
+           double(csr.bytes() - (n + 1) * sizeof(aco::size_type)) / csr.arcSize());
+    report("B/arc, all", double(vertex_bytes) / (n * degree), double(csr.bytes()) / csr.arcSize());
+
+    report("sweep ns",
+           ns_per_arc([&] {
+               double s = 0;
+               for (const auto& v : cg)
+                   for (const auto& a : v.neighbors())
+                       s += a.weight();
+               return s;
+           }),
+           ns_per_arc([&] {
+               double s = 0;
+               for (aco::size_type v = 0; v < n; ++v)
+                   for (aco::CsrGraph::Arc a : csr.neighbors(v))
+                       s += a.weight;
+               return s;
+           }),
+           ns_per_arc([&] {
+               double s = 0;
+               for (const auto& v : cg) {
+                   std::vector<aco::Edge<int>> copy = v.neighbors();
+                   for (const auto& a : copy)
+                       s += a.weight();
+               }
+               return s;
+           }));
+
+    report("random ns",
+           ns_per_arc([&] {
+               double s = 0;
+               for (aco::size_type v : order)
+                   for (const auto& a : cg[v].neighbors())
+                       s += a.weight() + (a.end() - cg.data());
+               return s;
+           }),
+           ns_per_arc([&] {
+               double s = 0;
+               for (aco::size_type v : order)
+                   for (aco::CsrGraph::Arc a : csr.neighbors(v))
+                       s += a.weight + a.to;
+               return s;
+           }));
+
+    std::vector<aco::size_type> queue(n);
+    std::vector<char> seen(n);
+    report("bfs ns",
+           ns_per_arc([&] {
+               std::fill(seen.begin(), seen.end(), 0);
+               aco::size_type head = 0, tail = 0;
+               queue[tail++] = 0;
+               seen[0] = 1;
+               while (head < tail)
+                   for (const auto& a : cg[queue[head++]].neighbors()) {
+                       aco::size_type u = a.end() - cg.data();
+                       if (!seen[u]) {
+                           seen[u] = 1;
+                           queue[tail++] = u;
+                       }
+                   }
+               return double(tail);
+           }),
+           ns_per_arc([&] {
+               std::fill(seen.begin(), seen.end(), 0);
+               aco::size_type head = 0, tail = 0;
+               queue[tail++] = 0;
+               seen[0] = 1;
+               while (head < tail)
+                   for (aco::CsrGraph::Arc a : csr.neighbors(queue[head++]))
+                       if (!seen[a.to]) {
+                           seen[a.to] = 1;
+                           queue[tail++] = a.to;
+                       }
+               return double(tail);
+           }));
+    return 0;
+}
@@ -0,0 +1,273 @@
+/*
+ * A graph in compressed sparse row form.
+ */
+
+#ifndef ACO_CSR_GRAPH_H
+#define ACO_CSR_GRAPH_H
+
+#include <vector>
+#include <limits>        // numeric_limits
+#include <algorithm>     // sort(), lower_bound(), is_sorted()
+#include <utility>       // pair
+#include <stdexcept>     // invalid_argument
+#include <cstdint>       // uint32_t
+
+#include "header.h"
+#include "graph.h"
+
+namespace aco {
+    /* @class CsrGraph
+     * The edges of a graph in three flat arrays, built once: the
+     * arcs out of vertex v are targets[offsets[v] .. offsets[v + 1])
+     * with the weights at the same indices. An arc costs 12 bytes
+     * (a 32-bit target and a double weight), with one offset per
+     * vertex on top, and a walk over all of them reads memory in
+     * order. Arcs out of a vertex are sorted by target, so findArc()
+     * is a binary search.
+     *
+     * An arc's index into the arrays is stable, which lets solvers
+     * keep their own per-arc data (pheromone, say) alongside.
+     */
+    class CsrGraph {
+    public:
+        typedef uint32_t    index_t;
+        typedef double      weight_t;
+
+        struct Arc {
+            index_t     to;
+            weight_t    weight;
+        };
+
+        /* @struct Link
+         * An edge for the edge-list constructor.
+         */
+        struct Link {
+            size_type    from;
+            size_type    to;
+            weight_t     weight;
+        };
+
+        /* @class Neighbors
+         * A view of the arcs out of one vertex; nothing is copied.
+         */
+        class Neighbors {
+        public:
+            class iterator {
+            public:
+                iterator(const index_t* t, const weight_t* w): _t(t), _w(w) {}
+                Arc operator*() const { return Arc{*_t, *_w}; }
+                iterator& operator++() { ++_t; ++_w; return *this; }
+                bool operator==(const iterator& it) const { return _t == it._t; }
+                bool operator!=(const iterator& it) const { return _t != it._t; }
+            private:
+                const index_t*     _t;
+                const weight_t*    _w;
+            };
+
+            Neighbors(const index_t* t, const weight_t* w, size_type n)
+            : _targets(t), _weights(w), _size(n) {}
+
+            iterator begin() const { return iterator(_targets, _weights); }
+            iterator end() const { return iterator(_targets + _size, _weights + _size); }
+            size_type size() const { return _size; }
+            bool empty() const { return _size == 0; }
+            Arc operator[](size_type i) const { return Arc{_targets[i], _weights[i]}; }
+            const index_t* targets() const { return _targets; }
+            const weight_t* weights() const { return _weights; }
+
+        private:
+            const index_t*     _targets;
+            const weight_t*    _weights;
+            size_type          _size;
+        };
+
+        CsrGraph(): _offsets(1, 0) {}
+        // the edges of vertices; edge ends must point into the vector.
+        template <class O>
+        explicit CsrGraph(const std::vector<Vertex<O>>& vertices);
+        // n vertices and the given edges, stored both ways if undirected.
+        CsrGraph(size_type n, const std::vector<Link>& links, bool undirected = true);
+
+        size_type vertexSize() const { return static_cast<size_type>(_offsets.size()) - 1; }
+        size_type arcSize() const { return static_cast<size_type>(_targets.size()); }
+        size_type degree(size_type v) const { return _offsets[v + 1] - _offsets[v]; }
+        // index of the first arc out of v; arcs out of v follow it.
+        size_type offset(size_type v) const { return _offsets[v]; }
+
+        Neighbors neighbors(size_type v) const {
+            return Neighbors(_targets.data() + _offsets[v], _weights.data() + _offsets[v], degree(v));
+        }
+        index_t target(size_type arc) const { return _targets[arc]; }
+        weight_t weight(size_type arc) const { return _weights[arc]; }
+
+        /* @fn findArc
+         * Index of an arc from u to v, or -1 if there is none.
+         */
+        size_type findArc(size_type u, size_type v) const;
+
+        // memory held by the three arrays.
+        size_t bytes() const {
+            return _offsets.capacity() * sizeof(size_type) +
+                   _targets.capacity() * sizeof(index_t) +
+                   _weights.capacity() * sizeof(weight_t);
+        }
+
+    private:
+        static size_type checkedSize(size_type n);
+        void sortRows();
+
+    private:
+        std::vector<size_type>    _offsets;
+        std::vector<index_t>      _targets;
+        std::vector<weight_t>     _weights;
+    };
+
+    /*
+     * n itself if targets can hold it; run in the mem-initializers, so
+     * that a bad n is refused before the offsets are allocated.
+     */
+    inline size_type
+    CsrGraph::checkedSize(size_type n) {
+        if (n < 0 || static_cast<uint64_t>(n) > std::numeric_limits<index_t>::max())
+            throw std::invalid_argument("CsrGraph: too many vertices");
+        return n;
+    }
+
+    template <class O>
+    CsrGraph::CsrGraph(const std::vector<Vertex<O>>& vertices)
+    : _offsets(checkedSize(static_cast<size_type>(vertices.size())) + 1, 0) {
+        size_type n = static_cast<size_type>(vertices.size());
+
+        for (size_type v = 0; v < n; ++v)
+            _offsets[v + 1] = _offsets[v] + vertices[v].neighborSize();
+        _targets.reserve(_offsets[n]);
+        _weights.reserve(_offsets[n]);
+        for (const auto& vertex : vertices)
+            for (const auto& e : vertex.neighbors()) {
+                size_type to = e.end() - vertices.data();
+                if (to < 0 || to >= n)
+                    throw std::invalid_argument("CsrGraph: edge to a vertex outside the graph");
+                _targets.push_back(static_cast<index_t>(to));
+                _weights.push_back(e.weight());
+            }
+        sortRows();
+    }
+
+    /*
+     * A counting sort by source: count the degrees, turn them into
+     * offsets, then drop every arc into the next free slot of its row.
+     *
+     * In a big graph the rows are far apart and each arc dropped in
+     * is a cache miss, twice over with the weights in their own
+     * array. There the arcs first go into blocks of 1024 consecutive
+     * sources, each block filled in order, and then every block,
+     * whose rows now sit close together, is dropped into place. That
+     * costs 16 bytes an arc for the staging, for the time it takes.
+     */
+    inline
+    CsrGraph::CsrGraph(size_type n, const std::vector<Link>& links, bool undirected)
+    : _offsets(checkedSize(n) + 1, 0) {
+        struct Staged {
+            index_t     from;
+            index_t     to;
+            weight_t    weight;
+        };
+        const int shift = 10;
+
+        for (const Link& l : links) {
+            if (l.from < 0 || l.from >= n || l.to < 0 || l.to >= n)
+                throw std::invalid_argument("CsrGraph: edge to a vertex outside the graph");
+            ++_offsets[l.from + 1];
+            if (undirected)
+                ++_offsets[l.to + 1];
+        }
+        for (size_type v = 0; v < n; ++v)
+            _offsets[v + 1] += _offsets[v];
+        _targets.resize(_offsets[n]);
+        _weights.resize(_offsets[n]);
+
+        std::vector<size_type> next(_offsets.begin(), _offsets.end() - 1);
+        auto place = [&](size_type from, size_type to, weight_t w) {
+            size_type a = next[from]++;
+            _targets[a] = static_cast<index_t>(to);
+            _weights[a] = w;
+        };
+        if (_offsets[n] < (size_type(1) << 22) || n <= (size_type(1) << shift)) {
+            for (const Link& l : links) {
+                place(l.from, l.to, l.weight);
+                if (undirected)
+                    place(l.to, l.from, l.weight);
+            }
+        } else {
+            std::vector<size_type> fill((n >> shift) + 1);
+            for (size_type b = 0; b < static_cast<size_type>(fill.size()); ++b)
+                fill[b] = _offsets[std::min(n, b << shift)];
+            std::vector<Staged> staged(_offsets[n]);
+            for (const Link& l : links) {
+                index_t from = static_cast<index_t>(l.from), to = static_cast<index_t>(l.to);
+                staged[fill[from >> shift]++] = Staged{from, to, l.weight};
+                if (undirected)
+                    staged[fill[to >> shift]++] = Staged{to, from, l.weight};
+            }
+            for (const Staged& a : staged)
+                place(a.from, a.to, a.weight);
+        }
+        sortRows();
+    }
+
+    /*
+     * Rows are sorted stably, so parallel arcs keep their input order.
+     * Short rows, the common case, get an insertion sort in place;
+     * longer ones are sorted by (target, position) through a buffer.
+     */
+    inline void
+    CsrGraph::sortRows() {
+        std::vector<std::pair<index_t, size_type>> row;
+        std::vector<weight_t> weights;
+
+        for (size_type v = 0; v < vertexSize(); ++v) {
+            index_t* t = _targets.data() + _offsets[v];
+            weight_t* w = _weights.data() + _offsets[v];
+            size_type n = degree(v);
+            if (std::is_sorted(t, t + n))
+                continue;
+
+            if (n <= 32) {
+                for (size_type i = 1; i < n; ++i) {
+                    index_t ti = t[i];
+                    weight_t wi = w[i];
+                    size_type j = i;
+                    for ( ; j > 0 && t[j - 1] > ti; --j) {
+                        t[j] = t[j - 1];
+                        w[j] = w[j - 1];
+                    }
+                    t[j] = ti;
+                    w[j] = wi;
+                }
+                continue;
+            }
+            row.clear();
+            for (size_type i = 0; i < n; ++i)
+                row.push_back(std::make_pair(t[i], i));
+            std::sort(row.begin(), row.end());
+            weights.assign(w, w + n);
+            for (size_type i = 0; i < n; ++i) {
+                t[i] = row[i].first;
+                w[i] = weights[row[i].second];
+            }
+        }
+    }
+
+    inline size_type
+    CsrGraph::findArc(size_type u, size_type v) const {
+        const index_t* first = _targets.data() + _offsets[u];
+        const index_t* last = _targets.data() + _offsets[u + 1];
+        const index_t* it = std::lower_bound(first, last, static_cast<index_t>(v));
+
+        if (it == last || *it != static_cast<index_t>(v))
+            return -1;
+        return it - _targets.data();
+    }
+}
+
+#endif
@@ -0,0 +1,152 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+
+#include "header.h"
+#include "graph.h"
+#include "csr_graph.h"
+
+typedef aco::Vertex<int>    vertex;
+
+// the arcs of one vertex in a CsrGraph match its edge list.
+void vertex_test(void) {
+    std::vector<vertex> g;
+    for (aco::size_type i = 0; i < 5; ++i)
+        g.push_back(vertex(0, i));
+    g[0].pushNeighbor(g[3], 3.5);
+    g[0].pushNeighbor(g[1], 1.5);
+    g[0].pushNeighbor(g[4], 4.5);
+    g[2].pushNeighbor(g[0], 0.25);
+    g[4].pushNeighbor(g[4], 9);
+
+    aco::CsrGraph csr(g);
+    assert(csr.vertexSize() == 5);
+    assert(csr.arcSize() == 5);
+    assert(csr.degree(0) == 3 && csr.degree(1) == 0 && csr.degree(4) == 1);
+
+    // sorted by target, weights following.
+    aco::CsrGraph::Neighbors n = csr.neighbors(0);
+    aco::CsrGraph::index_t targets[] = { 1, 3, 4 };
+    double weights[] = { 1.5, 3.5, 4.5 };
+    int i = 0;
+    for (aco::CsrGraph::Arc a : n) {
+        assert(a.to == targets[i] && a.weight == weights[i]);
+        ++i;
+    }
+    assert(i == 3);
+    assert(n[1].to == 3 && n.weights()[2] == 4.5);
+    assert(csr.neighbors(1).empty());
+
+    assert(csr.findArc(0, 3) == csr.offset(0) + 1);
+    assert(csr.weight(csr.findArc(2, 0)) == 0.25);
+    assert(csr.findArc(0, 2) == -1);
+    assert(csr.findArc(1, 0) == -1);
+    assert(csr.findArc(4, 4) >= 0);
+
+    // an edge out of the vector is refused.
+    vertex stray(0, 9);
+    g[1].pushNeighbor(stray, 1);
+    bool threw = false;
+    try {
+        aco::CsrGraph bad(g);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void link_test(void) {
+    typedef aco::CsrGraph::Link link;
+    std::vector<link> links = { {0, 1, 1}, {2, 1, 2}, {3, 0, 3}, {1, 3, 4} };
+
+    aco::CsrGraph directed(4, links, false);
+    assert(directed.arcSize() == 4);
+    assert(directed.findArc(2, 1) >= 0 && directed.findArc(1, 2) == -1);
+
+    aco::CsrGraph undirected(4, links);
+    assert(undirected.arcSize() == 8);
+    assert(undirected.degree(1) == 3);
+    for (const link& l : links) {
+        aco::size_type a = undirected.findArc(l.from, l.to);
+        aco::size_type b = undirected.findArc(l.to, l.from);
+        assert(a >= 0 && b >= 0);
+        assert(undirected.weight(a) == l.weight && undirected.weight(b) == l.weight);
+    }
+    aco::CsrGraph::Neighbors n = undirected.neighbors(1);
+    assert(n[0].to == 0 && n[1].to == 2 && n[2].to == 3);
+
+    // 12 bytes an arc, plus an offset per vertex.
+    assert(undirected.bytes() == 5 * sizeof(aco::size_type) + 8 * 12);
+
+    aco::CsrGraph empty;
+    assert(empty.vertexSize() == 0 && empty.arcSize() == 0);
+
+    bool threw = false;
+    try {
+        aco::CsrGraph bad(2, links);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // a vertex count out of range is refused before anything is allocated.
+    aco::size_type sizes[] = { -1, -5, aco::size_type(1) << 40 };
+    for (aco::size_type n : sizes) {
+        threw = false;
+        try {
+            aco::CsrGraph bad(n, std::vector<link>());
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+}
+
+// a graph big enough to be staged in blocks comes out the same.
+void staged_test(void) {
+    typedef aco::CsrGraph::Link link;
+    const aco::size_type n = 5000;
+    std::mt19937_64 e(9);
+    std::vector<link> links;
+    std::vector<std::vector<std::pair<aco::size_type, double>>> rows(n);
+
+    for (int i = 0; i < (1 << 21) + 1000; ++i) {
+        link l = { static_cast<aco::size_type>(e() % n), static_cast<aco::size_type>(e() % n),
+                   static_cast<double>(i) };
+        links.push_back(l);
+        rows[l.from].push_back(std::make_pair(l.to, l.weight));
+        rows[l.to].push_back(std::make_pair(l.from, l.weight));
+    }
+    aco::CsrGraph g(n, links);
+    assert(g.arcSize() >= (1 << 22));
+    for (aco::size_type v = 0; v < n; ++v) {
+        // in input order among equal targets.
+        std::stable_sort(rows[v].begin(), rows[v].end(),
+                         [](const std::pair<aco::size_type, double>& x,
+                            const std::pair<aco::size_type, double>& y) { return x.first < y.first; });
+        aco::CsrGraph::Neighbors nb = g.neighbors(v);
+        assert(nb.size() == static_cast<aco::size_type>(rows[v].size()));
+        for (aco::size_type k = 0; k < nb.size(); ++k)
+            assert(nb[k].to == rows[v][k].first && nb[k].weight == rows[v][k].second);
+    }
+}
+
+// reading the edges of a const vertex no longer copies them.
+void const_neighbors_test(void) {
+    std::vector<vertex> g(2);
+    g[0].pushNeighbor(g[1], 1);
+    const vertex& v = g[0];
+    assert(&v.neighbors() == &g[0].neighbors());
+}
+
+int main(void) {
+    vertex_test();
+    link_test();
+    staged_test();
+    const_neighbors_test();
+    std::cout << "all csr graph tests passed" << std::endl;
+    return 0;
+}
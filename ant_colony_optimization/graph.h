@@ -54,21 +54,21 @@ namespace aco {
          */
         bool isSame(const Edge& e) const;
 
-        vertex_t* end() const { return _end; }
+        const vertex_t* end() const { return _end; }
         weight_t  weight() const  { return _weight; }
 
         void setEnd(const vertex_t* pv) { _end = pv; }
         void setWeight(weight_t w) { _weight = w; }
 
     private:
-        vertex_t*      _end;
-        weight_t       _weight;
+        const vertex_t*    _end;
+        weight_t           _weight;
     };
 
     template <class O>
     Edge<O>&
     Edge<O>::operator=(const Edge& e) {
-        _end = e.end; _weight = e._weight;
+        _end = e._end; _weight = e._weight;
         return *this;
     }
 
@@ -90,7 +90,7 @@ namespace aco {
     template <class O>
     bool
     Edge<O>::isSame(const Edge& e) const {
-        return _weight == e._weight && _end == e._weight;
+        return _weight == e._weight && _end == e._end;
     }
 
     /* @enum VertexType
@@ -122,10 +122,10 @@ namespace aco {
         typedef int32_t   weight_t;
 
         Vertex(data_t d = data_t(), size_type id = -1, weight_t w = weight_t(),
-               std::vector<Edge<data_t>>& n = std::vector<Edge<data_t>>(),
+               std::vector<Edge<data_t>> n = std::vector<Edge<data_t>>(),
                size_type p = -1, VertexType t = VertexType::MEDIATE,
-               VertexStatus s = Vertex::UNSELECTED)
-        : _data(d), _id(id), _weight(w), _neighbors(n),
+               VertexStatus s = VertexStatus::UNSELECTED)
+        : _data(d), _id(id), _weight(w), _neighbors(std::move(n)),
           _parent(p), _type(t), _status(s) {}
         Vertex(const Vertex&);
         Vertex(Vertex&&);
@@ -149,7 +149,7 @@ namespace aco {
         data_t                     data() const { return _data; }
         size_type                  id() const { return _id; }
         weight_t                   weight() const { return _weight; }
-        std::vector<Edge<data_t>>  neighbors() const { return _neighbors; }
+        const std::vector<Edge<data_t>>& neighbors() const { return _neighbors; }
         std::vector<Edge<data_t>>& neighbors() { return _neighbors; }
         size_type                  parent() const { return _parent; }
         VertexType                 type() const { return _type; }
@@ -164,7 +164,9 @@ namespace aco {
         void setType(VertexType t) { _type = t; }
         void setStatus(VertexStatus s) { _status = s; }
 
-        void pushNeighbor(Vertex& v, weight_t w) { _neighbors.push_back(Edge<data_t>(&v, w)); }
+        void pushNeighbor(Vertex& v, typename Edge<data_t>::weight_t w) {
+            _neighbors.push_back(Edge<data_t>(&v, w));
+        }
         void popNeighbor() { _neighbors.pop_back(); }
         void clearNeighbor() { _neighbors.clear(); }
 
@@ -210,8 +212,6 @@ namespace aco {
         _parent = std::move(v._parent);
         _type = std::move(v._type); _status = std::move(v._status);
 
-        _data = data_t();
-
         return *this;
     }
 }
@@ -0,0 +1,471 @@
+/*
+ * Loading graphs from TSPLIB and edge-list files.
+ */
+
+#ifndef ACO_LOADER_H
+#define ACO_LOADER_H
+
+#include <vector>
+#include <string>
+#include <cmath>         // sqrt()
+#include <cstring>       // strerror()
+#include <cstdlib>       // strtod()
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>     // runtime_error
+#include <algorithm>     // max()
+#include <cstdint>       // uint64_t
+
+#include <sys/mman.h>    // mmap(), munmap(), madvise()
+#include <sys/stat.h>    // fstat()
+#include <fcntl.h>       // open()
+#include <unistd.h>      // close()
+
+#include "header.h"
+#include "graph.h"
+#include "csr_graph.h"
+
+namespace aco {
+    /* @class MappedFile
+     * A whole file mapped read-only into memory, unmapped on
+     * destruction. The bytes are not null-terminated.
+     */
+    class MappedFile {
+    public:
+        explicit MappedFile(const char* path);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile() {
+            if (_size > 0)
+                munmap(const_cast<char*>(_data), _size);
+        }
+
+        const char* begin() const { return _data; }
+        const char* end() const { return _data + _size; }
+        size_t size() const { return _size; }
+
+    private:
+        const char*    _data;
+        size_t         _size;
+    };
+
+    inline
+    MappedFile::MappedFile(const char* path): _data(nullptr), _size(0) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error(std::string(path) + ": " + std::strerror(errno));
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            int e = errno;
+            close(fd);
+            throw std::runtime_error(std::string(path) + ": " + std::strerror(e));
+        }
+        _size = static_cast<size_t>(st.st_size);
+        if (_size > 0) {
+            void* p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                int e = errno;
+                close(fd);
+                throw std::runtime_error(std::string(path) + ": " + std::strerror(e));
+            }
+            madvise(p, _size, MADV_SEQUENTIAL);
+            _data = static_cast<const char*>(p);
+        }
+        close(fd);
+    }
+
+    /* @struct LoadStats
+     * How long a load took: reading the text, and in all, from
+     * opening the file to the finished graph. The throughput is that
+     * of the parse alone.
+     */
+    struct LoadStats {
+        size_t    bytes = 0;
+        double    parseSeconds = 0;
+        double    seconds = 0;
+
+        double mbPerSecond() const { return parseSeconds > 0 ? bytes / 1e6 / parseSeconds : 0; }
+    };
+
+    /*
+     * A cursor over mapped text. Numbers are read in place: up to 19
+     * significant digits go into an integer, and when that is exact
+     * in a double (15 digits or fewer, a power of ten up to 22) one
+     * multiplication or division gives the correctly rounded value.
+     * Anything longer goes through strtod() on a copy of the token.
+     */
+    class TextCursor {
+    public:
+        TextCursor(const char* begin, const char* end, const char* path)
+        : _begin(begin), _p(begin), _end(end), _path(path) {}
+
+        bool atEnd() const { return _p == _end; }
+        char peek() const { return _p < _end ? *_p : '\0'; }
+        void skip() { ++_p; }
+
+        // spaces and tabs, and also line breaks if lines is set.
+        void skipSpace(bool lines) {
+            while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\r' ||
+                                 (lines && *_p == '\n')))
+                ++_p;
+        }
+        void skipLine() {
+            while (_p < _end && *_p != '\n')
+                ++_p;
+            if (_p < _end)
+                ++_p;
+        }
+        // a TSPLIB keyword: letters, digits and underscores.
+        std::string keyword() {
+            const char* s = _p;
+            while (_p < _end && (isDigit(*_p) || *_p == '_' ||
+                                 (*_p >= 'A' && *_p <= 'Z') || (*_p >= 'a' && *_p <= 'z')))
+                ++_p;
+            return std::string(s, _p);
+        }
+        // the run of non-space characters at the cursor.
+        std::string word() {
+            const char* s = _p;
+            while (_p < _end && !isSpace(*_p))
+                ++_p;
+            return std::string(s, _p);
+        }
+        // the rest of the line, trimmed.
+        std::string rest() {
+            skipSpace(false);
+            const char* s = _p;
+            while (_p < _end && *_p != '\n')
+                ++_p;
+            const char* e = _p;
+            while (e > s && isSpace(e[-1]))
+                --e;
+            return std::string(s, e);
+        }
+
+        bool number(double& out);
+        bool index(uint64_t& out);
+
+        [[noreturn]] void fail(const std::string& what) const;
+
+        static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+        static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    private:
+        const char*    _begin;
+        const char*    _p;
+        const char*    _end;
+        const char*    _path;
+    };
+
+    inline bool
+    TextCursor::number(double& out) {
+        static const double pow10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        const char* s = _p;
+        bool negative = false, any = false;
+        uint64_t m = 0;
+        int digits = 0, exp10 = 0;
+
+        if (s < _end && (*s == '-' || *s == '+'))
+            negative = *s++ == '-';
+        for ( ; s < _end && isDigit(*s); ++s, any = true)
+            if (digits < 19) {
+                m = m * 10 + (*s - '0');
+                digits += m != 0;
+            } else
+                ++exp10;
+        if (s < _end && *s == '.')
+            for (++s; s < _end && isDigit(*s); ++s, any = true)
+                if (digits < 19) {
+                    m = m * 10 + (*s - '0');
+                    digits += m != 0;
+                    --exp10;
+                }
+        if (!any)
+            return false;
+        if (s < _end && (*s == 'e' || *s == 'E')) {
+            const char* t = s + 1;
+            bool minus = false;
+            int e = 0;
+            if (t < _end && (*t == '-' || *t == '+'))
+                minus = *t++ == '-';
+            if (t < _end && isDigit(*t)) {
+                for ( ; t < _end && isDigit(*t); ++t)
+                    if (e < 100000)
+                        e = e * 10 + (*t - '0');
+                exp10 += minus ? -e : e;
+                s = t;
+            }
+        }
+
+        if (m == 0)
+            out = 0;
+        else if (digits <= 15 && exp10 >= -22 && exp10 <= 22)
+            out = exp10 < 0 ? m / pow10[-exp10] : m * pow10[exp10];
+        else {
+            std::string token(_p, s);
+            out = std::strtod(token.c_str(), nullptr);
+            negative = false;
+        }
+        if (negative)
+            out = -out;
+        _p = s;
+        return true;
+    }
+
+    inline bool
+    TextCursor::index(uint64_t& out) {
+        const char* s = _p;
+
+        out = 0;
+        for ( ; s < _end && isDigit(*s); ++s) {
+            if (out > (UINT64_MAX - 9) / 10)
+                fail("vertex number out of range");
+            out = out * 10 + (*s - '0');
+        }
+        if (s == _p)
+            return false;
+        _p = s;
+        return true;
+    }
+
+    inline void
+    TextCursor::fail(const std::string& what) const {
+        size_type line = 1;
+        for (const char* q = _begin; q < _p; ++q)
+            line += *q == '\n';
+        throw std::runtime_error(std::string(_path) + ":" + std::to_string(line) + ": " + what);
+    }
+
+    /* @struct TspInstance
+     * A symmetric TSPLIB instance: coordinates for EUC_2D, or the
+     * full n x n weight matrix for EXPLICIT ones, whatever triangle
+     * the file gave.
+     */
+    struct TspInstance {
+        std::string            name;
+        size_type              dimension = 0;
+        bool                   explicitWeights = false;
+        std::vector<double>    x, y;        // EUC_2D.
+        std::vector<double>    matrix;      // EXPLICIT, row-major.
+
+        // TSPLIB's distance: Euclidean rounded to the nearest integer.
+        double distance(size_type i, size_type j) const {
+            if (explicitWeights)
+                return matrix[i * dimension + j];
+            double dx = x[i] - x[j], dy = y[i] - y[j];
+            return static_cast<double>(static_cast<int64_t>(std::sqrt(dx * dx + dy * dy) + 0.5));
+        }
+
+        // the complete graph over the cities, n (n - 1) arcs.
+        CsrGraph completeGraph() const;
+    };
+
+    inline CsrGraph
+    TspInstance::completeGraph() const {
+        std::vector<CsrGraph::Link> links;
+
+        links.reserve(dimension * (dimension - 1) / 2);
+        for (size_type i = 0; i < dimension; ++i)
+            for (size_type j = i + 1; j < dimension; ++j)
+                links.push_back(CsrGraph::Link{i, j, distance(i, j)});
+        return CsrGraph(dimension, links);
+    }
+
+    /* @fn loadTsplib
+     * Reads a TSPLIB TSP file with EDGE_WEIGHT_TYPE EUC_2D, or
+     * EXPLICIT with EDGE_WEIGHT_FORMAT FULL_MATRIX, UPPER_ROW,
+     * LOWER_ROW, UPPER_DIAG_ROW or LOWER_DIAG_ROW. Other sections
+     * (DISPLAY_DATA_SECTION, say) are skipped. Throws
+     * std::runtime_error with the file and line on anything else.
+     */
+    inline TspInstance
+    loadTsplib(const char* path, LoadStats* stats = nullptr) {
+        auto start = std::chrono::steady_clock::now();
+        MappedFile file(path);
+        TextCursor in(file.begin(), file.end(), path);
+        TspInstance tsp;
+        std::string type, weightType, format = "FULL_MATRIX";
+        bool coords = false, weights = false;
+
+        for (in.skipSpace(true); !in.atEnd(); in.skipSpace(true)) {
+            std::string key = in.keyword();
+            if (key.empty())
+                in.fail("expected a keyword");
+            if (key == "EOF")
+                break;
+
+            if (key == "NODE_COORD_SECTION") {
+                if (tsp.dimension <= 0 || weightType != "EUC_2D")
+                    in.fail("NODE_COORD_SECTION needs DIMENSION and EDGE_WEIGHT_TYPE EUC_2D first");
+                tsp.x.assign(tsp.dimension, 0);
+                tsp.y.assign(tsp.dimension, 0);
+                std::vector<uint8_t> seen(tsp.dimension, 0);
+                for (size_type k = 0; k < tsp.dimension; ++k) {
+                    uint64_t id;
+                    double x, y;
+                    in.skipSpace(true);
+                    if (!in.index(id) || id < 1 || id > static_cast<uint64_t>(tsp.dimension) ||
+                        seen[id - 1])
+                        in.fail("bad or repeated node number");
+                    in.skipSpace(false);
+                    if (!in.number(x))
+                        in.fail("expected a coordinate");
+                    in.skipSpace(false);
+                    if (!in.number(y))
+                        in.fail("expected a coordinate");
+                    seen[id - 1] = 1;
+                    tsp.x[id - 1] = x;
+                    tsp.y[id - 1] = y;
+                }
+                coords = true;
+            } else if (key == "EDGE_WEIGHT_SECTION") {
+                if (tsp.dimension <= 0 || weightType != "EXPLICIT")
+                    in.fail("EDGE_WEIGHT_SECTION needs DIMENSION and EDGE_WEIGHT_TYPE EXPLICIT first");
+                size_type n = tsp.dimension;
+                bool full = format == "FULL_MATRIX";
+                bool upper = format == "UPPER_ROW" || format == "UPPER_DIAG_ROW";
+                bool diag = format == "UPPER_DIAG_ROW" || format == "LOWER_DIAG_ROW";
+                if (!full && !upper && format != "LOWER_ROW" && format != "LOWER_DIAG_ROW")
+                    in.fail("unsupported EDGE_WEIGHT_FORMAT " + format);
+                tsp.matrix.assign(n * n, 0);
+                for (size_type i = 0; i < n; ++i) {
+                    size_type first = full ? 0 : upper ? (diag ? i : i + 1) : 0;
+                    size_type last = full ? n : upper ? n : (diag ? i + 1 : i);
+                    for (size_type j = first; j < last; ++j) {
+                        double w;
+                        in.skipSpace(true);
+                        if (!in.number(w))
+                            in.fail("expected an edge weight");
+                        tsp.matrix[i * n + j] = w;
+                        if (!full)
+                            tsp.matrix[j * n + i] = w;
+                    }
+                }
+                weights = true;
+            } else if (key.size() > 8 && key.compare(key.size() - 8, 8, "_SECTION") == 0) {
+                // a section we do not use: numbers up to the next keyword.
+                for (in.skipSpace(true); !in.atEnd(); in.skipSpace(true)) {
+                    char c = in.peek();
+                    if (!TextCursor::isDigit(c) && c != '-' && c != '+' && c != '.')
+                        break;
+                    in.word();
+                }
+            } else {
+                in.skipSpace(false);
+                if (in.peek() == ':')
+                    in.skip();
+                std::string value = in.rest();
+                if (key == "NAME")
+                    tsp.name = value;
+                else if (key == "TYPE")
+                    type = value;
+                else if (key == "DIMENSION") {
+                    char* e = nullptr;
+                    long long d = std::strtoll(value.c_str(), &e, 10);
+                    if (d <= 0 || *e != '\0')
+                        in.fail("bad DIMENSION " + value);
+                    tsp.dimension = static_cast<size_type>(d);
+                } else if (key == "EDGE_WEIGHT_TYPE") {
+                    weightType = value;
+                    if (value != "EUC_2D" && value != "EXPLICIT")
+                        in.fail("unsupported EDGE_WEIGHT_TYPE " + value);
+                } else if (key == "EDGE_WEIGHT_FORMAT")
+                    format = value;
+                // COMMENT, DISPLAY_DATA_TYPE and the like are not needed.
+            }
+        }
+
+        if (type != "TSP")
+            in.fail("not a symmetric TSP instance (TYPE " + type + ")");
+        if (!(weightType == "EUC_2D" ? coords : weights))
+            in.fail("no NODE_COORD_SECTION or EDGE_WEIGHT_SECTION");
+        tsp.explicitWeights = weightType == "EXPLICIT";
+
+        if (stats) {
+            stats->bytes = file.size();
+            stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            stats->parseSeconds = stats->seconds;
+        }
+        return tsp;
+    }
+
+    /* @fn loadEdgeList
+     * Reads lines of "u v [weight]", vertices numbered from 0 and the
+     * weight 1 if left out; blank lines and lines starting with # or
+     * % are skipped. There are max(u, v) + 1 vertices. Each line is
+     * one edge, stored both ways unless directed is set.
+     */
+    inline CsrGraph
+    loadEdgeList(const char* path, bool directed = false, LoadStats* stats = nullptr) {
+        auto start = std::chrono::steady_clock::now();
+        MappedFile file(path);
+        TextCursor in(file.begin(), file.end(), path);
+        std::vector<CsrGraph::Link> links;
+        uint64_t vertices = 0;
+
+        // about 16 bytes a line is a fair first guess.
+        links.reserve(file.size() / 16);
+        for (in.skipSpace(true); !in.atEnd(); in.skipSpace(true)) {
+            if (in.peek() == '#' || in.peek() == '%') {
+                in.skipLine();
+                continue;
+            }
+            uint64_t u, v;
+            double w = 1;
+            if (!in.index(u))
+                in.fail("expected a vertex number");
+            in.skipSpace(false);
+            if (!in.index(v))
+                in.fail("expected a vertex number");
+            in.skipSpace(false);
+            if (!in.atEnd() && in.peek() != '\n') {
+                if (!in.number(w))
+                    in.fail("expected an edge weight");
+                in.skipSpace(false);
+                if (!in.atEnd() && in.peek() != '\n')
+                    in.fail("trailing characters");
+            }
+            if (std::max(u, v) >= UINT32_MAX)
+                in.fail("vertex number out of range");
+            if (u >= vertices || v >= vertices)
+                vertices = std::max(u, v) + 1;
+            links.push_back(CsrGraph::Link{static_cast<size_type>(u), static_cast<size_type>(v), w});
+        }
+
+        auto parsed = std::chrono::steady_clock::now();
+        CsrGraph graph(static_cast<size_type>(vertices), links, !directed);
+        if (stats) {
+            auto now = std::chrono::steady_clock::now();
+            stats->bytes = file.size();
+            stats->parseSeconds = std::chrono::duration<double>(parsed - start).count();
+            stats->seconds = std::chrono::duration<double>(now - start).count();
+        }
+        return graph;
+    }
+
+    /* @fn makeVertices
+     * The graph as aco::Vertex objects with ids 0..n-1 and their
+     * edges pointing into the returned vector, which therefore must
+     * not be resized afterwards (moving it is fine).
+     */
+    template <class O>
+    std::vector<Vertex<O>>
+    makeVertices(const CsrGraph& graph) {
+        std::vector<Vertex<O>> vertices;
+
+        vertices.reserve(graph.vertexSize());
+        for (size_type i = 0; i < graph.vertexSize(); ++i)
+            vertices.push_back(Vertex<O>(O(), i));
+        for (size_type i = 0; i < graph.vertexSize(); ++i) {
+            vertices[i].neighbors().reserve(graph.degree(i));
+            for (CsrGraph::Arc a : graph.neighbors(i))
+                vertices[i].pushNeighbor(vertices[a.to], a.weight);
+        }
+        return vertices;
+    }
+}
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ * Load time and parse throughput of the mmap loaders on generated
+ * files: a TSPLIB EUC_2D instance with 10^5 cities and an edge list
+ * of 10^7 weighted edges over 10^6 vertices, stored both ways. MB/s
+ * is the parse alone; the total adds building the CsrGraph. The
+ * baseline is an std::ifstream reading the same files with
+ * operator>> into the same structures, its MB/s over the total. The
+ * files are written to /tmp (or the directory given as the argument)
+ * and removed afterwards.
+ *
+ * build: g++ -std=c++14 -O2 loader_bench.cc -o loader_bench
+ */
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdio>
+
+#include <unistd.h>      // unlink()
+
+#include "header.h"
+#include "loader.h"
+
+typedef std::chrono::steady_clock    clock_type;
+
+const long    cities = 100000;
+const long    edges = 10000000;
+const long    vertices = 1000000;
+
+void
+write_files(const std::string& tsp, const std::string& list) {
+    std::mt19937_64 e(11);
+    std::uniform_real_distribution<double> coord(0, 1e6), weight(1, 1000);
+
+    FILE* f = std::fopen(tsp.c_str(), "w");
+    std::fprintf(f, "NAME : random%ld\nTYPE : TSP\nDIMENSION : %ld\n"
+                 "EDGE_WEIGHT_TYPE : EUC_2D\nNODE_COORD_SECTION\n", cities, cities);
+    for (long i = 1; i <= cities; ++i)
+        std::fprintf(f, "%ld %.4f %.4f\n", i, coord(e), coord(e));
+    std::fprintf(f, "EOF\n");
+    std::fclose(f);
+
+    f = std::fopen(list.c_str(), "w");
+    for (long i = 0; i < edges; ++i)
+        std::fprintf(f, "%ld %ld %.3f\n", static_cast<long>(e() % vertices),
+                     static_cast<long>(e() % vertices), weight(e));
+    std::fclose(f);
+}
+
+// the same parse through iostreams, into the same structures.
+double
+stream_tsp(const std::string& path) {
+    auto start = clock_type::now();
+    std::ifstream in(path);
+    std::string word;
+    std::vector<double> x(cities), y(cities);
+    while (in >> word && word != "NODE_COORD_SECTION")
+        ;
+    for (long i = 0, id; i < cities; ++i)
+        in >> id >> x[id - 1] >> y[id - 1];
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+double
+stream_list(const std::string& path) {
+    auto start = clock_type::now();
+    std::ifstream in(path);
+    std::vector<aco::CsrGraph::Link> links;
+    aco::CsrGraph::Link l;
+    aco::size_type n = 0;
+    while (in >> l.from >> l.to >> l.weight) {
+        links.push_back(l);
+        n = std::max(n, std::max(l.from, l.to) + 1);
+    }
+    aco::CsrGraph g(n, links);
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+void
+report(const char* what, const aco::LoadStats& stats, double stream) {
+    std::cout << std::setw(10) << what << std::fixed << std::setprecision(1)
+              << std::setw(10) << stats.bytes / 1e6 << std::setprecision(3)
+              << std::setw(10) << stats.parseSeconds << std::setw(10) << stats.seconds
+              << std::setprecision(1) << std::setw(10) << stats.mbPerSecond()
+              << std::setprecision(3) << std::setw(12) << stream << std::setprecision(1)
+              << std::setw(12) << stats.bytes / 1e6 / stream << std::endl;
+}
+
+int
+main(int argc, char** argv) {
+    std::string dir = argc > 1 ? argv[1] : "/tmp";
+    std::string tsp = dir + "/aco_bench.tsp", list = dir + "/aco_bench.edges";
+
+    write_files(tsp, list);
+    std::cout << std::setw(10) << "" << std::setw(10) << "MB" << std::setw(10) << "parse s"
+              << std::setw(10) << "total s" << std::setw(10) << "MB/s"
+              << std::setw(12) << "stream s" << std::setw(12) << "MB/s" << std::endl;
+
+    aco::LoadStats stats;
+    aco::TspInstance t = aco::loadTsplib(tsp.c_str(), &stats);
+    report("tsplib", stats, stream_tsp(tsp));
+
+    aco::CsrGraph g = aco::loadEdgeList(list.c_str(), false, &stats);
+    report("edges", stats, stream_list(list));
+    std::cout << t.dimension << " cities, " << g.vertexSize() << " vertices, "
+              << g.arcSize() << " arcs" << std::endl;
+
+    unlink(tsp.c_str());
+    unlink(list.c_str());
+    return 0;
+}
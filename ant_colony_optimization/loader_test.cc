@@ -0,0 +1,210 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <stdexcept>
+#include <cassert>
+
+#include <unistd.h>      // unlink()
+
+#include "header.h"
+#include "loader.h"
+
+// writes text to a fresh temporary file and returns its path.
+std::string
+temp(const std::string& text) {
+    char path[] = "/tmp/aco_loader_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    ssize_t n = write(fd, text.data(), text.size());
+    assert(n == static_cast<ssize_t>(text.size()));
+    (void)n;
+    close(fd);
+    return path;
+}
+
+bool
+throws(const std::string& text, bool tsplib = true) {
+    std::string path = temp(text);
+    bool threw = false;
+    try {
+        if (tsplib)
+            aco::loadTsplib(path.c_str());
+        else
+            aco::loadEdgeList(path.c_str());
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    unlink(path.c_str());
+    return threw;
+}
+
+// the in-place number parser against strtod.
+void number_test(void) {
+    const char* cases[] = {
+        "0", "-0", "7", "+7", "-12.5", "3.", ".25", "1e3", "1E-3", "2.5e+2",
+        "123456789012345", "1234567890123456789", "12345678901234567890123",
+        "0.000000000000000000000000001", "1e300", "1e-320", "9007199254740993",
+        "0.1", "0.3", "17.0000000000000000001", "1e", "6.02214076e23"
+    };
+    for (const char* c : cases) {
+        std::string s(c);
+        aco::TextCursor in(s.data(), s.data() + s.size(), "test");
+        double x;
+        assert(in.number(x));
+        assert(x == std::strtod(c, nullptr));
+    }
+
+    std::mt19937_64 e(5);
+    char buf[64];
+    for (int i = 0; i < 100000; ++i) {
+        double v = std::ldexp(static_cast<double>(e() >> 11), static_cast<int>(e() % 80) - 60);
+        std::snprintf(buf, sizeof buf, i % 2 ? "%.17g" : "%.6f", i % 3 ? v : -v);
+        std::string s(buf);
+        aco::TextCursor in(s.data(), s.data() + s.size(), "test");
+        double x;
+        assert(in.number(x) && in.atEnd());
+        assert(x == std::strtod(buf, nullptr));
+    }
+
+    std::string junk = "-x";
+    aco::TextCursor in(junk.data(), junk.data() + junk.size(), "test");
+    double x;
+    assert(!in.number(x));
+}
+
+void euclid_test(void) {
+    std::string path = temp(
+        "NAME : five\r\n"
+        "COMMENT : cities out of order\r\n"
+        "TYPE : TSP\r\n"
+        "DIMENSION: 5\r\n"
+        "EDGE_WEIGHT_TYPE : EUC_2D\r\n"
+        "NODE_COORD_SECTION\r\n"
+        "3 3 4\r\n"
+        "1 0 0\r\n"
+        "2 1.5e1 0\r\n"
+        "5 -3 -4\r\n"
+        "4 0.4 0.4\r\n"
+        "EOF\r\n");
+    aco::LoadStats stats;
+    aco::TspInstance tsp = aco::loadTsplib(path.c_str(), &stats);
+    unlink(path.c_str());
+
+    assert(tsp.name == "five" && tsp.dimension == 5 && !tsp.explicitWeights);
+    assert(tsp.x[2] == 3 && tsp.y[2] == 4 && tsp.x[1] == 15);
+    assert(tsp.distance(0, 2) == 5);
+    assert(tsp.distance(2, 4) == 10);
+    assert(tsp.distance(0, 3) == 1);      // 0.57 rounds up.
+    assert(tsp.distance(1, 0) == 15);
+    assert(stats.bytes > 0 && stats.seconds > 0 && stats.mbPerSecond() > 0);
+
+    aco::CsrGraph g = tsp.completeGraph();
+    assert(g.vertexSize() == 5 && g.arcSize() == 20);
+    assert(g.weight(g.findArc(2, 0)) == 5);
+}
+
+// the same 4-city matrix in each triangle format.
+void explicit_test(void) {
+    const double full[4][4] = { {0, 1, 2, 3}, {1, 0, 4, 5}, {2, 4, 0, 6}, {3, 5, 6, 0} };
+    const char* formats[][2] = {
+        { "FULL_MATRIX", "0 1 2 3\n1 0 4 5\n2 4 0 6\n3 5 6 0\n" },
+        { "UPPER_ROW", "1 2 3\n4 5\n6\n" },
+        { "LOWER_ROW", "1\n2 4\n3 5 6\n" },
+        { "UPPER_DIAG_ROW", "0 1 2 3 0 4 5 0 6 0\n" },
+        { "LOWER_DIAG_ROW", "0\n1 0\n2 4 0\n3 5 6 0\n" },
+    };
+    for (auto& f : formats) {
+        std::string path = temp(std::string("NAME: m\nTYPE: TSP\nDIMENSION: 4\n"
+                                            "EDGE_WEIGHT_TYPE: EXPLICIT\nEDGE_WEIGHT_FORMAT: ") +
+                                f[0] + "\nDISPLAY_DATA_TYPE: TWOD_DISPLAY\n"
+                                "EDGE_WEIGHT_SECTION\n" + f[1] +
+                                "DISPLAY_DATA_SECTION\n1 0 0\n2 1 1\n3 2 2\n4 3 3\n");
+        aco::TspInstance tsp = aco::loadTsplib(path.c_str());
+        unlink(path.c_str());
+        assert(tsp.explicitWeights);
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                assert(tsp.distance(i, j) == full[i][j]);
+    }
+}
+
+void edge_list_test(void) {
+    std::string path = temp(
+        "# a comment\n"
+        "% another\n"
+        "0 1 2.5\n"
+        "\n"
+        "1 2\r\n"
+        "4 0 -1e1   \n"
+        "2 2 7");
+    aco::LoadStats stats;
+    aco::CsrGraph g = aco::loadEdgeList(path.c_str(), false, &stats);
+    assert(g.vertexSize() == 5 && g.arcSize() == 8);
+    assert(g.weight(g.findArc(1, 0)) == 2.5);
+    assert(g.weight(g.findArc(2, 1)) == 1);
+    assert(g.weight(g.findArc(0, 4)) == -10);
+    assert(g.degree(3) == 0);
+    assert(stats.bytes > 0);
+
+    aco::CsrGraph d = aco::loadEdgeList(path.c_str(), true);
+    unlink(path.c_str());
+    assert(d.arcSize() == 4 && d.findArc(1, 0) == -1);
+
+    std::vector<aco::Vertex<int>> vs = aco::makeVertices<int>(g);
+    assert(vs.size() == 5 && vs[4].id() == 4);
+    assert(vs[0].neighborSize() == 2);
+    assert(vs[0].neighbors()[1].end() == &vs[4]);
+    assert(vs[0].neighbors()[1].weight() == -10);
+    aco::CsrGraph back(vs);
+    assert(back.arcSize() == g.arcSize());
+
+    std::string empty = temp("");
+    assert(aco::loadEdgeList(empty.c_str()).vertexSize() == 0);
+    unlink(empty.c_str());
+}
+
+void error_test(void) {
+    bool threw = false;
+    try {
+        aco::loadTsplib("/nonexistent/file.tsp");
+    } catch (const std::runtime_error& e) {
+        threw = std::string(e.what()).find("/nonexistent/file.tsp") == 0;
+    }
+    assert(threw);
+
+    const std::string head = "TYPE: TSP\nDIMENSION: 2\n";
+    assert(throws(head + "EDGE_WEIGHT_TYPE: GEO\n"));
+    assert(throws(head + "EDGE_WEIGHT_TYPE: EUC_2D\nNODE_COORD_SECTION\n1 0 0\n1 1 1\n"));
+    assert(throws(head + "EDGE_WEIGHT_TYPE: EUC_2D\nNODE_COORD_SECTION\n1 0 0\n2 x 1\n"));
+    assert(throws(head + "EDGE_WEIGHT_TYPE: EUC_2D\nNODE_COORD_SECTION\n1 0 0\n"));
+    assert(throws(head + "EDGE_WEIGHT_TYPE: EUC_2D\n"));
+    assert(throws("TYPE: ATSP\nDIMENSION: 1\nEDGE_WEIGHT_TYPE: EUC_2D\nNODE_COORD_SECTION\n1 0 0\n"));
+    assert(throws("0 1 1\n1 x\n", false));
+    assert(throws("0 1 1 1\n", false));
+    assert(throws("0 -1\n", false));
+
+    // errors give the line.
+    std::string path = temp("0 1\n1 2\n2 oops\n");
+    std::string what;
+    try {
+        aco::loadEdgeList(path.c_str());
+    } catch (const std::runtime_error& e) {
+        what = e.what();
+    }
+    unlink(path.c_str());
+    assert(what == path + ":3: expected a vertex number");
+}
+
+int main(void) {
+    number_test();
+    euclid_test();
+    explicit_test();
+    edge_list_test();
+    error_test();
+    std::cout << "all loader tests passed" << std::endl;
+    return 0;
+}
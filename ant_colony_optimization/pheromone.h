@@ -0,0 +1,400 @@
+/*
+ * Pheromone and choice-weight tables for ant colony solvers.
+ */
+
+#ifndef ACO_PHEROMONE_H
+#define ACO_PHEROMONE_H
+
+#include <vector>
+#include <cmath>         // pow()
+#include <cstring>       // memcpy()
+#include <cstdlib>       // posix_memalign(), free()
+#include <new>           // bad_alloc
+#include <algorithm>     // max(), fill()
+#include <cstdint>       // uint8_t
+
+#include "header.h"
+#include "csr_graph.h"
+
+namespace aco {
+    /* @class AlignedAllocator
+     * Allocator for std::vector that starts every array on a 64-byte
+     * boundary, a cache line and a whole number of vector registers.
+     */
+    template <class T>
+    struct AlignedAllocator {
+        typedef T    value_type;
+
+        AlignedAllocator() = default;
+        template <class U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+        T* allocate(size_t n) {
+            void* p = nullptr;
+            if (posix_memalign(&p, 64, std::max<size_t>(n * sizeof(T), 64)) != 0)
+                throw std::bad_alloc();
+            return static_cast<T*>(p);
+        }
+        void deallocate(T* p, size_t) { std::free(p); }
+
+        template <class U> bool operator==(const AlignedAllocator<U>&) const { return true; }
+        template <class U> bool operator!=(const AlignedAllocator<U>&) const { return false; }
+    };
+
+    /*
+     * Kernels over the pheromone arrays, in the manner of the
+     * simd.hpp ones at the top of this repository: written once with
+     * GCC vector extensions, built for AVX2 (chosen at run time when
+     * the CPU has it) and for the SSE2 baseline of x86-64, with plain
+     * loops elsewhere. The scalar loops are also the reference the
+     * tests check the vector ones against.
+     *
+     * The choice weight is tau^alpha * eta. Powers 1 and 2 of tau are
+     * multiplications and vectorize; any other alpha goes through
+     * std::pow one entry at a time.
+     */
+    namespace pheromone_detail {
+        inline double power(double tau, double alpha) {
+            return alpha == 1.0 ? tau : alpha == 2.0 ? tau * tau : std::pow(tau, alpha);
+        }
+
+        inline void evaporate_scalar(double* tau, size_t n, double keep) {
+            for (size_t i = 0; i < n; ++i)
+                tau[i] *= keep;
+        }
+
+        inline void deposit_scalar(double* tau, double* delta, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                tau[i] += delta[i];
+                delta[i] = 0;
+            }
+        }
+
+        inline void choice_scalar(const double* tau, const double* eta, double* choice,
+                                  size_t n, double alpha) {
+            for (size_t i = 0; i < n; ++i)
+                choice[i] = power(tau[i], alpha) * eta[i];
+        }
+
+        inline void update_scalar(double* tau, double* delta, const double* eta, double* choice,
+                                  size_t n, double keep, double alpha) {
+            for (size_t i = 0; i < n; ++i) {
+                tau[i] = tau[i] * keep + delta[i];
+                delta[i] = 0;
+                choice[i] = power(tau[i], alpha) * eta[i];
+            }
+        }
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ACO_PHEROMONE_X86 1
+        typedef double    d2 __attribute__((vector_size(16)));
+        typedef double    d4 __attribute__((vector_size(32)));
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#define ACO_KERNEL inline __attribute__((always_inline))
+
+        template <typename V>
+        ACO_KERNEL V load(const double* p) {
+            V v;
+            std::memcpy(&v, p, sizeof(V));
+            return v;
+        }
+
+        template <typename V>
+        ACO_KERNEL void store(double* p, const V& v) {
+            std::memcpy(p, &v, sizeof(V));
+        }
+
+        template <typename V>
+        ACO_KERNEL V splat(double x) {
+            V v;
+            for (size_t i = 0; i < sizeof(V) / sizeof(double); ++i)
+                v[i] = x;
+            return v;
+        }
+
+        template <typename V>
+        ACO_KERNEL void evaporate_kernel(double* tau, size_t n, double keep) {
+            const size_t L = sizeof(V) / sizeof(double);
+            V k = splat<V>(keep);
+            size_t i = 0;
+
+            for (size_t end = n / (2 * L) * (2 * L); i < end; i += 2 * L) {
+                store(tau + i, load<V>(tau + i) * k);
+                store(tau + i + L, load<V>(tau + i + L) * k);
+            }
+            for ( ; i < n; ++i)
+                tau[i] *= keep;
+        }
+
+        template <typename V>
+        ACO_KERNEL void deposit_kernel(double* tau, double* delta, size_t n) {
+            const size_t L = sizeof(V) / sizeof(double);
+            V zero = splat<V>(0);
+            size_t i = 0;
+
+            for ( ; i + L <= n; i += L) {
+                store(tau + i, load<V>(tau + i) + load<V>(delta + i));
+                store(delta + i, zero);
+            }
+            for ( ; i < n; ++i) {
+                tau[i] += delta[i];
+                delta[i] = 0;
+            }
+        }
+
+        template <typename V, int Alpha>
+        ACO_KERNEL void choice_kernel(const double* tau, const double* eta, double* choice,
+                                      size_t n) {
+            const size_t L = sizeof(V) / sizeof(double);
+            size_t i = 0;
+
+            for ( ; i + L <= n; i += L) {
+                V t = load<V>(tau + i);
+                store(choice + i, (Alpha == 2 ? t * t : t) * load<V>(eta + i));
+            }
+            for ( ; i < n; ++i)
+                choice[i] = pheromone_detail::power(tau[i], Alpha) * eta[i];
+        }
+
+        // evaporation, the deposits and the choice weights in one pass.
+        template <typename V, int Alpha>
+        ACO_KERNEL void update_kernel(double* tau, double* delta, const double* eta,
+                                      double* choice, size_t n, double keep) {
+            const size_t L = sizeof(V) / sizeof(double);
+            V k = splat<V>(keep), zero = splat<V>(0);
+            size_t i = 0;
+
+            for ( ; i + L <= n; i += L) {
+                V t = load<V>(tau + i) * k + load<V>(delta + i);
+                store(tau + i, t);
+                store(delta + i, zero);
+                store(choice + i, (Alpha == 2 ? t * t : t) * load<V>(eta + i));
+            }
+            for ( ; i < n; ++i) {
+                tau[i] = tau[i] * keep + delta[i];
+                delta[i] = 0;
+                choice[i] = pheromone_detail::power(tau[i], Alpha) * eta[i];
+            }
+        }
+
+#undef ACO_KERNEL
+#pragma GCC diagnostic pop
+
+        inline bool has_avx2() {
+            static const bool avx2 = __builtin_cpu_supports("avx2");
+            return avx2;
+        }
+
+#define ACO_AVX2 __attribute__((target("avx2")))
+        ACO_AVX2 inline void evaporate_avx2(double* tau, size_t n, double keep)
+        { evaporate_kernel<d4>(tau, n, keep); }
+        inline void evaporate_sse2(double* tau, size_t n, double keep)
+        { evaporate_kernel<d2>(tau, n, keep); }
+
+        ACO_AVX2 inline void deposit_avx2(double* tau, double* delta, size_t n)
+        { deposit_kernel<d4>(tau, delta, n); }
+        inline void deposit_sse2(double* tau, double* delta, size_t n)
+        { deposit_kernel<d2>(tau, delta, n); }
+
+        template <int Alpha> ACO_AVX2 void
+        choice_avx2(const double* tau, const double* eta, double* choice, size_t n)
+        { choice_kernel<d4, Alpha>(tau, eta, choice, n); }
+        template <int Alpha> void
+        choice_sse2(const double* tau, const double* eta, double* choice, size_t n)
+        { choice_kernel<d2, Alpha>(tau, eta, choice, n); }
+
+        template <int Alpha> ACO_AVX2 void
+        update_avx2(double* tau, double* delta, const double* eta, double* choice,
+                    size_t n, double keep)
+        { update_kernel<d4, Alpha>(tau, delta, eta, choice, n, keep); }
+        template <int Alpha> void
+        update_sse2(double* tau, double* delta, const double* eta, double* choice,
+                    size_t n, double keep)
+        { update_kernel<d2, Alpha>(tau, delta, eta, choice, n, keep); }
+#undef ACO_AVX2
+#endif
+
+        inline void evaporate(double* tau, size_t n, double keep) {
+#ifdef ACO_PHEROMONE_X86
+            if (has_avx2())
+                return evaporate_avx2(tau, n, keep);
+            return evaporate_sse2(tau, n, keep);
+#else
+            evaporate_scalar(tau, n, keep);
+#endif
+        }
+
+        inline void deposit(double* tau, double* delta, size_t n) {
+#ifdef ACO_PHEROMONE_X86
+            if (has_avx2())
+                return deposit_avx2(tau, delta, n);
+            return deposit_sse2(tau, delta, n);
+#else
+            deposit_scalar(tau, delta, n);
+#endif
+        }
+
+        inline void choice(const double* tau, const double* eta, double* choice,
+                           size_t n, double alpha) {
+#ifdef ACO_PHEROMONE_X86
+            bool avx2 = has_avx2();
+            if (alpha == 1.0)
+                return avx2 ? choice_avx2<1>(tau, eta, choice, n) : choice_sse2<1>(tau, eta, choice, n);
+            if (alpha == 2.0)
+                return avx2 ? choice_avx2<2>(tau, eta, choice, n) : choice_sse2<2>(tau, eta, choice, n);
+#endif
+            choice_scalar(tau, eta, choice, n, alpha);
+        }
+
+        inline void update(double* tau, double* delta, const double* eta, double* choice,
+                           size_t n, double keep, double alpha) {
+#ifdef ACO_PHEROMONE_X86
+            bool avx2 = has_avx2();
+            if (alpha == 1.0)
+                return avx2 ? update_avx2<1>(tau, delta, eta, choice, n, keep)
+                            : update_sse2<1>(tau, delta, eta, choice, n, keep);
+            if (alpha == 2.0)
+                return avx2 ? update_avx2<2>(tau, delta, eta, choice, n, keep)
+                            : update_sse2<2>(tau, delta, eta, choice, n, keep);
+#endif
+            update_scalar(tau, delta, eta, choice, n, keep, alpha);
+        }
+    }
+
+#undef ACO_PHEROMONE_X86
+
+    /* @enum PheromoneLayout
+     * 0: dense, an n x n table indexed by (from, to),
+     * 1: sparse, one entry per arc of a CsrGraph, indexed by the arc.
+     */
+    enum class PheromoneLayout: uint8_t {
+        DENSE,
+        SPARSE
+    };
+
+    /* @class PheromoneMatrix
+     * Pheromone over the arcs of a graph, laid out as four parallel
+     * arrays: tau, the deposits waiting to be added to it, the
+     * heuristic eta = (1 / weight)^beta, and the choice weights
+     * tau^alpha * eta that ants draw from. Each array starts on a
+     * 64-byte boundary and a row of the table (the arcs out of one
+     * vertex) is contiguous in all four, so the updates are straight
+     * vector loops. Dense rows are padded to a multiple of 8 entries
+     * so that every row is aligned too; pairs that are not arcs have
+     * eta = 0 and so are never chosen.
+     *
+     * Dense tables suit complete and near-complete graphs, where
+     * looking an arc up is just (from, to); sparse ones take memory in
+     * proportion to the arcs. Deposits are queued with deposit() and
+     * only reach tau in applyDeposits() or update(). The row-range
+     * updates touch nothing outside their rows, so disjoint ranges
+     * can be updated on different threads.
+     */
+    class PheromoneMatrix {
+    public:
+        typedef std::vector<double, AlignedAllocator<double>>    array_t;
+
+        PheromoneMatrix(const CsrGraph& graph, PheromoneLayout layout,
+                        double tau0 = 1.0, double beta = 1.0);
+
+        PheromoneLayout layout() const { return _layout; }
+        size_type rows() const { return static_cast<size_type>(_rowStart.size()) - 1; }
+        size_type entries() const { return _rowStart.back(); }
+        // index of the first entry of row i; the row ends where i + 1 starts.
+        size_type rowStart(size_type i) const { return _rowStart[i]; }
+        // index of the entry for the arc from -> to, with the given arc index.
+        size_type entry(size_type from, size_type to, size_type arc) const {
+            return _layout == PheromoneLayout::DENSE ? _rowStart[from] + to : arc;
+        }
+
+        const double* tau() const { return _tau.data(); }
+        const double* eta() const { return _eta.data(); }
+        const double* choice() const { return _choice.data(); }
+
+        // queues amount for the entry until the next applyDeposits() or update().
+        void deposit(size_type entry, double amount) { _delta[entry] += amount; }
+
+        /* @fn evaporate, applyDeposits, updateChoice, update
+         * Over rows [first, last): tau *= 1 - rho; tau += the queued
+         * deposits; choice = tau^alpha * eta; and all three in one
+         * pass, evaporating before the deposits go in.
+         */
+        void evaporate(double rho, size_type first, size_type last);
+        void applyDeposits(size_type first, size_type last);
+        void updateChoice(double alpha, size_type first, size_type last);
+        void update(double rho, double alpha, size_type first, size_type last);
+
+        void evaporate(double rho) { evaporate(rho, 0, rows()); }
+        void applyDeposits() { applyDeposits(0, rows()); }
+        void updateChoice(double alpha) { updateChoice(alpha, 0, rows()); }
+        void update(double rho, double alpha) { update(rho, alpha, 0, rows()); }
+
+        size_t bytes() const {
+            return (_tau.capacity() + _delta.capacity() + _eta.capacity() + _choice.capacity()) *
+                   sizeof(double) + _rowStart.capacity() * sizeof(size_type);
+        }
+
+    private:
+        size_t span(size_type first, size_type last) const {
+            return static_cast<size_t>(_rowStart[last] - _rowStart[first]);
+        }
+
+    private:
+        PheromoneLayout           _layout;
+        std::vector<size_type>    _rowStart;
+        array_t                   _tau;
+        array_t                   _delta;
+        array_t                   _eta;
+        array_t                   _choice;
+    };
+
+    inline
+    PheromoneMatrix::PheromoneMatrix(const CsrGraph& graph, PheromoneLayout layout,
+                                     double tau0, double beta)
+    : _layout(layout), _rowStart(graph.vertexSize() + 1, 0) {
+        size_type n = graph.vertexSize();
+        size_type stride = (n + 7) / 8 * 8;
+
+        for (size_type i = 0; i < n; ++i)
+            _rowStart[i + 1] = layout == PheromoneLayout::DENSE ? (i + 1) * stride
+                                                                : graph.offset(i + 1);
+        _tau.assign(entries(), tau0);
+        _delta.assign(entries(), 0.0);
+        _eta.assign(entries(), 0.0);
+        _choice.assign(entries(), 0.0);
+
+        for (size_type i = 0; i < n; ++i)
+            for (size_type a = graph.offset(i); a < graph.offset(i + 1); ++a) {
+                double w = std::max(graph.weight(a), 1e-12);
+                _eta[entry(i, graph.target(a), a)] = std::pow(1.0 / w, beta);
+            }
+    }
+
+    inline void
+    PheromoneMatrix::evaporate(double rho, size_type first, size_type last) {
+        pheromone_detail::evaporate(_tau.data() + _rowStart[first], span(first, last), 1 - rho);
+    }
+
+    inline void
+    PheromoneMatrix::applyDeposits(size_type first, size_type last) {
+        size_type s = _rowStart[first];
+        pheromone_detail::deposit(_tau.data() + s, _delta.data() + s, span(first, last));
+    }
+
+    inline void
+    PheromoneMatrix::updateChoice(double alpha, size_type first, size_type last) {
+        size_type s = _rowStart[first];
+        pheromone_detail::choice(_tau.data() + s, _eta.data() + s, _choice.data() + s,
+                                 span(first, last), alpha);
+    }
+
+    inline void
+    PheromoneMatrix::update(double rho, double alpha, size_type first, size_type last) {
+        size_type s = _rowStart[first];
+        pheromone_detail::update(_tau.data() + s, _delta.data() + s, _eta.data() + s, _choice.data() + s,
+                                 span(first, last), 1 - rho, alpha);
+    }
+}
+
+#endif
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <cassert>
+
+#include "header.h"
+#include "csr_graph.h"
+#include "pheromone.h"
+
+typedef aco::CsrGraph::Link    link;
+
+// a small graph: a path 0 - 1 - 2 - 3 - 4 and a chord 0 - 4.
+aco::CsrGraph
+small(void) {
+    std::vector<link> links = { {0, 1, 1}, {1, 2, 2}, {2, 3, 4}, {3, 4, 0.5}, {0, 4, 8} };
+    return aco::CsrGraph(5, links);
+}
+
+bool aligned(const double* p) {
+    return reinterpret_cast<uintptr_t>(p) % 64 == 0;
+}
+
+void layout_test(void) {
+    aco::CsrGraph g = small();
+    aco::PheromoneMatrix dense(g, aco::PheromoneLayout::DENSE, 0.5, 2);
+    aco::PheromoneMatrix sparse(g, aco::PheromoneLayout::SPARSE, 0.5, 2);
+
+    // dense rows padded to 8 entries, each row aligned.
+    assert(dense.rows() == 5 && dense.entries() == 40);
+    for (aco::size_type i = 0; i < 5; ++i)
+        assert(aligned(dense.tau() + dense.rowStart(i)));
+    assert(aligned(dense.eta()) && aligned(dense.choice()));
+    assert(sparse.rows() == 5 && sparse.entries() == g.arcSize());
+    assert(aligned(sparse.tau()) && aligned(sparse.eta()) && aligned(sparse.choice()));
+
+    // eta = (1 / w)^beta on arcs, 0 elsewhere.
+    for (aco::size_type i = 0; i < 5; ++i)
+        for (aco::size_type j = 0; j < 5; ++j) {
+            aco::size_type a = g.findArc(i, j);
+            double eta = dense.eta()[dense.entry(i, j, a)];
+            if (a < 0) {
+                assert(eta == 0);
+                continue;
+            }
+            assert(std::fabs(eta - 1 / (g.weight(a) * g.weight(a))) < 1e-12);
+            assert(sparse.eta()[sparse.entry(i, j, a)] == eta);
+            assert(dense.tau()[dense.entry(i, j, a)] == 0.5);
+        }
+}
+
+// one round of updates on both layouts, against the arithmetic.
+void update_test(void) {
+    aco::CsrGraph g = small();
+    aco::PheromoneLayout layouts[] = { aco::PheromoneLayout::DENSE, aco::PheromoneLayout::SPARSE };
+
+    for (aco::PheromoneLayout layout : layouts) {
+        aco::PheromoneMatrix m(g, layout, 1.0, 1);
+        aco::PheromoneMatrix fused(g, layout, 1.0, 1);
+        aco::size_type a = g.findArc(2, 3), e = m.entry(2, 3, a);
+
+        m.deposit(e, 0.25);
+        m.deposit(e, 0.25);
+        fused.deposit(e, 0.5);
+        // queued deposits do not show before they are applied.
+        assert(m.tau()[e] == 1.0);
+
+        m.evaporate(0.5);
+        m.applyDeposits();
+        m.updateChoice(2);
+        fused.update(0.5, 2);
+        assert(m.tau()[e] == 1.0);
+        assert(m.choice()[e] == 1.0 * 1.0 / 4);
+        for (aco::size_type k = 0; k < m.entries(); ++k) {
+            assert(m.tau()[k] == fused.tau()[k]);
+            assert(m.choice()[k] == fused.choice()[k]);
+        }
+        aco::size_type b = g.findArc(0, 1);
+        assert(m.tau()[m.entry(0, 1, b)] == 0.5);
+
+        // the deposits were used up.
+        m.applyDeposits();
+        assert(m.tau()[e] == 1.0);
+
+        // a row range leaves the other rows alone.
+        m.evaporate(0.5, 2, 3);
+        assert(m.tau()[e] == 0.5);
+        assert(m.tau()[m.entry(0, 1, b)] == 0.5);
+    }
+}
+
+// the vector kernels against the scalar loops, at every tail length.
+void kernel_test(void) {
+    namespace d = aco::pheromone_detail;
+    std::mt19937_64 e(3);
+    std::uniform_real_distribution<double> u(0.01, 2);
+    double alphas[] = { 1, 2, 1.5 };
+
+    for (size_t n = 0; n < 40; ++n)
+        for (double alpha : alphas) {
+            std::vector<double> tau(n), delta(n), eta(n);
+            for (size_t i = 0; i < n; ++i) {
+                tau[i] = u(e);
+                delta[i] = u(e);
+                eta[i] = u(e);
+            }
+            std::vector<double> t1 = tau, t2 = tau, d1 = delta, d2 = delta;
+            std::vector<double> c1(n), c2(n);
+
+            d::evaporate(t1.data(), n, 0.9);
+            d::evaporate_scalar(t2.data(), n, 0.9);
+            d::deposit(t1.data(), d1.data(), n);
+            d::deposit_scalar(t2.data(), d2.data(), n);
+            d::choice(t1.data(), eta.data(), c1.data(), n, alpha);
+            d::choice_scalar(t2.data(), eta.data(), c2.data(), n, alpha);
+            assert(t1 == t2 && d1 == d2 && c1 == c2);
+            for (double x : d1)
+                assert(x == 0);
+
+            t1 = tau; t2 = tau; d1 = delta; d2 = delta;
+            d::update(t1.data(), d1.data(), eta.data(), c1.data(), n, 0.9, alpha);
+            d::update_scalar(t2.data(), d2.data(), eta.data(), c2.data(), n, 0.9, alpha);
+            assert(t1 == t2 && d1 == d2 && c1 == c2);
+        }
+}
+
+int main(void) {
+    layout_test();
+    update_test();
+    kernel_test();
+    std::cout << "all pheromone tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * A fixed pool of worker threads for data-parallel loops.
+ */
+
+#ifndef ACO_THREAD_POOL_H
+#define ACO_THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <algorithm>     // max()
+
+#include "header.h"
+
+namespace aco {
+    /* @class ThreadPool
+     * Workers are started once and sleep between jobs. parallelFor()
+     * hands out loop indices one at a time from a shared counter, so
+     * uneven iterations balance themselves, and the calling thread
+     * works alongside the pool until the loop is done.
+     */
+    class ThreadPool {
+    public:
+        // threads counts the caller; 0 means one per hardware thread.
+        explicit ThreadPool(unsigned threads = 0);
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        ~ThreadPool();
+
+        unsigned size() const { return static_cast<unsigned>(_workers.size()) + 1; }
+
+        /* @fn parallelFor
+         * f(i) for every i in [0, n), returning when all are done.
+         * The first exception thrown by f is rethrown here once the
+         * other calls have finished; indices not yet started by then
+         * are skipped.
+         */
+        void parallelFor(size_type n, const std::function<void(size_type)>& f);
+
+    private:
+        void work();
+        void loop();
+
+    private:
+        std::vector<std::thread>                   _workers;
+        std::mutex                                 _mutex;
+        std::condition_variable                    _wake;
+        std::condition_variable                    _done;
+        const std::function<void(size_type)>*      _job;
+        size_type                                  _n;
+        std::atomic<size_type>                     _next;
+        unsigned                                   _busy;
+        unsigned long                              _generation;
+        bool                                       _stop;
+        std::exception_ptr                         _error;
+    };
+
+    inline
+    ThreadPool::ThreadPool(unsigned threads)
+    : _job(nullptr), _n(0), _next(0), _busy(0), _generation(0), _stop(false) {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 1; i < threads; ++i)
+            _workers.push_back(std::thread(&ThreadPool::loop, this));
+    }
+
+    inline
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> l(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto& t : _workers)
+            t.join();
+    }
+
+    inline void
+    ThreadPool::work() {
+        for (size_type i; (i = _next.fetch_add(1)) < _n; ) {
+            try {
+                (*_job)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> l(_mutex);
+                if (!_error)
+                    _error = std::current_exception();
+                _next.store(_n);
+            }
+        }
+    }
+
+    inline void
+    ThreadPool::loop() {
+        unsigned long seen = 0;
+
+        for (;;) {
+            std::unique_lock<std::mutex> l(_mutex);
+            _wake.wait(l, [&] { return _stop || _generation != seen; });
+            if (_stop)
+                return;
+            seen = _generation;
+            l.unlock();
+            work();
+            l.lock();
+            if (--_busy == 0)
+                _done.notify_one();
+        }
+    }
+
+    inline void
+    ThreadPool::parallelFor(size_type n, const std::function<void(size_type)>& f) {
+        {
+            std::lock_guard<std::mutex> l(_mutex);
+            _job = &f;
+            _n = n;
+            _next.store(0);
+            _busy = static_cast<unsigned>(_workers.size());
+            _error = nullptr;
+            ++_generation;
+        }
+        _wake.notify_all();
+        work();
+
+        std::unique_lock<std::mutex> l(_mutex);
+        _done.wait(l, [this] { return _busy == 0; });
+        _job = nullptr;
+        if (_error)
+            std::rethrow_exception(_error);
+    }
+}
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ * Batches of short-lived my::vector<int> built by several threads
+ * at once, drawing either from the default malloc()-based allocator
+ * or from a per-thread my::arena released after every batch.
+ *
+ * build: g++ -std=c++14 -O2 -pthread arena_bench.cpp -o arena_bench
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+#include "vector.hpp"
+#include "allocator.hpp"
+
+typedef std::chrono::steady_clock    clock_type;
+
+static const size_t    batches = 200;
+static const size_t    per_batch = 2000;
+
+/* @fn work()
+ * One batch: per_batch vectors of 4 to 67 elements, all alive
+ * until the end of the batch, as a generation or episode would be.
+ */
+template <class Vec, class Alloc>
+long work(my::vector<Vec>& batch, const Alloc& alloc, unsigned seed) {
+    long    sum = 0;
+
+    for (size_t i = 0; i < per_batch; ++i) {
+        batch.emplace_back(alloc);
+        Vec &vec = batch.back();
+        size_t len = 4 + (seed = seed * 1103515245u + 12345u) % 64;
+        for (size_t j = 0; j < len; ++j)
+            vec.push_back(static_cast<int>(i + j));
+        sum += vec[len / 2];
+    }
+    return sum;
+}
+
+void run_default(long *out, unsigned seed) {
+    typedef my::vector<int>    vec_t;
+    long    sum = 0;
+
+    for (size_t b = 0; b < batches; ++b) {
+        my::vector<vec_t>    batch;
+        batch.reserve(per_batch);
+        sum += work(batch, my::allocator<int>(), seed + b);
+    }
+    *out = sum;
+}
+
+void run_arena(long *out, unsigned seed) {
+    typedef my::vector<int, my::arena_allocator<int>>    vec_t;
+    thread_local my::arena    ar(1 << 20);
+    long                      sum = 0;
+
+    for (size_t b = 0; b < batches; ++b) {
+        {
+            my::vector<vec_t>    batch;
+            batch.reserve(per_batch);
+            sum += work(batch, my::arena_allocator<int>(ar), seed + b);
+        }
+        ar.release();
+    }
+    *out = sum;
+}
+
+double measure(void (*fn)(long*, unsigned), unsigned threads, long *check) {
+    my::vector<std::thread>    pool;
+    my::vector<long>           sums(threads, 0);
+    auto                       start = clock_type::now();
+
+    for (unsigned t = 0; t < threads; ++t)
+        pool.emplace_back(fn, &sums[t], t);
+    for (auto &th : pool)
+        th.join();
+
+    *check = 0;
+    for (auto s : sums)
+        *check += s;
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+int
+main(void) {
+    std::cout << "cores: " << std::thread::hardware_concurrency()
+              << ", " << batches << " batches x " << per_batch
+              << " vectors per thread" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "default ms"
+              << std::setw(14) << "arena ms" << std::setw(10) << "speedup"
+              << std::setw(16) << "arena Mvec/s" << std::endl;
+
+    for (unsigned threads = 1; threads <= 8; threads *= 2) {
+        long     c1, c2;
+        double   d = measure(run_default, threads, &c1);
+        double   a = measure(run_arena, threads, &c2);
+
+        if (c1 != c2)
+            std::cout << "checksum mismatch" << std::endl;
+        std::cout << std::setw(8) << threads << std::fixed << std::setprecision(1)
+                  << std::setw(14) << d << std::setw(14) << a
+                  << std::setw(10) << std::setprecision(2) << d / a
+                  << std::setw(16) << threads * batches * per_batch / a / 1000.0
+                  << std::endl;
+    }
+
+    return 0;
+}
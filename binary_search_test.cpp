@@ -1,7 +1,268 @@
 #include <random>
 #include <ctime>
+#include <set>
+#include <cmath>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <functional>
 #include "binary_search_tree.hpp"
 
+template <class Tree>
+void lookup_test(const Tree& tree, const std::set<int>& ref) {
+    for (int k = -5; k < 2010; ++k) {
+        assert(tree.contains(k) == (ref.count(k) == 1));
+        auto it = tree.find(k);
+        assert(it == tree.end() ? !ref.count(k) : *it == k);
+
+        auto lb = tree.lower_bound(k), ub = tree.upper_bound(k);
+        assert(lb == tree.end() ? ref.lower_bound(k) == ref.end() : *lb == *ref.lower_bound(k));
+        assert(ub == tree.end() ? ref.upper_bound(k) == ref.end() : *ub == *ref.upper_bound(k));
+        assert(tree.equal_range(k).first == lb && tree.equal_range(k).second == ub);
+    }
+
+    std::vector<int> got;
+    tree.for_each_in_range(100, 300, [&got](int k) {got.push_back(k);});
+    assert(std::equal(got.begin(), got.end(), ref.lower_bound(100), ref.lower_bound(300)));
+    got.clear();
+    tree.for_each_in_range(300, 100, [&got](int k) {got.push_back(k);});
+    assert(got.empty());
+}
+
+/*
+ * Random inserts and removes checked against std::set, then the
+ * orders that degrade an unbalanced tree.
+ */
+template <class Tree>
+void churn_test(unsigned seed) {
+    std::default_random_engine e(seed);
+    std::uniform_int_distribution<int> u(0, 2000);
+    Tree tree;
+    std::set<int> ref;
+
+    for (int i = 0; i < 20000; ++i) {
+        int k = u(e);
+        if (u(e) % 3 == 0) {
+            tree.remove(k);
+            ref.erase(k);
+        } else {
+            tree.insert(k);
+            ref.insert(k);
+        }
+        assert(tree.size() == ref.size());
+    }
+    assert(std::equal(tree.begin(), tree.end(), ref.begin(), ref.end()));
+    assert(std::equal(std::make_reverse_iterator(tree.end()),
+                      std::make_reverse_iterator(tree.begin()), ref.rbegin(), ref.rend()));
+    lookup_test(tree, ref);
+
+    Tree copy(tree);
+    assert(std::equal(copy.begin(), copy.end(), ref.begin(), ref.end()));
+    assert(copy.size() == tree.size() && copy.height() == tree.height());
+    tree = std::move(copy);
+    assert(tree.size() == ref.size() && copy.size() == 0);
+}
+
+void balance_test(void) {
+    my::binary_search_tree<int, my::avl_balance> sorted, zigzag;
+    my::binary_search_tree<int> plain;
+    const int n = 100000;
+
+    for (int i = 0; i < n; ++i) {
+        sorted.insert(i);
+        zigzag.insert(i % 2 ? n - i : i);
+    }
+    for (int i = 0; i < 1000; ++i)
+        plain.insert(i);
+
+    double bound = 1.45 * std::log2(n + 2.0);
+    assert(sorted.height() <= bound && zigzag.height() <= bound);
+    assert(plain.height() == 1000);
+
+    for (int i = 0; i < n; i += 2)
+        sorted.remove(i);
+    assert(sorted.size() == n / 2 && sorted.height() <= bound);
+}
+
+/*
+ * Sorted input makes an unbalanced tree a list as deep as it is
+ * long; copying, measuring and removing must not recurse on it.
+ */
+void deep_test(void) {
+    my::binary_search_tree<std::string> tree;
+    const int n = 20000;
+
+    for (int i = 0; i < n; ++i)
+        tree.insert(std::string(1, 'k') + std::to_string(100000 + i));
+    assert(tree.height() == n);
+
+    my::binary_search_tree<std::string> copy(tree);
+    assert(copy.height() == n);
+    assert(std::equal(copy.begin(), copy.end(), tree.begin(), tree.end()));
+    for (int i = 0; i < n; i += 2)
+        copy.remove(std::string(1, 'k') + std::to_string(100000 + i));
+    assert(copy.size() == n / 2 && copy.height() == n / 2);
+    tree = copy;
+    assert(tree.size() == n / 2);
+}
+
+/*
+ * Sorted bulk loads, from forward and input ranges with repeats,
+ * come out perfectly balanced and then behave like any other tree.
+ */
+template <class Tree>
+void bulk_test(void) {
+    std::vector<int> keys;
+    std::set<int> ref;
+    for (int i = 0; i < 3000; ++i) {
+        keys.push_back(i / 3 * 2);
+        ref.insert(i / 3 * 2);
+    }
+
+    Tree tree(keys.begin(), keys.end());
+    assert(tree.size() == 1000 && tree.height() == 10);
+    assert(std::equal(tree.begin(), tree.end(), ref.begin(), ref.end()));
+    lookup_test(tree, ref);
+    for (int i = 1; i < 2000; i += 4) {
+        tree.insert(i);
+        ref.insert(i);
+        tree.remove(i + 1);
+        ref.erase(i + 1);
+    }
+    lookup_test(tree, ref);
+
+    auto out = tree.to_sorted_vector();
+    assert(out.size() == ref.size() && std::equal(out.begin(), out.end(), ref.begin()));
+
+    std::istringstream in("1 2 2 3 5 8 13");
+    tree.assign_sorted(std::istream_iterator<int>(in), std::istream_iterator<int>());
+    assert(tree.size() == 6 && tree.height() == 3 && *--tree.end() == 13);
+
+    std::vector<int> unsorted = {1, 3, 2};
+    try {
+        tree.assign_sorted(unsorted.begin(), unsorted.end());
+        assert(false);
+    } catch (std::invalid_argument&) {
+        assert(tree.empty() && tree.begin() == tree.end());
+    }
+    tree.assign_sorted(unsorted.begin(), unsorted.begin());
+    assert(tree.empty() && tree.height() == 0);
+}
+
+// select() and rank() against positions in a std::set.
+template <class Tree>
+void order_test(unsigned seed) {
+    std::default_random_engine e(seed);
+    std::uniform_int_distribution<int> u(0, 2000);
+    Tree tree;
+    std::set<int> ref;
+
+    for (int i = 0; i < 20000; ++i) {
+        int k = u(e);
+        if (i % 3 == 2) {
+            tree.remove(k);
+            ref.erase(k);
+        } else {
+            tree.insert(k);
+            ref.insert(k);
+        }
+    }
+    Tree copy(tree);
+    std::vector<int> sorted(ref.begin(), ref.end());
+    for (size_t i = 0; i < sorted.size(); ++i)
+        assert(*tree.select(i) == sorted[i] && *copy.select(i) == sorted[i]);
+    assert(tree.select(sorted.size()) == tree.end());
+    for (int k = -1; k <= 2001; ++k)
+        assert(tree.rank(k) == size_t(std::distance(ref.begin(), ref.lower_bound(k))));
+
+    Tree bulk(sorted.begin(), sorted.end());
+    for (size_t i = 0; i < sorted.size(); i += 7)
+        assert(*bulk.select(i) == sorted[i] && bulk.rank(sorted[i]) == i);
+}
+
+// counts its calls, to bound the comparisons per descent.
+struct counting_less {
+    static long calls;
+    bool operator()(int a, int b) const {++calls; return a < b;}
+};
+long counting_less::calls = 0;
+
+/* @struct by_id
+ * Orders records by id and also compares them with bare ids; an
+ * int cannot become a record, so lookups by id must go through the
+ * transparent overloads.
+ */
+struct record {
+    int            id;
+    std::string    name;
+};
+struct by_id {
+    typedef void is_transparent;
+    bool operator()(const record& a, const record& b) const {return a.id < b.id;}
+    bool operator()(const record& a, int b) const {return a.id < b;}
+    bool operator()(int a, const record& b) const {return a < b.id;}
+};
+
+void compare_test(void) {
+    my::binary_search_tree<int, my::avl_balance, std::greater<int>> desc{3, 1, 4, 1, 5, 9, 2, 6};
+    std::vector<int> got(desc.begin(), desc.end());
+    assert((got == std::vector<int>{9, 6, 5, 4, 3, 2, 1}));
+    assert(*desc.lower_bound(7) == 6 && *desc.upper_bound(6) == 5 && !desc.contains(7));
+    desc.remove(9);
+    assert(*desc.begin() == 6);
+
+    my::binary_search_tree<int, my::avl_balance, counting_less> tree;
+    for (int i = 0; i < 4095; ++i)
+        tree.insert(i * 2);
+    long h = static_cast<long>(tree.height());
+    for (int k = -1; k < 8200; ++k) {
+        counting_less::calls = 0;
+        assert(tree.contains(k) == (k >= 0 && k % 2 == 0 && k < 8190));
+        assert(counting_less::calls <= h + 1);
+    }
+    counting_less::calls = 0;
+    tree.insert(100);
+    assert(counting_less::calls <= h + 1 && tree.size() == 4095);
+
+    my::binary_search_tree<std::string, my::counted<my::avl_balance>, std::less<>> words;
+    for (const char *w : {"pear", "apple", "fig", "plum", "kiwi"})
+        words.insert(w);
+    assert(words.contains("fig") && !words.contains("grape"));
+    assert(*words.find("kiwi") == "kiwi" && words.find("lime") == words.end());
+    assert(*words.lower_bound("grape") == "kiwi" && *words.upper_bound("pear") == "plum");
+    assert(words.equal_range("plum").first == words.find("plum"));
+    assert(words.rank("lime") == 3);
+
+    my::binary_search_tree<record, my::avl_balance, by_id> people;
+    people.insert(record{7, "ann"});
+    people.insert(record{3, "bob"});
+    people.insert(record{3, "dup"});
+    assert(people.size() == 2 && people.find(3)->name == "bob" && !people.contains(5));
+    assert(people.lower_bound(4)->id == 7 && people.upper_bound(7) == people.end());
+}
+
+// string keys have destructors to run before the slabs go back.
+void string_test(void) {
+    my::binary_search_tree<std::string, my::avl_balance> tree;
+
+    for (int i = 0; i < 5000; ++i)
+        tree.insert("a key long enough to allocate " + std::to_string(i % 3000));
+    for (int i = 0; i < 3000; i += 3)
+        tree.remove("a key long enough to allocate " + std::to_string(i));
+    assert(tree.size() == 2000);
+
+    my::binary_search_tree<std::string, my::avl_balance> copy(tree);
+    tree.clear();
+    assert(tree.size() == 0 && tree.height() == 0);
+    tree.insert("reused");
+    copy = tree;
+    assert(copy.size() == 1);
+}
+
 int
 main(void) {
     std::default_random_engine e(std::time(0));
@@ -14,5 +275,18 @@ main(void) {
 
     bst.print();
 
+    churn_test<my::binary_search_tree<int>>(1);
+    churn_test<my::binary_search_tree<int, my::avl_balance>>(2);
+    balance_test();
+    string_test();
+    deep_test();
+    bulk_test<my::binary_search_tree<int>>();
+    bulk_test<my::binary_search_tree<int, my::avl_balance>>();
+    order_test<my::binary_search_tree<int, my::counted<>>>(3);
+    order_test<my::binary_search_tree<int, my::counted<my::avl_balance>>>(4);
+    churn_test<my::binary_search_tree<int, my::counted<my::avl_balance>>>(5);
+    compare_test();
+    std::cout << "binary_search_tree tests passed" << std::endl;
+
     return 0;
 }
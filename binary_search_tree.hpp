@@ -5,29 +5,187 @@
 #include <cstddef>  // size_t
 #include <utility>  // move()
 #include <initializer_list>
+#include <iterator>  // bidirectional_iterator_tag
+#include <algorithm> // max()
+#include <type_traits>
+#include <stdexcept>  // invalid_argument
+#include <functional> // less
+
+#include "node_pool.hpp"
+#include "vector.hpp"
 
 namespace my {
-    template <typename T>
+    /*
+     * Balancing policies for binary_search_tree. A policy adds its
+     * bookkeeping to every node through node_base, and fix(nd)
+     * restores its invariant at nd once both subtrees satisfy it,
+     * pointing nd at the new root of that subtree. After an update
+     * the tree calls fix() from the changed node up the parent
+     * links, until fix() returns false to say nothing above can have
+     * changed.
+     * Trees whose policy has rebalances false skip all of this.
+     */
+    struct unbalanced {
+        struct node_base {};
+        static const bool rebalances = false;
+
+        template <class Node>
+        static bool fix(Node *&) { return false; }
+    };
+
+    /* @struct avl_balance
+     * AVL trees: subtree heights differ by at most one, so the
+     * height stays below 1.45 log2(n + 2) whatever the insertion
+     * order, and every operation is O(log n).
+     */
+    struct avl_balance {
+        struct node_base {
+            int    height = 1;
+        };
+        static const bool rebalances = true;
+
+        template <class Node>
+        static bool fix(Node *&nd);
+
+    private:
+        template <class Node>
+        static int height(const Node *nd) { return nd ? nd->height : 0; }
+        template <class Node>
+        static void update(Node *nd) {
+            nd->height = 1 + std::max(height(nd->left), height(nd->right));
+        }
+        template <class Node>
+        static Node* rotate_left(Node *nd);
+        template <class Node>
+        static Node* rotate_right(Node *nd);
+    };
+
+    // the caller points the link above at the returned node.
+    template <class Node>
+    Node*
+    avl_balance::rotate_left(Node *nd) {
+        Node *r = nd->right;
+
+        nd->right = r->left;
+        if (r->left)
+            r->left->parent = nd;
+        r->left = nd;
+        r->parent = nd->parent;
+        nd->parent = r;
+        update(nd);
+        update(r);
+        return r;
+    }
+
+    template <class Node>
+    Node*
+    avl_balance::rotate_right(Node *nd) {
+        Node *l = nd->left;
+
+        nd->left = l->right;
+        if (l->right)
+            l->right->parent = nd;
+        l->right = nd;
+        l->parent = nd->parent;
+        nd->parent = l;
+        update(nd);
+        update(l);
+        return l;
+    }
+
+    // ancestors only look at heights, so an unchanged one ends the fix-up.
+    template <class Node>
+    bool
+    avl_balance::fix(Node *&nd) {
+        int old = nd->height;
+        int bf = height(nd->left) - height(nd->right);
+
+        if (bf > 1) {
+            if (height(nd->left->left) < height(nd->left->right))
+                nd->left = rotate_left(nd->left);
+            nd = rotate_right(nd);
+        } else if (bf < -1) {
+            if (height(nd->right->right) < height(nd->right->left))
+                nd->right = rotate_right(nd->right);
+            nd = rotate_left(nd);
+        } else {
+            update(nd);
+        }
+        return nd->height != old;
+    }
+
+    /* @struct counted
+     * Order statistics on top of another policy: every node also
+     * keeps the size of its subtree, which gives the tree select()
+     * and rank() in O(height). Each update recounts its whole path
+     * to the root. This relies on Balance::fix() relinking nothing
+     * deeper than the children of the subtree root it leaves in nd,
+     * which holds for rotations.
+     */
+    template <class Balance = unbalanced>
+    struct counted {
+        struct node_base: Balance::node_base {
+            size_t    count = 1;
+        };
+        static const bool rebalances = true;
+
+        template <class Node>
+        static bool fix(Node *&nd) {
+            Balance::fix(nd);
+            recount(nd->left);
+            recount(nd->right);
+            recount(nd);
+            return true;
+        }
+
+        template <class Node>
+        static size_t count(const Node *nd) { return nd ? nd->count : 0; }
+
+    private:
+        template <class Node>
+        static void recount(Node *nd) {
+            if (nd)
+                nd->count = 1 + count(nd->left) + count(nd->right);
+        }
+    };
+
+    template <class Balance>
+    struct is_counted: std::false_type {};
+    template <class Balance>
+    struct is_counted<counted<Balance>>: std::true_type {};
+
+    /* @class binary_search_tree
+     * An ordered set. Keys are ordered by Compare, a strict weak
+     * ordering called once per level: a descent only decides left or
+     * right, and the one candidate it ends on is checked for
+     * equality at the bottom. With a transparent Compare such as
+     * std::less<>, lookups take any type comparable with the keys,
+     * so a std::string set can be probed with a const char* or a
+     * std::string_view without building a std::string.
+     */
+    template <typename T, class Balance = unbalanced, class Compare = std::less<T>>
     class binary_search_tree {
     public:
         typedef T          value_type;
         typedef size_t     size_type;
+        typedef Balance    balance_policy;
+        typedef Compare    key_compare;
     private:
-        struct node {
+        struct node: Balance::node_base {
             value_type     key;
             node*          left;
             node*          right;
+            node*          parent;
 
             // constructors.
-            node(const value_type &k = value_type(), 
+            node(const value_type &k = value_type(), node* p = nullptr,
+                 node* l = nullptr, node* r = nullptr)
+            : key(k), left(l), right(r), parent(p) {}
+            node(value_type&& k, node* p = nullptr,
                  node* l = nullptr, node* r = nullptr)
-            : key(k), left(l), right(r) {}
-            node(value_type&& k, node* l = nullptr, 
-                 node* r = nullptr)
-            : key(std::move(k)), left(l), right(r) {}
+            : key(std::move(k)), left(l), right(r), parent(p) {}
             node(const node &nd) = delete;
             node(node &&nd) = delete;
-            ~node() {left = right = nullptr;}
 
             // operations.
             node& operator=(const node& nd) = delete;
@@ -35,12 +193,51 @@ namespace my {
         };
 
     public:
+        /* @class const_iterator
+         * In-order iterator. Stepping follows parent links, so a
+         * full walk is O(n) without recursion or a stack; end() is
+         * the null node, and --end() finds the largest key. Keys
+         * cannot be changed through an iterator, since that could
+         * break the ordering.
+         */
+        class const_iterator {
+        public:
+            typedef std::bidirectional_iterator_tag    iterator_category;
+            typedef T                                  value_type;
+            typedef std::ptrdiff_t                     difference_type;
+            typedef const T*                           pointer;
+            typedef const T&                           reference;
+
+            const_iterator(): nd(nullptr), tree(nullptr) {}
+
+            reference operator*() const {return nd->key;}
+            pointer operator->() const {return &nd->key;}
+            const_iterator& operator++();
+            const_iterator& operator--();
+            const_iterator operator++(int) {const_iterator it = *this; ++*this; return it;}
+            const_iterator operator--(int) {const_iterator it = *this; --*this; return it;}
+
+            bool operator==(const const_iterator& it) const {return nd == it.nd;}
+            bool operator!=(const const_iterator& it) const {return nd != it.nd;}
+
+        private:
+            friend class binary_search_tree;
+            const_iterator(const node* n, const binary_search_tree* t): nd(n), tree(t) {}
+
+            const node                  *nd;
+            const binary_search_tree    *tree;
+        };
+        typedef const_iterator    iterator;
+
         // constructors.
         binary_search_tree(): root(nullptr), _size(0) {}
+        explicit binary_search_tree(const Compare& c): root(nullptr), _size(0), comp(c) {}
         binary_search_tree(const binary_search_tree& bst);
         binary_search_tree(binary_search_tree&& bst);
-        binary_search_tree(std::initializer_list<value_type> il);
-        ~binary_search_tree() {destroy_subtree(root);}
+        binary_search_tree(std::initializer_list<value_type> il, const Compare& c = Compare());
+        template <class Iter>
+        binary_search_tree(Iter sorted_first, Iter sorted_last, const Compare& c = Compare());
+        ~binary_search_tree() {clear();}
 
         // operators.
         binary_search_tree &operator=(const binary_search_tree& bst);
@@ -50,219 +247,596 @@ namespace my {
         void insert(const value_type& k);
         void insert(value_type&& k);
         void remove(const value_type& k);
-        void print(void) const {print_subtree(root, 0);}
+        void clear(void);
+        void print(void) const;
+
+        /*
+         * Bulk load and export. assign_sorted() replaces the keys
+         * with an ascending range (repeats are kept once, a key out
+         * of order throws std::invalid_argument) and builds a
+         * perfectly balanced tree in O(n), its nodes side by side in
+         * one slab when the range can be measured up front.
+         * to_sorted_vector() copies the keys out in order, O(n).
+         */
+        template <class Iter>
+        void assign_sorted(Iter sorted_first, Iter sorted_last);
+        vector<value_type> to_sorted_vector(void) const;
 
         size_type size(void) const {return _size;}
+        size_type height(void) const;
+        bool empty(void) const {return _size == 0;}
+        key_compare key_comp(void) const {return comp;}
+        // bytes held for the nodes.
+        size_t bytes(void) const {return pool.bytes();}
+
+        // iterators.
+        const_iterator begin(void) const {
+            return const_iterator(root ? find_min_node(root) : nullptr, this);
+        }
+        const_iterator end(void) const {return const_iterator(nullptr, this);}
+
+        /*
+         * Lookups. lower_bound() is the first key not less than k,
+         * upper_bound() the first key greater than k; each is one
+         * descent. The templates take keys of other types when
+         * Compare is transparent.
+         */
+        const_iterator find(const value_type& k) const {
+            return const_iterator(find_node(k), this);
+        }
+        template <class K, class C = Compare, class = typename C::is_transparent>
+        const_iterator find(const K& k) const {
+            return const_iterator(find_node(k), this);
+        }
+        bool contains(const value_type& k) const {return find_node(k) != nullptr;}
+        template <class K, class C = Compare, class = typename C::is_transparent>
+        bool contains(const K& k) const {return find_node(k) != nullptr;}
+        const_iterator lower_bound(const value_type& k) const {
+            return const_iterator(lower_node(k), this);
+        }
+        template <class K, class C = Compare, class = typename C::is_transparent>
+        const_iterator lower_bound(const K& k) const {
+            return const_iterator(lower_node(k), this);
+        }
+        const_iterator upper_bound(const value_type& k) const {
+            return const_iterator(upper_node(k), this);
+        }
+        template <class K, class C = Compare, class = typename C::is_transparent>
+        const_iterator upper_bound(const K& k) const {
+            return const_iterator(upper_node(k), this);
+        }
+        std::pair<const_iterator, const_iterator> equal_range(const value_type& k) const {
+            return std::make_pair(lower_bound(k), upper_bound(k));
+        }
+        template <class K, class C = Compare, class = typename C::is_transparent>
+        std::pair<const_iterator, const_iterator> equal_range(const K& k) const {
+            return std::make_pair(lower_bound(k), upper_bound(k));
+        }
+
+        /*
+         * f(key) for every key in [lo, hi), in order: one descent to
+         * lo, then successor steps, O(log n + k) for k keys.
+         */
+        template <class F>
+        void for_each_in_range(const value_type& lo, const value_type& hi, F f) const;
+
+        /*
+         * Order statistics, for counted<> policies only: select(i)
+         * is the i-th smallest key, counting from 0, or end() if
+         * there are not that many; rank(k) is the number of keys
+         * less than k. Both are one descent.
+         */
+        const_iterator select(size_type i) const;
+        size_type rank(const value_type& k) const {return rank_of(k);}
+        template <class K, class C = Compare, class = typename C::is_transparent>
+        size_type rank(const K& k) const {return rank_of(k);}
 
     private:
-        node* recursive_copy_subtree(const node* rt);
-        node* destroy_subtree(node* rt);
-        void print_subtree(const node* rt, size_type depth) const;
+        template <class K>
+        void insert_key(K&& k);
+        void retrace(node* nd);
+        // the root pointer or the child field of nd's parent.
+        node** link_to(node* nd) {
+            if (nd->parent == nullptr)
+                return &root;
+            return nd == nd->parent->left ? &nd->parent->left : &nd->parent->right;
+        }
+
+        /*
+         * Nodes live in the tree's own pool: removed ones are reused
+         * first, and clear() hands back whole slabs.
+         */
+        template <class... Args>
+        node* make_node(Args&&... args);
+        void drop_node(node* nd) {nd->~node(); pool.deallocate(nd);}
+
+        /*
+         * Whole-tree walks follow the parent links instead of
+         * recursing, so a degenerate unbalanced tree of any depth
+         * cannot overflow the stack.
+         */
+        void copy_tree(const node* rt);
+        void destroy_tree(void);
+        node* build_balanced(node*& list, size_type n, node* pa);
+        template <class F>
+        void walk_with_depth(F f) const;
         void print_n_space(size_type n) const;
-        node* find_parent(const node* nd) const;
-        node* find_node(const value_type& k) const;
-        node* find_min_node(const node* rt) const;
-        node* find_max_node(const node* rt) const;
+        template <class K>
+        node* find_node(const K& k) const;
+        template <class K>
+        node* lower_node(const K& k) const;
+        template <class K>
+        const node* upper_node(const K& k) const;
+        template <class K>
+        size_type rank_of(const K& k) const;
+        static const node* find_min_node(const node* rt);
+        static const node* find_max_node(const node* rt);
     private:
-        node*         root;
-        size_type     _size;
+        node*              root;
+        size_type          _size;
+        node_pool<node>    pool;
+        Compare            comp;
     };
 
-    template <typename T>
-    binary_search_tree<T>::binary_search_tree(const binary_search_tree& bst) {
-        if (root == bst.root)
-            return;
-        root = destroy_subtree(root);
-        root = recursive_copy_subtree(bst.root);
-        _size = bst._size;
+    template <typename T, class Balance, class Compare>
+    binary_search_tree<T, Balance, Compare>::binary_search_tree(const binary_search_tree& bst)
+    : root(nullptr), _size(0), comp(bst.comp) {
+        copy_tree(bst.root);
     }
 
-    template <typename T>
-    binary_search_tree<T>::binary_search_tree(binary_search_tree&& bst)
-    : root(bst.root), _size(bst.size()) {
+    template <typename T, class Balance, class Compare>
+    binary_search_tree<T, Balance, Compare>::binary_search_tree(binary_search_tree&& bst)
+    : root(bst.root), _size(bst.size()), pool(std::move(bst.pool)), comp(bst.comp) {
         bst.root = nullptr;
         bst._size = 0;
     }
 
-    template <typename T>
-    binary_search_tree<T>::binary_search_tree(std::initializer_list<T> il)
-    : root(nullptr), _size(0) {
+    template <typename T, class Balance, class Compare>
+    binary_search_tree<T, Balance, Compare>::binary_search_tree(std::initializer_list<T> il,
+                                                                const Compare& c)
+    : root(nullptr), _size(0), comp(c) {
         for (auto &i : il)
             insert(i);
     }
 
-    template <typename T>
-    typename binary_search_tree<T>::node *
-    binary_search_tree<T>::destroy_subtree(node* rt) {
-        if (rt == nullptr)
-            return nullptr;
-        --_size;
-        rt->left = destroy_subtree(rt->left);
-        rt->right = destroy_subtree(rt->right);
-        delete rt;
-        return nullptr;
+    template <typename T, class Balance, class Compare>
+    template <class Iter>
+    binary_search_tree<T, Balance, Compare>::binary_search_tree(Iter sorted_first, Iter sorted_last,
+                                                                const Compare& c)
+    : root(nullptr), _size(0), comp(c) {
+        assign_sorted(sorted_first, sorted_last);
     }
 
-    template <typename T>
-    typename binary_search_tree<T>::node *
-    binary_search_tree<T>::recursive_copy_subtree(const node* rt) {
-        if (rt == nullptr)
-            return nullptr;
-        ++_size;
-        return new node(rt->key, recursive_copy_subtree(rt->left), 
-                                 recursive_copy_subtree(rt->right));
+    template <typename T, class Balance, class Compare>
+    typename binary_search_tree<T, Balance, Compare>::const_iterator &
+    binary_search_tree<T, Balance, Compare>::const_iterator::operator++() {
+        if (nd->right != nullptr) {
+            nd = find_min_node(nd->right);
+            return *this;
+        }
+        // climb until we come up from a left child.
+        const node *pa = nd->parent;
+        while (pa != nullptr && nd == pa->right) {
+            nd = pa;
+            pa = pa->parent;
+        }
+        nd = pa;
+        return *this;
     }
 
-    template <typename T>
-    binary_search_tree<T> &
-    binary_search_tree<T>::operator=(const binary_search_tree& bst) {
-        if (root == bst.root)
+    template <typename T, class Balance, class Compare>
+    typename binary_search_tree<T, Balance, Compare>::const_iterator &
+    binary_search_tree<T, Balance, Compare>::const_iterator::operator--() {
+        if (nd == nullptr) {
+            nd = find_max_node(tree->root);
             return *this;
-        root = destroy_subtree(root);
-        root = recursive_copy_subtree(bst.root);
-        _size = bst._size;
+        }
+        if (nd->left != nullptr) {
+            nd = find_max_node(nd->left);
+            return *this;
+        }
+        const node *pa = nd->parent;
+        while (pa != nullptr && nd == pa->left) {
+            nd = pa;
+            pa = pa->parent;
+        }
+        nd = pa;
         return *this;
     }
 
-    template <typename T>
-    binary_search_tree<T> &
-    binary_search_tree<T>::operator=(binary_search_tree&& bst) {
-        root = bst.root;
-        _size = bst._size;
+    template <typename T, class Balance, class Compare>
+    template <class K>
+    typename binary_search_tree<T, Balance, Compare>::node *
+    binary_search_tree<T, Balance, Compare>::lower_node(const K& k) const {
+        node *nd = root, *best = nullptr;
 
-        bst.root = nullptr;
-        bst._size = 0;
+        while (nd != nullptr)
+            if (comp(nd->key, k)) {
+                nd = nd->right;
+            } else {
+                best = nd;
+                nd = nd->left;
+            }
+        return best;
     }
 
-    template <typename T>
+    template <typename T, class Balance, class Compare>
+    template <class K>
+    const typename binary_search_tree<T, Balance, Compare>::node *
+    binary_search_tree<T, Balance, Compare>::upper_node(const K& k) const {
+        const node *nd = root, *best = nullptr;
+
+        while (nd != nullptr)
+            if (comp(k, nd->key)) {
+                best = nd;
+                nd = nd->left;
+            } else {
+                nd = nd->right;
+            }
+        return best;
+    }
+
+    template <typename T, class Balance, class Compare>
+    template <class F>
     void
-    binary_search_tree<T>::insert(const value_type& k) {
-        node *nd = root;
-        if (root == nullptr) {
-            root = new node(k);
-            ++_size;
-            return;
+    binary_search_tree<T, Balance, Compare>::for_each_in_range(const value_type& lo,
+                                                      const value_type& hi, F f) const {
+        for (const_iterator it = lower_bound(lo), e = end(); it != e && comp(*it, hi); ++it)
+            f(*it);
+    }
+
+    template <typename T, class Balance, class Compare>
+    typename binary_search_tree<T, Balance, Compare>::const_iterator
+    binary_search_tree<T, Balance, Compare>::select(size_type i) const {
+        static_assert(is_counted<Balance>::value, "select() needs a counted<> policy");
+        const node *nd = root;
+
+        while (nd != nullptr) {
+            size_type left = Balance::count(nd->left);
+            if (i < left) {
+                nd = nd->left;
+            } else if (i == left) {
+                break;
+            } else {
+                i -= left + 1;
+                nd = nd->right;
+            }
         }
-        while (true) {
-            if (k > nd->key)
-                if (nd->right == nullptr) {
-                    nd->right = new node(k);
-                    ++_size;
-                    return;
-                } else {
-                    nd = nd->right;
-                }
-            else if (k < nd->key)
-                if (nd->left == nullptr) {
-                    nd->left = new node(k);
-                    ++_size;
-                    return;
-                } else {
-                    nd = nd->left;
-                }
-            else
-                return;
+        return const_iterator(nd, this);
+    }
+
+    template <typename T, class Balance, class Compare>
+    template <class K>
+    typename binary_search_tree<T, Balance, Compare>::size_type
+    binary_search_tree<T, Balance, Compare>::rank_of(const K& k) const {
+        static_assert(is_counted<Balance>::value, "rank() needs a counted<> policy");
+        const node    *nd = root;
+        size_type     r = 0;
+
+        while (nd != nullptr)
+            if (comp(nd->key, k)) {
+                r += Balance::count(nd->left) + 1;
+                nd = nd->right;
+            } else {
+                nd = nd->left;
+            }
+        return r;
+    }
+
+    template <typename T, class Balance, class Compare>
+    template <class... Args>
+    typename binary_search_tree<T, Balance, Compare>::node *
+    binary_search_tree<T, Balance, Compare>::make_node(Args&&... args) {
+        void *p = pool.allocate();
+
+        try {
+            return ::new (p) node(std::forward<Args>(args)...);
+        } catch (...) {
+            pool.deallocate(p);
+            throw;
         }
     }
 
-    template <typename T>
+    /*
+     * Post-order by parent links: a node is destroyed once both its
+     * children are gone, after unhooking it from its parent. Only
+     * the destructors run; the memory goes back with the slabs.
+     */
+    template <typename T, class Balance, class Compare>
     void
-    binary_search_tree<T>::insert(value_type&& k) {
+    binary_search_tree<T, Balance, Compare>::destroy_tree(void) {
         node *nd = root;
-        if (root == nullptr) {
-            root = new node(std::move(k));
-            ++_size;
-            return;
+
+        while (nd != nullptr) {
+            if (nd->left != nullptr) {
+                nd = nd->left;
+            } else if (nd->right != nullptr) {
+                nd = nd->right;
+            } else {
+                node *pa = nd->parent;
+                if (pa != nullptr)
+                    (nd == pa->left ? pa->left : pa->right) = nullptr;
+                nd->~node();
+                nd = pa;
+            }
         }
-        while (true) {
-            if (k > nd->key)
-                if (nd->right == nullptr) {
-                    nd->right = new node(std::move(k));
-                    ++_size;
-                    return;
+        root = nullptr;
+    }
+
+    template <typename T, class Balance, class Compare>
+    void
+    binary_search_tree<T, Balance, Compare>::clear(void) {
+        if (!std::is_trivially_destructible<value_type>::value)
+            destroy_tree();
+        pool.release();
+        root = nullptr;
+        _size = 0;
+    }
+
+    /*
+     * Pre-order by parent links in both trees at once: a missing
+     * child in the copy marks a subtree still to be copied. The
+     * copy is hooked to root as it grows, so clear() can undo it if
+     * a key's copy throws. Nodes come out of the pool in pre-order,
+     * next to each other.
+     */
+    template <typename T, class Balance, class Compare>
+    void
+    binary_search_tree<T, Balance, Compare>::copy_tree(const node* rt) {
+        if (rt == nullptr)
+            return;
+        try {
+            root = make_node(rt->key);
+            static_cast<typename Balance::node_base&>(*root) = *rt;
+            ++_size;
+
+            const node *src = rt;
+            node *dst = root;
+            while (src != nullptr) {
+                if (src->left != nullptr && dst->left == nullptr) {
+                    dst->left = make_node(src->left->key, dst);
+                    src = src->left;
+                    dst = dst->left;
+                } else if (src->right != nullptr && dst->right == nullptr) {
+                    dst->right = make_node(src->right->key, dst);
+                    src = src->right;
+                    dst = dst->right;
                 } else {
-                    nd = nd->right;
+                    src = src == rt ? nullptr : src->parent;
+                    dst = dst->parent;
+                    continue;
                 }
-            else if (k < nd->key)
-                if (nd->left == nullptr) {
-                    nd->left = new node(std::move(k));
-                    ++_size;
-                    return;
-                } else {
-                    nd = nd->left;
+                static_cast<typename Balance::node_base&>(*dst) = *src;
+                ++_size;
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+
+    template <typename T, class Balance, class Compare>
+    binary_search_tree<T, Balance, Compare> &
+    binary_search_tree<T, Balance, Compare>::operator=(const binary_search_tree& bst) {
+        if (this == &bst)
+            return *this;
+        clear();
+        comp = bst.comp;
+        copy_tree(bst.root);
+        return *this;
+    }
+
+    template <typename T, class Balance, class Compare>
+    binary_search_tree<T, Balance, Compare> &
+    binary_search_tree<T, Balance, Compare>::operator=(binary_search_tree&& bst) {
+        if (this == &bst)
+            return *this;
+        clear();
+        root = bst.root;
+        _size = bst._size;
+        pool = std::move(bst.pool);
+        comp = bst.comp;
+
+        bst.root = nullptr;
+        bst._size = 0;
+        return *this;
+    }
+
+    /*
+     * The keys are first chained through their right links, which
+     * is already a valid, if degenerate, tree for clear() to undo
+     * should a copy throw; build_balanced() then relinks the chain.
+     */
+    template <typename T, class Balance, class Compare>
+    template <class Iter>
+    void
+    binary_search_tree<T, Balance, Compare>::assign_sorted(Iter sorted_first, Iter sorted_last) {
+        typedef typename std::iterator_traits<Iter>::iterator_category    category;
+
+        clear();
+        if (std::is_base_of<std::forward_iterator_tag, category>::value)
+            pool.reserve(static_cast<size_type>(std::distance(sorted_first, sorted_last)));
+
+        try {
+            node *tail = nullptr;
+            for ( ; sorted_first != sorted_last; ++sorted_first) {
+                if (tail != nullptr && !comp(tail->key, *sorted_first)) {
+                    if (comp(*sorted_first, tail->key))
+                        throw std::invalid_argument("binary_search_tree: range is not sorted");
+                    continue;
                 }
-            else
-                return;
+                node *nd = make_node(*sorted_first, tail);
+                (tail ? tail->right : root) = nd;
+                tail = nd;
+                ++_size;
+            }
+        } catch (...) {
+            clear();
+            throw;
         }
+        node *list = root;
+        root = build_balanced(list, _size, nullptr);
+    }
+
+    /*
+     * Takes the first n nodes of the chain for a subtree: the left
+     * half, then the middle node as its root, then the right half.
+     * Halves differ by at most one node, so the recursion is only
+     * log2(n) deep and the result satisfies any balancing policy.
+     */
+    template <typename T, class Balance, class Compare>
+    typename binary_search_tree<T, Balance, Compare>::node *
+    binary_search_tree<T, Balance, Compare>::build_balanced(node*& list, size_type n, node* pa) {
+        if (n == 0)
+            return nullptr;
+
+        node *left = build_balanced(list, n / 2, nullptr);
+        node *rt = list;
+        list = list->right;
+        rt->parent = pa;
+        rt->left = left;
+        if (left)
+            left->parent = rt;
+        rt->right = build_balanced(list, n - n / 2 - 1, rt);
+        Balance::fix(rt);
+        return rt;
     }
 
-    template <typename T>
+    template <typename T, class Balance, class Compare>
+    vector<typename binary_search_tree<T, Balance, Compare>::value_type>
+    binary_search_tree<T, Balance, Compare>::to_sorted_vector(void) const {
+        vector<value_type> keys;
+
+        keys.reserve(_size);
+        for (const_iterator it = begin(), e = end(); it != e; ++it)
+            keys.push_back(*it);
+        return keys;
+    }
+
+    template <typename T, class Balance, class Compare>
     void
-    binary_search_tree<T>::print_subtree(const node* rt, size_type depth) const {
-        if (rt == nullptr)
-            return;
-        print_subtree(rt->left, depth + 1);
-        print_n_space(depth);
-        std::cout << rt->key << std::endl;
-        print_subtree(rt->right, depth + 1);
+    binary_search_tree<T, Balance, Compare>::insert(const value_type& k) {
+        insert_key(k);
     }
 
-    template <typename T>
+    template <typename T, class Balance, class Compare>
     void
-    binary_search_tree<T>::print_n_space(size_type n) const {
-        for (size_type i = 0; i < n; ++i)
-            std::cout << " ";
+    binary_search_tree<T, Balance, Compare>::insert(value_type&& k) {
+        insert_key(std::move(k));
     }
 
-    template <typename T>
-    typename binary_search_tree<T>::node *
-    binary_search_tree<T>::find_parent(const node* nd) const {
-        node* cnt = root;
-// TODO if (nd == nullptr) throw except;
-        if (cnt == nd)
-            return nullptr;
-        while (true) {
-            if (nd->key > cnt->key) {
-                if (nd->key == cnt->right->key)
-                    return cnt;
-                cnt = cnt->right;
+    template <typename T, class Balance, class Compare>
+    template <class K>
+    void
+    binary_search_tree<T, Balance, Compare>::insert_key(K&& k) {
+        node    **link = &root, *pa = nullptr, *not_greater = nullptr;
+
+        // k is already in only if it is not less than the last key
+        // the descent went right at, the greatest one not above k.
+        while (*link != nullptr) {
+            pa = *link;
+            if (comp(k, pa->key)) {
+                link = &pa->left;
             } else {
-                if (nd->key == cnt->left->key)
-                    return cnt;
-                cnt = cnt->left;
+                not_greater = pa;
+                link = &pa->right;
             }
         }
+        if (not_greater != nullptr && !comp(not_greater->key, k))
+            return;
+        *link = make_node(std::forward<K>(k), pa);
+        ++_size;
+        retrace(pa);
     }
 
-    template <typename T>
-    typename binary_search_tree<T>::node *
-    binary_search_tree<T>::find_node(const value_type& k) const {
-        node* nd = root;
+    // fix nd and its ancestors, bottom up, while anything changes.
+    template <typename T, class Balance, class Compare>
+    void
+    binary_search_tree<T, Balance, Compare>::retrace(node* nd) {
+        if (!Balance::rebalances)
+            return;
+        while (nd != nullptr) {
+            node *pa = nd->parent;
+            if (!Balance::fix(*link_to(nd)))
+                break;
+            nd = pa;
+        }
+    }
 
-        if (root == nullptr)
-            return nullptr;
+    /*
+     * f(node, depth) for every node in order, the root at depth 0.
+     */
+    template <typename T, class Balance, class Compare>
+    template <class F>
+    void
+    binary_search_tree<T, Balance, Compare>::walk_with_depth(F f) const {
+        const node    *nd = root;
+        size_type     depth = 0;
 
-        while (true)
-            if (nd->key == k) {
-                return nd;
-            } else if (nd->key < k) {
-                if (nd->right != nullptr)
-                    nd = nd->right;
-                else
-                    return nullptr;
-            } else {
-                if (nd->left != nullptr)
+        if (nd == nullptr)
+            return;
+        for ( ; nd->left != nullptr; ++depth)
+            nd = nd->left;
+        while (nd != nullptr) {
+            f(nd, depth);
+            if (nd->right != nullptr) {
+                nd = nd->right;
+                for (++depth; nd->left != nullptr; ++depth)
                     nd = nd->left;
-                else
-                    return nullptr;
+            } else {
+                const node *pa = nd->parent;
+                while (pa != nullptr && nd == pa->right) {
+                    nd = pa;
+                    pa = pa->parent;
+                    --depth;
+                }
+                nd = pa;
+                --depth;
             }
-        return nullptr;
+        }
     }
 
-    template <typename T>
-    typename binary_search_tree<T>::node*
-    binary_search_tree<T>::find_min_node(const node* rt) const {
-        node *nd = rt;
+    template <typename T, class Balance, class Compare>
+    void
+    binary_search_tree<T, Balance, Compare>::print(void) const {
+        walk_with_depth([this](const node* nd, size_type depth) {
+            print_n_space(depth);
+            std::cout << nd->key << std::endl;
+        });
+    }
+
+    template <typename T, class Balance, class Compare>
+    typename binary_search_tree<T, Balance, Compare>::size_type
+    binary_search_tree<T, Balance, Compare>::height(void) const {
+        size_type h = 0;
+
+        walk_with_depth([&h](const node*, size_type depth) {
+            h = std::max(h, depth + 1);
+        });
+        return h;
+    }
+
+    template <typename T, class Balance, class Compare>
+    void
+    binary_search_tree<T, Balance, Compare>::print_n_space(size_type n) const {
+        for (size_type i = 0; i < n; ++i)
+            std::cout << " ";
+    }
+
+    // the lower bound, if it is not greater than k.
+    template <typename T, class Balance, class Compare>
+    template <class K>
+    typename binary_search_tree<T, Balance, Compare>::node *
+    binary_search_tree<T, Balance, Compare>::find_node(const K& k) const {
+        node *nd = lower_node(k);
+
+        return nd != nullptr && !comp(k, nd->key) ? nd : nullptr;
+    }
+
+    template <typename T, class Balance, class Compare>
+    const typename binary_search_tree<T, Balance, Compare>::node*
+    binary_search_tree<T, Balance, Compare>::find_min_node(const node* rt) {
+        const node *nd = rt;
 
         while (nd->left != nullptr)
             nd = nd->left;
@@ -270,10 +844,10 @@ namespace my {
         return nd;
     }
 
-    template <typename T>
-    typename binary_search_tree<T>::node*
-    binary_search_tree<T>::find_max_node(const node* rt) const {
-        node* nd = rt;
+    template <typename T, class Balance, class Compare>
+    const typename binary_search_tree<T, Balance, Compare>::node*
+    binary_search_tree<T, Balance, Compare>::find_max_node(const node* rt) {
+        const node* nd = rt;
 
         while (nd->right != nullptr)
             nd = nd->right;
@@ -281,50 +855,51 @@ namespace my {
         return nd;
     }
 
-    template <typename T>
+    /*
+     * One descent finds the node and, if it has two children, its
+     * successor, which takes the node's place. Rebalancing then
+     * climbs the parent links from the lowest node that lost a
+     * child, so the whole delete is a single pass down and up.
+     */
+    template <typename T, class Balance, class Compare>
     void
-    binary_search_tree<T>::remove(const value_type& val) {
-        node* nd, *pa, *min;
+    binary_search_tree<T, Balance, Compare>::remove(const value_type& val) {
+        node    *nd = find_node(val), *fix_from;
 
-        if (!(nd = find_node(val)))
+        if (nd == nullptr)
             return;
-        pa = find_parent(nd);
-        if (nd->left == nullptr) {
-            // root is the node to be deleted.
-            if (pa == nullptr) {
-                root = root->right;
-            } else {
-                if (nd == pa->right)
-                    pa->right = nd->right;
-                else
-                    pa->left = nd->right;
-            }
-        } else if (nd->right == nullptr) {
-            if (pa == nullptr) {
-                root = root->left;
-            } else {
-                if (nd == pa->right)
-                    pa->right = nd->left;
-                else
-                    pa->left = nd->left;
-            }
+
+        if (nd->left == nullptr || nd->right == nullptr) {
+            node *child = nd->left ? nd->left : nd->right;
+            if (child)
+                child->parent = nd->parent;
+            *link_to(nd) = child;
+            fix_from = nd->parent;
         } else {
-            if ((min = find_min_node(nd->right)) != nd->right) {
-                node* ppa = find_parent(min);
-                ppa->left = min->right;
-                min->right = nd->right;
+            node *succ = nd->right;
+            while (succ->left != nullptr)
+                succ = succ->left;
+
+            // unhook the successor, then put it where nd was.
+            if (succ->parent == nd) {
+                fix_from = succ;
+            } else {
+                fix_from = succ->parent;
+                fix_from->left = succ->right;
+                if (succ->right)
+                    succ->right->parent = fix_from;
+                succ->right = nd->right;
+                succ->right->parent = succ;
             }
-            min->left = nd->left;
-            if (pa == nullptr)
-                root = min;
-            else
-                if (nd == pa->right)
-                    pa->right = min;
-                else
-                    pa->left =min;
+            *link_to(nd) = succ;
+            succ->parent = nd->parent;
+            succ->left = nd->left;
+            succ->left->parent = succ;
+            static_cast<typename Balance::node_base&>(*succ) = *nd;
         }
-        delete nd;
+        drop_node(nd);
         --_size;
+        retrace(fix_from);
     }
 }
 
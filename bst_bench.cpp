@@ -0,0 +1,372 @@
+/*
+ * Insert and remove times of my::binary_search_tree, unbalanced and
+ * with avl_balance, against std::set, for keys arriving sorted,
+ * nearly sorted (1% of positions swapped), in random order and in
+ * an adversarial zig-zag (smallest, largest, second smallest, ...)
+ * that turns an unbalanced tree into a list. The unbalanced tree is
+ * quadratic on three of the orders, so it only runs at small sizes.
+ * A churn test then times remove/insert pairs on a steady-state
+ * tree and the destruction of the whole tree, and a range scan
+ * test times for_each_in_range() against the width of the range.
+ * The snapshot test restores sorted keys by repeated insert() and by
+ * assign_sorted(), saves them with to_sorted_vector(), and times
+ * random lookups in each restored tree. The order statistics test
+ * weighs the insert time and node bytes that counted<> adds against
+ * percentile queries by select() and by walking the tree. The
+ * string test probes a set of long strings by borrowed keys, which
+ * std::less<std::string> needs copied into a std::string per probe
+ * and the transparent std::less<> compares in place. The keys are
+ * std::string_view in C++17 builds and const char* before; the
+ * latter costs a strlen() per comparison. The versions test sets
+ * my::persistent_set against a copied AVL tree: the cost of an
+ * update, and of a point-in-time copy taken every 1000 updates.
+ *
+ * build: g++ -std=c++14 -O2 bst_bench.cpp -o bst_bench
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <set>
+#include <string>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#include "vector.hpp"
+#include "binary_search_tree.hpp"
+#include "persistent_set.hpp"
+
+typedef std::chrono::steady_clock    clock_type;
+
+my::vector<int> keys(const std::string &order, size_t n) {
+    my::vector<int>    k;
+    std::mt19937       e(42);
+
+    for (size_t i = 0; i < n; ++i)
+        k.push_back(static_cast<int>(i));
+    if (order == "nearly_sorted") {
+        for (size_t i = 0; i < n / 100; ++i)
+            std::swap(k[e() % n], k[e() % n]);
+    } else if (order == "random") {
+        for (size_t i = n - 1; i > 0; --i)
+            std::swap(k[i], k[e() % (i + 1)]);
+    } else if (order == "zigzag") {
+        for (size_t i = 0; i < n; ++i)
+            k[i] = static_cast<int>(i % 2 ? n - 1 - i / 2 : i / 2);
+    }
+    return k;
+}
+
+template <class Set>
+size_t height(const Set &s) { return s.height(); }
+template <typename T>
+size_t height(const std::set<T>&) { return 0; }
+
+template <class Set>
+void run(const char *name, const std::string &order, size_t n) {
+    my::vector<int>    k = keys(order, n);
+    Set                set;
+
+    auto start = clock_type::now();
+    for (int key : k)
+        set.insert(key);
+    double ins = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / n;
+    size_t h = height(set);
+
+    start = clock_type::now();
+    for (int key : k)
+        set.erase(key);
+    double rem = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / n;
+
+    std::cout << std::setw(14) << order << std::setw(10) << n << std::setw(12) << name
+              << std::fixed << std::setprecision(1) << std::setw(14) << ins
+              << std::setw(14) << rem << std::setw(10) << h << std::endl;
+}
+
+/* @fn churn()
+ * A tree of n random keys under a stream of remove/insert pairs,
+ * then its destruction, as a long-running index sees it.
+ */
+template <class Set>
+void churn(const char *name, size_t n) {
+    std::mt19937    e(7);
+    const int       range = static_cast<int>(4 * n);
+    double          destroy_ms;
+    double          pair_ns;
+
+    {
+        Set    set;
+        while (set.size() < n)
+            set.insert(static_cast<int>(e() % range));
+
+        const size_t pairs = 2000000;
+        auto start = clock_type::now();
+        for (size_t i = 0; i < pairs; ++i) {
+            set.erase(static_cast<int>(e() % range));
+            set.insert(static_cast<int>(e() % range));
+        }
+        pair_ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / pairs;
+        start = clock_type::now();
+        {
+            Set dying(std::move(set));
+        }
+        destroy_ms = std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+    }
+    std::cout << std::setw(14) << "churn" << std::setw(10) << n << std::setw(12) << name
+              << std::fixed << std::setprecision(1) << std::setw(14) << pair_ns
+              << std::setw(14) << destroy_ms << std::endl;
+}
+
+/* @fn range_scan()
+ * Sum the keys in [lo, lo + width) of an n-key tree, for random lo;
+ * the time per scan should grow with width, not with n.
+ */
+template <class Tree>
+void range_scan(size_t n, int width) {
+    Tree            tree;
+    std::mt19937    e(3);
+    long            sum = 0;
+    const int       scans = 20000;
+
+    for (int k : keys("random", n))
+        tree.insert(k);
+    auto start = clock_type::now();
+    for (int i = 0; i < scans; ++i) {
+        int lo = static_cast<int>(e() % n);
+        tree.for_each_in_range(lo, lo + width, [&sum](int k) {sum += k;});
+    }
+    double ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / scans;
+    std::cout << std::setw(14) << "range_scan" << std::setw(10) << n << std::setw(12) << width
+              << std::fixed << std::setprecision(1) << std::setw(14) << ns
+              << "   (" << sum << ")" << std::endl;
+}
+
+double lookup_ns(const my::binary_search_tree<int, my::avl_balance> &tree, size_t n) {
+    std::mt19937    e(5);
+    size_t          found = 0;
+    const int       lookups = 1000000;
+
+    auto start = clock_type::now();
+    for (int i = 0; i < lookups; ++i)
+        found += tree.contains(static_cast<int>(e() % n));
+    double ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / lookups;
+    if (found == 0)
+        std::cout << "nothing found" << std::endl;
+    return ns;
+}
+
+/* @fn snapshot()
+ * Restore an AVL tree from n sorted keys, then save it again.
+ */
+void snapshot(size_t n) {
+    my::vector<int>                                   k = keys("sorted", n);
+    my::binary_search_tree<int, my::avl_balance>      by_insert, bulk;
+
+    auto start = clock_type::now();
+    for (int key : k)
+        by_insert.insert(key);
+    double ins = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / n;
+
+    start = clock_type::now();
+    bulk.assign_sorted(k.begin(), k.end());
+    double load = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / n;
+
+    start = clock_type::now();
+    my::vector<int> saved = bulk.to_sorted_vector();
+    double save = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / n;
+
+    std::cout << std::setw(10) << n << std::fixed << std::setprecision(1)
+              << std::setw(12) << ins << std::setw(12) << load << std::setw(12) << save
+              << std::setw(16) << lookup_ns(by_insert, n) << std::setw(16) << lookup_ns(bulk, n)
+              << "   (" << saved.size() << ")" << std::endl;
+}
+
+// the i-th smallest key: select() where the tree counts, else a walk.
+template <class Tree>
+int nth(const Tree &tree, size_t i) {
+    auto it = tree.begin();
+    std::advance(it, i);
+    return *it;
+}
+template <typename T, class B>
+int nth(const my::binary_search_tree<T, my::counted<B>> &tree, size_t i) {
+    return *tree.select(i);
+}
+
+/* @fn order_stats()
+ * Build from random keys, then ask for keys around the 99th
+ * percentile.
+ */
+template <class Tree>
+void order_stats(const char *name, size_t n) {
+    my::vector<int>    k = keys("random", n);
+    Tree               tree;
+    const int          queries = my::is_counted<typename Tree::balance_policy>::value ? 1000000 : 20;
+    long               sum = 0;
+
+    auto start = clock_type::now();
+    for (int key : k)
+        tree.insert(key);
+    double ins = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / n;
+
+    start = clock_type::now();
+    for (int q = 0; q < queries; ++q)
+        sum += nth(tree, n * 99 / 100 - static_cast<size_t>(q % 16));
+    double query = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / queries;
+
+    std::cout << std::setw(10) << n << std::setw(18) << name << std::fixed << std::setprecision(1)
+              << std::setw(12) << ins << std::setw(14) << double(tree.bytes()) / n
+              << std::setw(14) << query << "   (" << sum << ")" << std::endl;
+}
+
+// counts the comparisons of another comparator.
+template <class Less>
+struct counting: Less {
+    static long    calls;
+    template <class A, class B>
+    bool operator()(const A &a, const B &b) const {++calls; return Less::operator()(a, b);}
+};
+template <class Less>
+long counting<Less>::calls = 0;
+
+#if __cplusplus >= 201703L
+typedef std::string_view    probe_type;
+#else
+typedef const char*         probe_type;
+#endif
+
+template <class Tree>
+bool probe(const Tree &tree, probe_type p) { return tree.contains(p); }
+template <class B>
+bool probe(const my::binary_search_tree<std::string, B, counting<std::less<std::string>>> &tree,
+           probe_type p) {
+    return tree.contains(std::string(p));
+}
+
+template <class Less>
+void string_lookups(const char *name, size_t n) {
+    my::vector<std::string>    words;
+    my::vector<probe_type>     probes;
+    std::mt19937               e(9);
+
+    for (size_t i = 0; i < n; ++i)
+        words.push_back("session/" + std::to_string(1000000000 + e() % 1000000000));
+    for (size_t i = 0; i < n; ++i)
+        probes.push_back(probe_type(words[e() % n].c_str()));
+    my::binary_search_tree<std::string, my::avl_balance, counting<Less>> tree;
+    for (const std::string &w : words)
+        tree.insert(w);
+
+    size_t    found = 0;
+    counting<Less>::calls = 0;
+    auto start = clock_type::now();
+    for (probe_type p : probes)
+        found += probe(tree, p);
+    double ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / n;
+    std::cout << std::setw(10) << n << std::setw(20) << name << std::fixed << std::setprecision(1)
+              << std::setw(12) << ns << std::setw(14) << double(counting<Less>::calls) / n
+              << "   (" << found << ")" << std::endl;
+}
+
+/* @fn versions()
+ * n random inserts, taking a copy every 1000 of them and keeping
+ * only the latest, as a periodic report would. Dropping the old
+ * copy is not timed.
+ */
+template <class Set>
+void versions(const char *name, size_t n) {
+    my::vector<int>    k = keys("random", n);
+    Set                set, latest;
+    double             insert_ns = 0, copy_ns = 0;
+    size_t             copies = 0;
+
+    for (size_t i = 0; i < n; i += 1000) {
+        auto start = clock_type::now();
+        for (size_t j = i; j < i + 1000 && j < n; ++j)
+            set.insert(k[j]);
+        auto mid = clock_type::now();
+        Set copy(set);
+        auto end = clock_type::now();
+        insert_ns += std::chrono::duration<double, std::nano>(mid - start).count();
+        copy_ns += std::chrono::duration<double, std::nano>(end - mid).count();
+        ++copies;
+        latest = std::move(copy);
+    }
+    std::cout << std::setw(10) << n << std::setw(18) << name << std::fixed << std::setprecision(1)
+              << std::setw(14) << insert_ns / n << std::setw(14) << copy_ns / copies
+              << "   (" << latest.size() << ")" << std::endl;
+}
+
+// std::set spells remove() as erase().
+template <class Tree>
+struct erasable: Tree {
+    void erase(int k) { Tree::remove(k); }
+};
+
+typedef erasable<my::binary_search_tree<int>>                      plain_tree;
+typedef erasable<my::binary_search_tree<int, my::avl_balance>>     avl_tree;
+
+int
+main(void) {
+    const char *orders[] = { "sorted", "nearly_sorted", "random", "zigzag" };
+
+    std::cout << std::setw(14) << "order" << std::setw(10) << "n" << std::setw(12) << "tree"
+              << std::setw(14) << "insert ns" << std::setw(14) << "remove ns"
+              << std::setw(10) << "height" << std::endl;
+    for (const char *order : orders) {
+        run<plain_tree>("unbalanced", order, 20000);
+        run<avl_tree>("avl", order, 20000);
+        run<std::set<int>>("std::set", order, 20000);
+    }
+    for (const char *order : orders) {
+        if (std::string(order) == "random")
+            run<plain_tree>("unbalanced", order, 1000000);
+        run<avl_tree>("avl", order, 1000000);
+        run<std::set<int>>("std::set", order, 1000000);
+    }
+
+    std::cout << std::endl << std::setw(14) << "test" << std::setw(10) << "n"
+              << std::setw(12) << "tree" << std::setw(14) << "ns per pair"
+              << std::setw(14) << "destroy ms" << std::endl;
+    for (size_t n = 1000; n <= 1000000; n *= 10) {
+        churn<avl_tree>("avl", n);
+        churn<std::set<int>>("std::set", n);
+    }
+
+    std::cout << std::endl << std::setw(14) << "test" << std::setw(10) << "n"
+              << std::setw(12) << "width" << std::setw(14) << "ns per scan" << std::endl;
+    for (size_t n = 10000; n <= 1000000; n *= 100)
+        for (int width = 1; width <= 10000; width *= 10)
+            range_scan<my::binary_search_tree<int, my::avl_balance>>(n, width);
+
+    std::cout << std::endl << std::setw(10) << "n" << std::setw(12) << "insert ns"
+              << std::setw(12) << "bulk ns" << std::setw(12) << "save ns"
+              << std::setw(16) << "find ns (ins)" << std::setw(16) << "find ns (bulk)" << std::endl;
+    for (size_t n = 1000000; n <= 10000000; n *= 10)
+        snapshot(n);
+
+    std::cout << std::endl << std::setw(10) << "n" << std::setw(20) << "compare"
+              << std::setw(12) << "find ns" << std::setw(14) << "compares" << std::endl;
+    for (size_t n = 10000; n <= 1000000; n *= 10) {
+        string_lookups<std::less<std::string>>("less<string>", n);
+        string_lookups<std::less<>>("less<>", n);
+    }
+
+    std::cout << std::endl << std::setw(10) << "n" << std::setw(18) << "tree"
+              << std::setw(12) << "insert ns" << std::setw(14) << "bytes per key"
+              << std::setw(14) << "p99 ns" << std::endl;
+    for (size_t n = 10000; n <= 1000000; n *= 10) {
+        order_stats<my::binary_search_tree<int, my::avl_balance>>("avl", n);
+        order_stats<my::binary_search_tree<int, my::counted<my::avl_balance>>>("counted<avl>", n);
+    }
+
+
+    std::cout << std::endl << std::setw(10) << "n" << std::setw(18) << "set"
+              << std::setw(14) << "insert ns" << std::setw(14) << "copy ns" << std::endl;
+    for (size_t n = 10000; n <= 1000000; n *= 10) {
+        versions<my::binary_search_tree<int, my::avl_balance>>("avl copy", n);
+        versions<my::persistent_set<int>>("persistent_set", n);
+    }
+    return 0;
+}
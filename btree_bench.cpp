@@ -0,0 +1,83 @@
+/*
+ * my::btree_set against my::binary_search_tree (AVL) and std::set:
+ * building from random keys, random lookups (half hits, half misses)
+ * and the resident memory each structure adds per key, measured as
+ * the growth of the resident set while it is built.
+ *
+ * build: g++ -std=c++14 -O2 btree_bench.cpp -o btree_bench
+ * run:   ./btree_bench [n]        (default 10^7)
+ */
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <set>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "vector.hpp"
+#include "binary_search_tree.hpp"
+#include "btree_set.hpp"
+
+typedef std::chrono::steady_clock    clock_type;
+
+long resident_bytes(void) {
+    std::ifstream    in("/proc/self/statm");
+    long             pages, resident;
+    in >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+template <class Set>
+bool has(const Set &s, int k) { return s.contains(k); }
+template <typename T>
+bool has(const std::set<T> &s, int k) { return s.count(k) != 0; }
+
+template <class Set>
+void run(const char *name, const my::vector<int> &keys, const my::vector<int> &probes) {
+    long    before = resident_bytes();
+    auto    start = clock_type::now();
+    Set     set;
+
+    for (int k : keys)
+        set.insert(k);
+    double ins = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / keys.size();
+    double per_key = static_cast<double>(resident_bytes() - before) / keys.size();
+
+    size_t found = 0;
+    start = clock_type::now();
+    for (int k : probes)
+        found += has(set, k);
+    double look = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / probes.size();
+
+    std::cout << std::setw(22) << name << std::fixed << std::setprecision(1)
+              << std::setw(12) << ins << std::setw(12) << look
+              << std::setw(14) << per_key << std::setw(12) << found << std::endl;
+}
+
+int
+main(int argc, char **argv) {
+    size_t             n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+    std::mt19937       e(1);
+    my::vector<int>    keys, probes;
+
+    // even keys go in; probes are even (hits) or odd (misses).
+    for (size_t i = 0; i < n; ++i)
+        keys.push_back(static_cast<int>(2 * i));
+    for (size_t i = n - 1; i > 0; --i)
+        std::swap(keys[i], keys[e() % (i + 1)]);
+    for (size_t i = 0; i < 5000000; ++i)
+        probes.push_back(static_cast<int>(e() % (2 * n)));
+
+    std::cout << "n = " << n << std::endl;
+    std::cout << std::setw(22) << "set" << std::setw(12) << "insert ns"
+              << std::setw(12) << "lookup ns" << std::setw(14) << "bytes/key"
+              << std::setw(12) << "hits" << std::endl;
+    run<my::btree_set<int>>("btree_set<int>", keys, probes);
+    run<my::btree_set<int, 512>>("btree_set<int, 512>", keys, probes);
+    run<my::binary_search_tree<int, my::avl_balance>>("avl tree", keys, probes);
+    run<std::set<int>>("std::set", keys, probes);
+
+    return 0;
+}
@@ -0,0 +1,596 @@
+#ifndef M_BTREE_SET
+#define M_BTREE_SET
+
+#include <iostream>
+#include <cstddef>      // size_t
+#include <utility>      // move(), swap()
+#include <algorithm>    // move(), move_backward(), lower_bound(), upper_bound()
+#include <type_traits>
+#include <initializer_list>
+
+#include "node_pool.hpp"
+
+namespace my {
+    /* @class btree_set
+     * An ordered set kept in a B+ tree whose nodes are NodeBytes
+     * long (a multiple of the 64-byte cache line) and cache-line
+     * aligned. With ints, a leaf holds 60 keys and an inner node 20
+     * separators, so 10^7 keys sit four levels deep and a lookup
+     * touches four nodes instead of some 25 scattered ones. Keys live
+     * in the leaves, which are chained for in-order walks; a separator
+     * is a lower bound of the keys in the child to its right. Within
+     * a node, arithmetic keys are found with a branch-free counting
+     * scan that compiles to SIMD compares, other keys by binary
+     * search. Keys are stored in arrays, so T must be default
+     * constructible and move assignable. The interface follows
+     * binary_search_tree.
+     */
+    template <typename T, size_t NodeBytes = 256>
+    class btree_set {
+        static_assert(NodeBytes % 64 == 0, "nodes are whole cache lines");
+    public:
+        typedef T          value_type;
+        typedef size_t     size_type;
+
+    private:
+        struct leaf;
+        struct inner;
+
+        static constexpr size_t fit(size_t room, size_t each) {
+            return room / each < 4 ? 4 : room / each;
+        }
+
+        // count and next pointer take 16 bytes of a leaf.
+        static const size_t    leaf_keys = fit(NodeBytes - 16, sizeof(T));
+        // count takes 8 bytes, then keys and one more child than keys.
+        static const size_t    inner_keys = fit(NodeBytes - 16, sizeof(T) + sizeof(void*));
+
+        struct alignas(64) leaf {
+            size_type    count;
+            leaf*        next;
+            value_type   keys[leaf_keys];
+
+            leaf(): count(0), next(nullptr) {}
+        };
+
+        struct alignas(64) inner {
+            size_type    count;
+            value_type   keys[inner_keys];
+            void*        child[inner_keys + 1];
+
+            inner(): count(0) {}
+        };
+
+    public:
+        // constructors.
+        btree_set(): root(nullptr), levels(0), _size(0) {}
+        btree_set(const btree_set& bt);
+        btree_set(btree_set&& bt);
+        btree_set(std::initializer_list<value_type> il);
+        ~btree_set() {clear();}
+
+        // operators.
+        btree_set &operator=(const btree_set& bt);
+        btree_set &operator=(btree_set&& bt);
+
+        // operations.
+        void insert(const value_type& k) {insert_key(k);}
+        void insert(value_type&& k) {insert_key(std::move(k));}
+        void remove(const value_type& k);
+        void clear(void);
+        const value_type* find(const value_type& k) const;
+        bool contains(const value_type& k) const {return find(k) != nullptr;}
+        void print(void) const;
+
+        // f(key) for every key, in order.
+        template <class F>
+        void for_each(F f) const;
+
+        size_type size(void) const {return _size;}
+        size_type height(void) const {return levels;}
+        // leaves in use, counted along their chain.
+        size_type leaf_count(void) const;
+        // fewest keys in an inner node other than the root, or 0 if none.
+        size_type min_inner_count(void) const;
+        // bytes of node memory held, free nodes included.
+        size_type bytes(void) const {return leaves.bytes() + inners.bytes();}
+
+    private:
+        // number of keys in [first, first + n) that are less than k.
+        static size_type less_count(const value_type* first, size_type n,
+                                    const value_type& k, std::true_type);
+        static size_type less_count(const value_type* first, size_type n,
+                                    const value_type& k, std::false_type);
+        static size_type lower(const value_type* first, size_type n, const value_type& k) {
+            return less_count(first, n, k, std::is_arithmetic<value_type>());
+        }
+        // child of nd whose range holds k.
+        static size_type child_index(const inner* nd, const value_type& k);
+
+        const leaf* find_leaf(const value_type& k) const;
+        template <class K>
+        void insert_key(K&& k);
+        void insert_child(size_type depth, value_type&& sep, void* right, bool append);
+        void fix_leaf(leaf* lf);
+        void fix_inner(size_type depth);
+        void destroy_subtree(void* nd, size_type level);
+        size_type min_inner_count(const inner* nd, size_type level) const;
+
+        leaf* new_leaf(void) {return ::new (leaves.allocate()) leaf();}
+        inner* new_inner(void) {return ::new (inners.allocate()) inner();}
+        void drop(leaf* nd) {nd->~leaf(); leaves.deallocate(nd);}
+        void drop(inner* nd) {nd->~inner(); inners.deallocate(nd);}
+
+        /*
+         * The inner nodes from the root down to the last leaf visited
+         * by an update, with the child index taken at each; splits and
+         * merges climb back up along it. 32 levels are never reached.
+         */
+        struct step {
+            inner*       nd;
+            size_type    idx;
+        };
+        step          path[32];
+
+    private:
+        void*                root;
+        size_type            levels;    // 0 for an empty tree, 1 for a lone leaf.
+        size_type            _size;
+        node_pool<leaf>      leaves;
+        node_pool<inner>     inners;
+    };
+
+    template <typename T, size_t NodeBytes>
+    btree_set<T, NodeBytes>::btree_set(const btree_set& bt)
+    : root(nullptr), levels(0), _size(0) {
+        bt.for_each([this](const value_type& k) {insert(k);});
+    }
+
+    template <typename T, size_t NodeBytes>
+    btree_set<T, NodeBytes>::btree_set(btree_set&& bt)
+    : root(bt.root), levels(bt.levels), _size(bt._size),
+      leaves(std::move(bt.leaves)), inners(std::move(bt.inners)) {
+        bt.root = nullptr;
+        bt.levels = 0;
+        bt._size = 0;
+    }
+
+    template <typename T, size_t NodeBytes>
+    btree_set<T, NodeBytes>::btree_set(std::initializer_list<value_type> il)
+    : root(nullptr), levels(0), _size(0) {
+        for (auto &i : il)
+            insert(i);
+    }
+
+    template <typename T, size_t NodeBytes>
+    btree_set<T, NodeBytes> &
+    btree_set<T, NodeBytes>::operator=(const btree_set& bt) {
+        if (this == &bt)
+            return *this;
+        clear();
+        bt.for_each([this](const value_type& k) {insert(k);});
+        return *this;
+    }
+
+    template <typename T, size_t NodeBytes>
+    btree_set<T, NodeBytes> &
+    btree_set<T, NodeBytes>::operator=(btree_set&& bt) {
+        if (this == &bt)
+            return *this;
+        clear();
+        root = bt.root;
+        levels = bt.levels;
+        _size = bt._size;
+        leaves = std::move(bt.leaves);
+        inners = std::move(bt.inners);
+        bt.root = nullptr;
+        bt.levels = 0;
+        bt._size = 0;
+        return *this;
+    }
+
+    template <typename T, size_t NodeBytes>
+    void
+    btree_set<T, NodeBytes>::destroy_subtree(void* nd, size_type level) {
+        if (level == 1) {
+            drop(static_cast<leaf*>(nd));
+            return;
+        }
+        inner *in = static_cast<inner*>(nd);
+        for (size_type i = 0; i <= in->count; ++i)
+            destroy_subtree(in->child[i], level - 1);
+        drop(in);
+    }
+
+    template <typename T, size_t NodeBytes>
+    void
+    btree_set<T, NodeBytes>::clear(void) {
+        // depth is logarithmic, so the recursion stays shallow.
+        if (!std::is_trivially_destructible<value_type>::value && root != nullptr)
+            destroy_subtree(root, levels);
+        leaves.release();
+        inners.release();
+        root = nullptr;
+        levels = 0;
+        _size = 0;
+    }
+
+    /*
+     * Summing the comparisons instead of branching on them lets the
+     * compiler vectorize the scan; a node is a few cache lines, so
+     * reading all of it costs less than a mispredicted binary search.
+     */
+    template <typename T, size_t NodeBytes>
+    typename btree_set<T, NodeBytes>::size_type
+    btree_set<T, NodeBytes>::less_count(const value_type* first, size_type n,
+                                        const value_type& k, std::true_type) {
+        size_type c = 0;
+        for (size_type i = 0; i < n; ++i)
+            c += first[i] < k;
+        return c;
+    }
+
+    template <typename T, size_t NodeBytes>
+    typename btree_set<T, NodeBytes>::size_type
+    btree_set<T, NodeBytes>::less_count(const value_type* first, size_type n,
+                                        const value_type& k, std::false_type) {
+        return std::lower_bound(first, first + n, k) - first;
+    }
+
+    template <typename T, size_t NodeBytes>
+    typename btree_set<T, NodeBytes>::size_type
+    btree_set<T, NodeBytes>::child_index(const inner* nd, const value_type& k) {
+        size_type i = lower(nd->keys, nd->count, k);
+        // a separator equal to k starts the child to its right.
+        if (i < nd->count && !(k < nd->keys[i]))
+            ++i;
+        return i;
+    }
+
+    template <typename T, size_t NodeBytes>
+    const typename btree_set<T, NodeBytes>::leaf *
+    btree_set<T, NodeBytes>::find_leaf(const value_type& k) const {
+        const void *nd = root;
+
+        for (size_type l = levels; l > 1; --l) {
+            const inner *in = static_cast<const inner*>(nd);
+            nd = in->child[child_index(in, k)];
+        }
+        return static_cast<const leaf*>(nd);
+    }
+
+    template <typename T, size_t NodeBytes>
+    const typename btree_set<T, NodeBytes>::value_type *
+    btree_set<T, NodeBytes>::find(const value_type& k) const {
+        if (root == nullptr)
+            return nullptr;
+        const leaf *lf = find_leaf(k);
+        size_type i = lower(lf->keys, lf->count, k);
+        if (i < lf->count && !(k < lf->keys[i]))
+            return lf->keys + i;
+        return nullptr;
+    }
+
+    template <typename T, size_t NodeBytes>
+    template <class F>
+    void
+    btree_set<T, NodeBytes>::for_each(F f) const {
+        const void *nd = root;
+
+        if (nd == nullptr)
+            return;
+        for (size_type l = levels; l > 1; --l)
+            nd = static_cast<const inner*>(nd)->child[0];
+        for (const leaf *lf = static_cast<const leaf*>(nd); lf; lf = lf->next)
+            for (size_type i = 0; i < lf->count; ++i)
+                f(lf->keys[i]);
+    }
+
+    template <typename T, size_t NodeBytes>
+    typename btree_set<T, NodeBytes>::size_type
+    btree_set<T, NodeBytes>::leaf_count(void) const {
+        const void *nd = root;
+        size_type n = 0;
+
+        if (nd == nullptr)
+            return 0;
+        for (size_type l = levels; l > 1; --l)
+            nd = static_cast<const inner*>(nd)->child[0];
+        for (const leaf *lf = static_cast<const leaf*>(nd); lf; lf = lf->next)
+            ++n;
+        return n;
+    }
+
+    template <typename T, size_t NodeBytes>
+    typename btree_set<T, NodeBytes>::size_type
+    btree_set<T, NodeBytes>::min_inner_count(void) const {
+        if (levels < 2)
+            return 0;
+        const inner *top = static_cast<const inner*>(root);
+        size_type least = 0;
+        for (size_type c = 0; levels > 2 && c <= top->count; ++c) {
+            size_type m = min_inner_count(static_cast<const inner*>(top->child[c]), levels - 1);
+            least = least == 0 || m < least ? m : least;
+        }
+        return least;
+    }
+
+    template <typename T, size_t NodeBytes>
+    typename btree_set<T, NodeBytes>::size_type
+    btree_set<T, NodeBytes>::min_inner_count(const inner* nd, size_type level) const {
+        size_type least = nd->count;
+        for (size_type c = 0; level > 2 && c <= nd->count; ++c) {
+            size_type m = min_inner_count(static_cast<const inner*>(nd->child[c]), level - 1);
+            least = m < least ? m : least;
+        }
+        return least;
+    }
+
+    template <typename T, size_t NodeBytes>
+    void
+    btree_set<T, NodeBytes>::print(void) const {
+        for_each([](const value_type& k) {std::cout << k << std::endl;});
+    }
+
+    /*
+     * A full leaf is split in half before the key goes in, and the
+     * first key of the new right half is inserted into the parent,
+     * which may split in turn up to the root. A key beyond the end
+     * of the last leaf starts a new leaf instead, so that sorted
+     * input packs the nodes full rather than half full.
+     */
+    template <typename T, size_t NodeBytes>
+    template <class K>
+    void
+    btree_set<T, NodeBytes>::insert_key(K&& k) {
+        if (root == nullptr) {
+            leaf *lf = new_leaf();
+            lf->keys[0] = std::forward<K>(k);
+            lf->count = 1;
+            root = lf;
+            levels = 1;
+            _size = 1;
+            return;
+        }
+
+        void *nd = root;
+        for (size_type d = 0; d + 1 < levels; ++d) {
+            inner *in = static_cast<inner*>(nd);
+            path[d].nd = in;
+            path[d].idx = child_index(in, k);
+            nd = in->child[path[d].idx];
+        }
+        leaf *lf = static_cast<leaf*>(nd);
+        size_type i = lower(lf->keys, lf->count, k);
+        if (i < lf->count && !(k < lf->keys[i]))
+            return;
+
+        if (lf->count == leaf_keys) {
+            leaf *right = new_leaf();
+            // appending past the last leaf, as sorted input does, keeps it full.
+            size_type half = i == leaf_keys && lf->next == nullptr ? leaf_keys : leaf_keys / 2;
+
+            std::move(lf->keys + half, lf->keys + leaf_keys, right->keys);
+            right->count = leaf_keys - half;
+            lf->count = half;
+            right->next = lf->next;
+            lf->next = right;
+            if (i > half || half == leaf_keys) {
+                lf = right;
+                i -= half;
+            }
+            std::move_backward(lf->keys + i, lf->keys + lf->count, lf->keys + lf->count + 1);
+            lf->keys[i] = std::forward<K>(k);
+            ++lf->count;
+            ++_size;
+            insert_child(levels - 1, value_type(right->keys[0]), right, half == leaf_keys);
+            return;
+        }
+        std::move_backward(lf->keys + i, lf->keys + lf->count, lf->keys + lf->count + 1);
+        lf->keys[i] = std::forward<K>(k);
+        ++lf->count;
+        ++_size;
+    }
+
+    /*
+     * Put separator sep and its right-hand child into the inner node
+     * at depth - 1 of the path (or above a new root when depth is 0).
+     * append is set when right came from appending past the last key
+     * of the tree, so that every node split on the way is on the
+     * right edge.
+     */
+    template <typename T, size_t NodeBytes>
+    void
+    btree_set<T, NodeBytes>::insert_child(size_type depth, value_type&& sep, void* right,
+                                          bool append) {
+        while (depth > 0) {
+            inner *in = path[depth - 1].nd;
+            size_type i = path[depth - 1].idx;
+
+            if (in->count < inner_keys) {
+                std::move_backward(in->keys + i, in->keys + in->count, in->keys + in->count + 1);
+                std::copy_backward(in->child + i + 1, in->child + in->count + 1,
+                                   in->child + in->count + 2);
+                in->keys[i] = std::move(sep);
+                in->child[i + 1] = right;
+                ++in->count;
+                return;
+            }
+
+            // split: the middle separator of the inner_keys + 1 moves up.
+            value_type    keys[inner_keys + 1];
+            void          *child[inner_keys + 2];
+            std::move(in->keys, in->keys + i, keys);
+            keys[i] = std::move(sep);
+            std::move(in->keys + i, in->keys + inner_keys, keys + i + 1);
+            std::copy(in->child, in->child + i + 1, child);
+            child[i + 1] = right;
+            std::copy(in->child + i + 1, in->child + inner_keys + 1, child + i + 2);
+
+            // as with leaves, appending to the tree leaves this node
+            // nearly full and starts the sibling with two children.
+            const size_type mid = append ? inner_keys - 1 : (inner_keys + 1) / 2;
+            inner *sib = new_inner();
+            std::move(keys, keys + mid, in->keys);
+            std::copy(child, child + mid + 1, in->child);
+            in->count = mid;
+            std::move(keys + mid + 1, keys + inner_keys + 1, sib->keys);
+            std::copy(child + mid + 1, child + inner_keys + 2, sib->child);
+            sib->count = inner_keys - mid;
+
+            sep = std::move(keys[mid]);
+            right = sib;
+            --depth;
+        }
+
+        inner *top = new_inner();
+        top->keys[0] = std::move(sep);
+        top->child[0] = root;
+        top->child[1] = right;
+        top->count = 1;
+        root = top;
+        ++levels;
+    }
+
+    template <typename T, size_t NodeBytes>
+    void
+    btree_set<T, NodeBytes>::remove(const value_type& k) {
+        if (root == nullptr)
+            return;
+
+        void *nd = root;
+        for (size_type d = 0; d + 1 < levels; ++d) {
+            inner *in = static_cast<inner*>(nd);
+            path[d].nd = in;
+            path[d].idx = child_index(in, k);
+            nd = in->child[path[d].idx];
+        }
+        leaf *lf = static_cast<leaf*>(nd);
+        size_type i = lower(lf->keys, lf->count, k);
+        if (i == lf->count || k < lf->keys[i])
+            return;
+
+        std::move(lf->keys + i + 1, lf->keys + lf->count, lf->keys + i);
+        --lf->count;
+        --_size;
+        fix_leaf(lf);
+    }
+
+    /*
+     * A leaf under half full borrows a key from a sibling with spare
+     * keys, or else merges with it; a merge takes a separator out of
+     * the parent, which is then fixed the same way.
+     */
+    template <typename T, size_t NodeBytes>
+    void
+    btree_set<T, NodeBytes>::fix_leaf(leaf* lf) {
+        const size_type min = leaf_keys / 2;
+
+        if (levels == 1) {
+            if (lf->count == 0) {
+                drop(lf);
+                root = nullptr;
+                levels = 0;
+            }
+            return;
+        }
+        if (lf->count >= min)
+            return;
+
+        inner *pa = path[levels - 2].nd;
+        size_type i = path[levels - 2].idx;
+        leaf *left = i > 0 ? static_cast<leaf*>(pa->child[i - 1]) : nullptr;
+        leaf *right = i < pa->count ? static_cast<leaf*>(pa->child[i + 1]) : nullptr;
+
+        if (left && left->count > min) {
+            std::move_backward(lf->keys, lf->keys + lf->count, lf->keys + lf->count + 1);
+            lf->keys[0] = std::move(left->keys[--left->count]);
+            ++lf->count;
+            pa->keys[i - 1] = lf->keys[0];
+            return;
+        }
+        if (right && right->count > min) {
+            lf->keys[lf->count++] = std::move(right->keys[0]);
+            std::move(right->keys + 1, right->keys + right->count, right->keys);
+            --right->count;
+            pa->keys[i] = right->keys[0];
+            return;
+        }
+
+        // merge the right one of the pair into the left one.
+        size_type sep = left ? i - 1 : i;
+        leaf *l = left ? left : lf, *r = left ? lf : right;
+        std::move(r->keys, r->keys + r->count, l->keys + l->count);
+        l->count += r->count;
+        l->next = r->next;
+        drop(r);
+        std::move(pa->keys + sep + 1, pa->keys + pa->count, pa->keys + sep);
+        std::copy(pa->child + sep + 2, pa->child + pa->count + 1, pa->child + sep + 1);
+        --pa->count;
+        fix_inner(levels - 2);
+    }
+
+    template <typename T, size_t NodeBytes>
+    void
+    btree_set<T, NodeBytes>::fix_inner(size_type depth) {
+        const size_type min = inner_keys / 2;
+
+        while (true) {
+            inner *in = path[depth].nd;
+
+            if (depth == 0) {
+                // a root left with one child hands the tree to it.
+                if (in->count == 0) {
+                    root = in->child[0];
+                    drop(in);
+                    --levels;
+                }
+                return;
+            }
+            if (in->count >= min)
+                return;
+
+            inner *pa = path[depth - 1].nd;
+            size_type i = path[depth - 1].idx;
+            inner *left = i > 0 ? static_cast<inner*>(pa->child[i - 1]) : nullptr;
+            inner *right = i < pa->count ? static_cast<inner*>(pa->child[i + 1]) : nullptr;
+
+            // borrowing rotates a key through the parent's separator.
+            if (left && left->count > min) {
+                std::move_backward(in->keys, in->keys + in->count, in->keys + in->count + 1);
+                std::copy_backward(in->child, in->child + in->count + 1, in->child + in->count + 2);
+                in->keys[0] = std::move(pa->keys[i - 1]);
+                in->child[0] = left->child[left->count];
+                pa->keys[i - 1] = std::move(left->keys[left->count - 1]);
+                --left->count;
+                ++in->count;
+                return;
+            }
+            if (right && right->count > min) {
+                in->keys[in->count] = std::move(pa->keys[i]);
+                in->child[in->count + 1] = right->child[0];
+                ++in->count;
+                pa->keys[i] = std::move(right->keys[0]);
+                std::move(right->keys + 1, right->keys + right->count, right->keys);
+                std::copy(right->child + 1, right->child + right->count + 1, right->child);
+                --right->count;
+                return;
+            }
+
+            // merging pulls the separator down between the two halves.
+            size_type sep = left ? i - 1 : i;
+            inner *l = left ? left : in, *r = left ? in : right;
+            l->keys[l->count] = std::move(pa->keys[sep]);
+            std::move(r->keys, r->keys + r->count, l->keys + l->count + 1);
+            std::copy(r->child, r->child + r->count + 1, l->child + l->count + 1);
+            l->count += r->count + 1;
+            drop(r);
+            std::move(pa->keys + sep + 1, pa->keys + pa->count, pa->keys + sep);
+            std::copy(pa->child + sep + 2, pa->child + pa->count + 1, pa->child + sep + 1);
+            --pa->count;
+            --depth;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include <cassert>
+
+#include "btree_set.hpp"
+
+/*
+ * Random inserts and removes checked against std::set, with small
+ * nodes so that splits, borrows and merges happen at every level.
+ */
+template <class Set, typename T, class Gen>
+void churn_test(Gen gen, int rounds) {
+    std::mt19937    e(3);
+    Set             set;
+    std::set<T>     ref;
+
+    for (int i = 0; i < rounds; ++i) {
+        T k = gen(e);
+        if (e() % 5 < 2) {
+            set.remove(k);
+            ref.erase(k);
+        } else {
+            set.insert(k);
+            ref.insert(k);
+        }
+        assert(set.size() == ref.size());
+        if (i % 997 == 0) {
+            std::vector<T> keys;
+            set.for_each([&keys](const T& x) {keys.push_back(x);});
+            assert(keys == std::vector<T>(ref.begin(), ref.end()));
+        }
+    }
+    for (const T &k : ref)
+        assert(set.contains(k) && *set.find(k) == k);
+
+    Set copy(set);
+    assert(copy.size() == set.size());
+    for (const T &k : ref)
+        set.remove(k);
+    assert(set.size() == 0 && set.height() == 0 && set.leaf_count() == 0);
+    assert(!set.contains(*ref.begin()));
+    set = std::move(copy);
+    assert(set.size() == ref.size() && copy.size() == 0);
+}
+
+int
+main(void) {
+    auto small_int = [](std::mt19937 &e) {return static_cast<int>(e() % 3000);};
+    auto any_double = [](std::mt19937 &e) {return static_cast<double>(e() % 100000) / 7;};
+    auto str = [](std::mt19937 &e) {return "key number " + std::to_string(e() % 2000);};
+
+    churn_test<my::btree_set<int, 64>, int>(small_int, 200000);
+    churn_test<my::btree_set<int>, int>(small_int, 200000);
+    churn_test<my::btree_set<double>, double>(any_double, 200000);
+    churn_test<my::btree_set<std::string, 512>, std::string>(str, 50000);
+
+    // sorted input packs the nodes full: 60 ints a leaf, and inner
+    // nodes of 21 children make 16667 leaves four levels of them deep.
+    my::btree_set<int> sorted;
+    for (int i = 0; i < 1000000; ++i)
+        sorted.insert(i);
+    assert(sorted.size() == 1000000);
+    assert(sorted.leaf_count() == (1000000 + 59) / 60 && sorted.height() == 5);
+    assert(sorted.contains(0) && sorted.contains(999999) && !sorted.contains(1000000));
+    for (int i = 0; i < 1000000; i += 2)
+        sorted.remove(i);
+    assert(sorted.size() == 500000 && !sorted.contains(10) && sorted.contains(11));
+
+    // random input splits inner nodes in half: with 20 separators
+    // a node, none but the root drops below 10.
+    my::btree_set<int> shuffled;
+    std::mt19937 e(3);
+    for (int i = 0; i < 1000000; ++i)
+        shuffled.insert(static_cast<int>(e()));
+    assert(shuffled.height() >= 4 && shuffled.min_inner_count() >= 10);
+    assert(sorted.min_inner_count() >= 1);
+
+    std::cout << "btree_set tests passed" << std::endl;
+    return 0;
+}
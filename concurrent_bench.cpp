@@ -0,0 +1,132 @@
+/*
+ * Throughput of a shared ordered set under 1 to 64 threads, each
+ * running a mix of lookups and writes (inserts and removes in equal
+ * parts) on random keys from a range of 2^20, half of them present
+ * at the start. my::concurrent_set is compared with what it
+ * replaces: an AVL my::binary_search_tree behind one std::mutex,
+ * and behind a std::shared_timed_mutex that lets lookups share it.
+ * Every case runs for a fixed time and reports millions of
+ * operations per second over all threads.
+ *
+ * build: g++ -std=c++14 -O2 -pthread concurrent_bench.cpp -o concurrent_bench
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+
+#include "vector.hpp"
+#include "binary_search_tree.hpp"
+#include "concurrent_set.hpp"
+
+typedef std::chrono::steady_clock                         clock_type;
+typedef my::binary_search_tree<long, my::avl_balance>     avl_tree;
+
+const long    key_range = 1 << 20;
+
+// one mutex around everything.
+struct mutex_tree {
+    std::mutex    m;
+    avl_tree      tree;
+
+    bool contains(long k) { std::lock_guard<std::mutex> l(m); return tree.contains(k); }
+    void insert(long k) { std::lock_guard<std::mutex> l(m); tree.insert(k); }
+    void remove(long k) { std::lock_guard<std::mutex> l(m); tree.remove(k); }
+};
+
+// lookups share the lock, writes take it alone.
+struct rwlock_tree {
+    std::shared_timed_mutex    m;
+    avl_tree                   tree;
+
+    bool contains(long k) { std::shared_lock<std::shared_timed_mutex> l(m); return tree.contains(k); }
+    void insert(long k) { std::lock_guard<std::shared_timed_mutex> l(m); tree.insert(k); }
+    void remove(long k) { std::lock_guard<std::shared_timed_mutex> l(m); tree.remove(k); }
+};
+
+struct lazy_skip_list {
+    my::concurrent_set<long>    set;
+
+    bool contains(long k) { return set.contains(k); }
+    void insert(long k) { set.insert(k); }
+    void remove(long k) { set.remove(k); }
+};
+
+// per-thread results, a cache line apart.
+struct alignas(64) counter {
+    long    ops = 0;
+    long    hits = 0;
+};
+
+/* @fn run()
+ * threads threads for 200 ms each, write_pct percent writes.
+ */
+template <class Set>
+void run(const char *name, int threads, int write_pct) {
+    Set                            set;
+    std::atomic<bool>              go{false}, stop{false};
+    my::aligned_vector<counter>    counts(threads);
+    my::vector<std::thread>        pool;
+
+    for (long k = 0; k < key_range; k += 2)
+        set.insert(k);
+    for (int t = 0; t < threads; ++t)
+        pool.push_back(std::thread([&, t] {
+            std::mt19937_64    e(t + 1);
+            counter            c;
+            while (!go.load())
+                std::this_thread::yield();
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 64; ++i) {
+                    uint64_t r = e();
+                    long k = static_cast<long>(r % key_range);
+                    int dice = static_cast<int>((r >> 40) % 200);
+                    if (dice >= 2 * write_pct)
+                        c.hits += set.contains(k);
+                    else if (dice % 2)
+                        set.insert(k);
+                    else
+                        set.remove(k);
+                }
+                c.ops += 64;
+            }
+            counts[t] = c;
+        }));
+
+    auto start = clock_type::now();
+    go = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    stop = true;
+    for (auto &th : pool)
+        th.join();
+    double s = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    long ops = 0, hits = 0;
+    for (const counter &c : counts) {
+        ops += c.ops;
+        hits += c.hits;
+    }
+    std::cout << std::setw(8) << (100 - write_pct) << "/" << std::setw(2) << write_pct
+              << std::setw(10) << threads << std::setw(18) << name
+              << std::fixed << std::setprecision(2) << std::setw(12) << ops / s / 1e6
+              << "   (" << hits << ")" << std::endl;
+}
+
+int
+main(void) {
+    const int mixes[] = { 5, 50 };
+
+    std::cout << std::setw(11) << "read/write" << std::setw(10) << "threads"
+              << std::setw(18) << "set" << std::setw(12) << "Mops/s" << std::endl;
+    for (int write_pct : mixes)
+        for (int threads = 1; threads <= 64; threads *= 2) {
+            run<mutex_tree>("mutex avl", threads, write_pct);
+            run<rwlock_tree>("rwlock avl", threads, write_pct);
+            run<lazy_skip_list>("concurrent_set", threads, write_pct);
+        }
+    return 0;
+}
@@ -0,0 +1,395 @@
+#ifndef M_CONCURRENT_SET
+#define M_CONCURRENT_SET
+
+#include <atomic>
+#include <new>         // operator new(), placement new
+#include <thread>      // yield()
+#include <functional>  // less
+#include <cstdint>     // uint64_t
+#include <cstddef>     // size_t
+
+#include "epoch.hpp"
+
+namespace my {
+    /* @class concurrent_set
+     * An ordered set shared by many threads: a lazy skip list after
+     * Herlihy, Lev, Luchangco and Shavit. Lookups take no lock and
+     * never wait; they only pin an epoch. Writers lock the few nodes
+     * in front of the one they change, check that nothing moved, and
+     * link or unlink it. A removed node is marked first, so lookups
+     * treat it as gone from that point, and it is freed through
+     * epoch_retire() once no reader can still be on it. Each key is
+     * present from the moment its node is fully linked until it is
+     * marked, which makes every operation linearizable. Scans see a
+     * weakly consistent view.
+     */
+    template <typename T, class Compare = std::less<T>>
+    class concurrent_set {
+    public:
+        typedef T          value_type;
+        typedef size_t     size_type;
+        typedef Compare    key_compare;
+
+        // constructors and destructor; the destructor needs the set quiet.
+        explicit concurrent_set(const Compare& c = Compare());
+        concurrent_set(const concurrent_set&) = delete;
+        concurrent_set& operator=(const concurrent_set&) = delete;
+        ~concurrent_set();
+
+        // operations; insert() and remove() return whether they changed the set.
+        bool insert(const value_type& k);
+        bool remove(const value_type& k);
+        bool contains(const value_type& k) const;
+
+        /*
+         * f(key) for the keys in [lo, hi) in order, skipping those
+         * being removed. Keys inserted or removed during the scan
+         * may or may not be seen.
+         */
+        template <class F>
+        void for_each_in_range(const value_type& lo, const value_type& hi, F f) const;
+
+        /*
+         * Keys present, counted on a walk of the bottom level: O(n)
+         * and only a snapshot under writes, but with no shared
+         * counter for every writer to bounce between cores.
+         */
+        size_type size(void) const;
+        bool empty(void) const;
+
+    private:
+        static const int    max_level = 32;
+
+        class spin_lock {
+        public:
+            void lock(void) {
+                for (int spins = 0; locked.exchange(true, std::memory_order_acquire); )
+                    while (locked.load(std::memory_order_relaxed))
+                        if (++spins > 64)
+                            std::this_thread::yield();
+            }
+            void unlock(void) { locked.store(false, std::memory_order_release); }
+        private:
+            std::atomic<bool>    locked{false};
+        };
+
+        /*
+         * A node's top + 1 links are stored right behind it. The
+         * head is a bare node with max_level links; nullptr ends
+         * every level.
+         */
+        struct node {
+            std::atomic<node*>    *next;
+            int                   top;
+            std::atomic<bool>     marked{false};
+            std::atomic<bool>     linked{false};
+            spin_lock             lock;
+        };
+        struct key_node: node {
+            T    key;
+            explicit key_node(const T& k): key(k) {}
+        };
+        static const T& key(const node* nd) {return static_cast<const key_node*>(nd)->key;}
+
+        template <class Node>
+        static size_t links_offset(void) {
+            const size_t a = alignof(std::atomic<node*>);
+            return (sizeof(Node) + a - 1) / a * a;
+        }
+        static node* make_node(const T& k, int top);
+        static void destroy_node(void* p);
+        static int random_level(void);
+
+        int find(const value_type& k, node** preds, node** succs) const;
+        static void unlock_preds(node** preds, int highest);
+
+    private:
+        node                  *head;
+        std::atomic<int>      levels;    // above every top a linked node may have.
+        Compare               comp;
+    };
+
+    template <typename T, class Compare>
+    concurrent_set<T, Compare>::concurrent_set(const Compare& c)
+    : head(nullptr), levels(1), comp(c) {
+        void *p = ::operator new(links_offset<node>() + max_level * sizeof(std::atomic<node*>));
+        head = ::new (p) node;
+        head->top = max_level - 1;
+        head->next = reinterpret_cast<std::atomic<node*>*>(static_cast<char*>(p) +
+                                                           links_offset<node>());
+        for (int l = 0; l < max_level; ++l)
+            ::new (&head->next[l]) std::atomic<node*>(nullptr);
+        head->linked.store(true);
+    }
+
+    template <typename T, class Compare>
+    concurrent_set<T, Compare>::~concurrent_set() {
+        node *nd = head->next[0].load();
+
+        while (nd != nullptr) {
+            node *next = nd->next[0].load();
+            destroy_node(nd);
+            nd = next;
+        }
+        ::operator delete(head);
+    }
+
+    template <typename T, class Compare>
+    typename concurrent_set<T, Compare>::node *
+    concurrent_set<T, Compare>::make_node(const T& k, int top) {
+        void *p = ::operator new(links_offset<key_node>() + (top + 1) * sizeof(std::atomic<node*>));
+        key_node *nd;
+
+        try {
+            nd = ::new (p) key_node(k);
+        } catch (...) {
+            ::operator delete(p);
+            throw;
+        }
+        nd->top = top;
+        nd->next = reinterpret_cast<std::atomic<node*>*>(static_cast<char*>(p) +
+                                                         links_offset<key_node>());
+        for (int l = 0; l <= top; ++l)
+            ::new (&nd->next[l]) std::atomic<node*>(nullptr);
+        return nd;
+    }
+
+    template <typename T, class Compare>
+    void
+    concurrent_set<T, Compare>::destroy_node(void* p) {
+        key_node *nd = static_cast<key_node*>(static_cast<node*>(p));
+
+        nd->~key_node();
+        ::operator delete(static_cast<void*>(nd));
+    }
+
+    // a level above 0 with probability 1/2 each, from a per-thread xorshift.
+    template <typename T, class Compare>
+    int
+    concurrent_set<T, Compare>::random_level(void) {
+        static thread_local uint64_t    x = reinterpret_cast<uintptr_t>(&x) | 1;
+
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return __builtin_ctzll(x | uint64_t(1) << (max_level - 1));
+    }
+
+    /*
+     * Fills preds and succs with the last node before k and the
+     * first one not before it, on every level, and returns the
+     * highest level k was found on, or -1.
+     */
+    template <typename T, class Compare>
+    int
+    concurrent_set<T, Compare>::find(const value_type& k, node** preds, node** succs) const {
+        int     found = -1, top = levels.load(std::memory_order_acquire);
+        node    *pred = head;
+
+        for (int l = max_level - 1; l >= top; --l) {
+            preds[l] = head;
+            succs[l] = nullptr;
+        }
+        for (int l = top - 1; l >= 0; --l) {
+            node *cur = pred->next[l].load(std::memory_order_acquire);
+            while (cur != nullptr && comp(key(cur), k)) {
+                pred = cur;
+                cur = pred->next[l].load(std::memory_order_acquire);
+            }
+            if (found == -1 && cur != nullptr && !comp(k, key(cur)))
+                found = l;
+            preds[l] = pred;
+            succs[l] = cur;
+        }
+        return found;
+    }
+
+    // preds can repeat from one level to the next; each is locked once.
+    template <typename T, class Compare>
+    void
+    concurrent_set<T, Compare>::unlock_preds(node** preds, int highest) {
+        node *prev = nullptr;
+
+        for (int l = 0; l <= highest; ++l)
+            if (preds[l] != prev) {
+                preds[l]->lock.unlock();
+                prev = preds[l];
+            }
+    }
+
+    template <typename T, class Compare>
+    bool
+    concurrent_set<T, Compare>::insert(const value_type& k) {
+        node           *preds[max_level], *succs[max_level], *nd = nullptr;
+        int            top = random_level();
+        epoch_guard    guard;
+
+        // finds may skip the levels no node has reached yet.
+        for (int h = levels.load(); h <= top; )
+            levels.compare_exchange_weak(h, top + 1);
+
+        for (;;) {
+            int found = find(k, preds, succs);
+            if (found != -1) {
+                node *other = succs[found];
+                if (!other->marked.load(std::memory_order_acquire)) {
+                    // present, or about to be: wait for its insert to finish.
+                    while (!other->linked.load(std::memory_order_acquire))
+                        std::this_thread::yield();
+                    if (nd != nullptr)
+                        destroy_node(nd);
+                    return false;
+                }
+                continue;
+            }
+
+            if (nd == nullptr)
+                nd = make_node(k, top);
+
+            // lock bottom up, which is from the largest key down.
+            int     highest = -1;
+            bool    valid = true;
+            node    *prev = nullptr;
+            for (int l = 0; valid && l <= top; ++l) {
+                node *pred = preds[l], *succ = succs[l];
+                if (pred != prev) {
+                    pred->lock.lock();
+                    prev = pred;
+                }
+                highest = l;
+                valid = !pred->marked.load() && (succ == nullptr || !succ->marked.load()) &&
+                        pred->next[l].load() == succ;
+            }
+            if (!valid) {
+                unlock_preds(preds, highest);
+                continue;
+            }
+
+            for (int l = 0; l <= top; ++l)
+                nd->next[l].store(succs[l], std::memory_order_relaxed);
+            for (int l = 0; l <= top; ++l)
+                preds[l]->next[l].store(nd, std::memory_order_release);
+            nd->linked.store(true, std::memory_order_release);
+            unlock_preds(preds, highest);
+            return true;
+        }
+    }
+
+    template <typename T, class Compare>
+    bool
+    concurrent_set<T, Compare>::remove(const value_type& k) {
+        node           *preds[max_level], *succs[max_level], *victim = nullptr;
+        int            top = -1;
+        epoch_guard    guard;
+
+        for (;;) {
+            int found = find(k, preds, succs);
+            if (victim == nullptr) {
+                // only a fully linked node, found on its own top level, can go.
+                if (found == -1)
+                    return false;
+                node *nd = succs[found];
+                if (!nd->linked.load(std::memory_order_acquire) || nd->top != found ||
+                    nd->marked.load(std::memory_order_acquire))
+                    return false;
+                nd->lock.lock();
+                if (nd->marked.load()) {
+                    nd->lock.unlock();
+                    return false;
+                }
+                nd->marked.store(true, std::memory_order_release);
+                victim = nd;
+                top = nd->top;
+            }
+
+            int     highest = -1;
+            bool    valid = true;
+            node    *prev = nullptr;
+            for (int l = 0; valid && l <= top; ++l) {
+                node *pred = preds[l];
+                if (pred != prev) {
+                    pred->lock.lock();
+                    prev = pred;
+                }
+                highest = l;
+                valid = !pred->marked.load() && pred->next[l].load() == victim;
+            }
+            if (!valid) {
+                unlock_preds(preds, highest);
+                continue;
+            }
+
+            for (int l = top; l >= 0; --l)
+                preds[l]->next[l].store(victim->next[l].load(std::memory_order_relaxed),
+                                        std::memory_order_release);
+            victim->lock.unlock();
+            unlock_preds(preds, highest);
+            epoch_retire(victim, destroy_node);
+            return true;
+        }
+    }
+
+    // stops at the first level the key shows up on.
+    template <typename T, class Compare>
+    bool
+    concurrent_set<T, Compare>::contains(const value_type& k) const {
+        epoch_guard    guard;
+        node           *pred = head;
+
+        for (int l = levels.load(std::memory_order_acquire) - 1; l >= 0; --l) {
+            node *cur = pred->next[l].load(std::memory_order_acquire);
+            while (cur != nullptr && comp(key(cur), k)) {
+                pred = cur;
+                cur = pred->next[l].load(std::memory_order_acquire);
+            }
+            if (cur != nullptr && !comp(k, key(cur)))
+                return cur->linked.load(std::memory_order_acquire) &&
+                       !cur->marked.load(std::memory_order_acquire);
+        }
+        return false;
+    }
+
+    template <typename T, class Compare>
+    template <class F>
+    void
+    concurrent_set<T, Compare>::for_each_in_range(const value_type& lo,
+                                                  const value_type& hi, F f) const {
+        node           *preds[max_level], *succs[max_level];
+        epoch_guard    guard;
+
+        find(lo, preds, succs);
+        for (node *nd = succs[0]; nd != nullptr && comp(key(nd), hi);
+             nd = nd->next[0].load(std::memory_order_acquire))
+            if (nd->linked.load(std::memory_order_acquire) &&
+                !nd->marked.load(std::memory_order_acquire))
+                f(key(nd));
+    }
+
+    template <typename T, class Compare>
+    typename concurrent_set<T, Compare>::size_type
+    concurrent_set<T, Compare>::size(void) const {
+        epoch_guard    guard;
+        size_type      n = 0;
+
+        for (node *nd = head->next[0].load(std::memory_order_acquire); nd != nullptr;
+             nd = nd->next[0].load(std::memory_order_acquire))
+            n += nd->linked.load(std::memory_order_acquire) &&
+                 !nd->marked.load(std::memory_order_acquire);
+        return n;
+    }
+
+    template <typename T, class Compare>
+    bool
+    concurrent_set<T, Compare>::empty(void) const {
+        epoch_guard    guard;
+
+        for (node *nd = head->next[0].load(std::memory_order_acquire); nd != nullptr;
+             nd = nd->next[0].load(std::memory_order_acquire))
+            if (nd->linked.load(std::memory_order_acquire) &&
+                !nd->marked.load(std::memory_order_acquire))
+                return false;
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "concurrent_set.hpp"
+
+// one thread, checked against std::set.
+void sequential_test(void) {
+    my::concurrent_set<int> set;
+    std::set<int> ref;
+    std::mt19937 e(1);
+
+    assert(set.empty() && !set.contains(0));
+    for (int i = 0; i < 50000; ++i) {
+        int k = static_cast<int>(e() % 5000);
+        if (i % 3 == 2)
+            assert(set.remove(k) == (ref.erase(k) == 1));
+        else
+            assert(set.insert(k) == ref.insert(k).second);
+    }
+    assert(set.size() == ref.size());
+    for (int k = -1; k <= 5000; ++k)
+        assert(set.contains(k) == (ref.count(k) == 1));
+
+    std::vector<int> got;
+    set.for_each_in_range(1000, 2000, [&got](int k) {got.push_back(k);});
+    assert(std::equal(got.begin(), got.end(), ref.lower_bound(1000), ref.lower_bound(2000)));
+}
+
+/*
+ * Writers insert and remove the even keys while readers check that
+ * the odd keys, inserted up front and never touched, are always
+ * there and that no key outside the range ever shows up.
+ */
+void concurrent_test(void) {
+    my::concurrent_set<long> set;
+    const long n = 20000;
+    const int writers = 4, readers = 4;
+    std::atomic<bool> stop{false};
+    std::atomic<long> inserted{0}, removed{0};
+
+    for (long k = 1; k < n; k += 2)
+        set.insert(k);
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; ++w)
+        threads.emplace_back([&, w] {
+            std::mt19937 e(w);
+            for (int i = 0; i < 100000; ++i) {
+                long k = static_cast<long>(e() % (n / 2)) * 2;
+                if (e() % 2)
+                    inserted += set.insert(k);
+                else
+                    removed += set.remove(k);
+            }
+        });
+    for (int r = 0; r < readers; ++r)
+        threads.emplace_back([&, r] {
+            std::mt19937 e(100 + r);
+            while (!stop.load()) {
+                long k = static_cast<long>(e() % n);
+                if (k % 2)
+                    assert(set.contains(k));
+                assert(!set.contains(n + k));
+                long prev = -1;
+                set.for_each_in_range(k, k + 50, [&prev](long key) {
+                    assert(key > prev);
+                    prev = key;
+                });
+            }
+        });
+    for (int w = 0; w < writers; ++w)
+        threads[w].join();
+    stop = true;
+    for (size_t t = writers; t < threads.size(); ++t)
+        threads[t].join();
+
+    // every successful insert and remove of an even key is accounted for.
+    long evens = 0;
+    for (long k = 0; k < n; k += 2)
+        evens += set.contains(k);
+    assert(evens == inserted - removed);
+    assert(set.size() == static_cast<size_t>(n / 2 + evens));
+}
+
+// string keys have destructors to run when their nodes are reclaimed.
+void string_test(void) {
+    my::concurrent_set<std::string> set;
+    std::vector<std::thread> threads;
+    auto name = [](int i) {return "a key long enough to allocate " + std::to_string(i);};
+
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&set, &name, t] {
+            for (int i = t; i < 8000; i += 4)
+                assert(set.insert(name(i)));
+            for (int i = t; i < 8000; i += 4)
+                if (i % 8 < 4)
+                    assert(set.remove(name(i)));
+        });
+    for (auto &t : threads)
+        t.join();
+    assert(set.size() == 4000);
+    for (int i = 0; i < 8000; ++i)
+        assert(set.contains(name(i)) == (i % 8 >= 4));
+}
+
+int
+main(void) {
+    sequential_test();
+    concurrent_test();
+    string_test();
+    std::cout << "concurrent_set tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,155 @@
+#ifndef M_EPOCH
+#define M_EPOCH
+
+#include <atomic>
+#include <cstdint>    // uint64_t
+#include <cstdlib>    // posix_memalign()
+#include <new>        // bad_alloc, placement new
+
+#include "vector.hpp"
+
+namespace my {
+    /*
+     * Epoch-based reclamation for lock-free readers. A thread reads
+     * shared nodes only inside an epoch_guard; a writer that unlinks
+     * a node hands it to epoch_retire() instead of freeing it, and
+     * it is freed once every thread that could still hold it has
+     * left its guard. The global epoch moves forward when all pinned
+     * threads have seen its current value, and a node retired in
+     * epoch e is safe to free from epoch e + 2 on. Pinning is a
+     * load, a store and a fence and never waits, so readers never
+     * block; a thread parked inside a guard only delays reclamation.
+     *
+     * There is one process-wide domain. Each thread takes a record
+     * the first time it pins and gives it back when it exits; nodes
+     * it retired but could not free yet stay with the record for
+     * the next thread that takes it.
+     */
+    namespace epoch_detail {
+        struct retired {
+            void        *p;
+            void        (*destroy)(void*);
+            uint64_t    epoch;
+        };
+
+        struct alignas(64) record {
+            // epoch << 1 | 1 while pinned, 0 otherwise.
+            std::atomic<uint64_t>    state{0};
+            std::atomic<bool>        in_use{true};
+            record                   *next = nullptr;
+            unsigned                 nesting = 0;
+            vector<retired>          garbage;
+        };
+
+        struct domain {
+            std::atomic<uint64_t>    epoch{1};
+            std::atomic<record*>     records{nullptr};
+
+            // a free record, or a new one pushed on the list for good.
+            record* acquire(void) {
+                for (record *r = records.load(); r != nullptr; r = r->next) {
+                    bool free = false;
+                    if (!r->in_use.load() && r->in_use.compare_exchange_strong(free, true))
+                        return r;
+                }
+                // a cache line each, so pinning does not disturb other threads.
+                void *p = nullptr;
+                if (posix_memalign(&p, alignof(record), sizeof(record)) != 0)
+                    throw std::bad_alloc();
+                record *r = ::new (p) record;
+                r->next = records.load();
+                while (!records.compare_exchange_weak(r->next, r))
+                    ;
+                return r;
+            }
+
+            // moves the epoch on if no pinned thread is behind it.
+            void try_advance(void) {
+                uint64_t e = epoch.load();
+                for (record *r = records.load(); r != nullptr; r = r->next) {
+                    uint64_t s = r->state.load();
+                    if ((s & 1) && (s >> 1) != e)
+                        return;
+                }
+                epoch.compare_exchange_strong(e, e + 1);
+            }
+
+            void collect(record *r) {
+                uint64_t e = epoch.load();
+                size_t kept = 0;
+                for (size_t i = 0; i < r->garbage.size(); ++i) {
+                    retired g = r->garbage[i];
+                    if (g.epoch + 2 <= e)
+                        g.destroy(g.p);
+                    else
+                        r->garbage[kept++] = g;
+                }
+                r->garbage.resize(kept);
+            }
+        };
+
+        inline domain& global(void) {
+            static domain d;
+            return d;
+        }
+
+        // the calling thread's record, given back when the thread exits.
+        struct owner {
+            record    *r = nullptr;
+            ~owner() { if (r) r->in_use.store(false); }
+        };
+        inline record& local(void) {
+            static thread_local owner o;
+            if (o.r == nullptr)
+                o.r = global().acquire();
+            return *o.r;
+        }
+
+        // retired nodes a thread keeps before it tries to free some.
+        const size_t    collect_every = 64;
+    }
+
+    /* @class epoch_guard
+     * Pins the calling thread to the current epoch for its lifetime;
+     * guards nest.
+     */
+    class epoch_guard {
+    public:
+        epoch_guard(): r(epoch_detail::local()) {
+            if (r.nesting++ == 0) {
+                uint64_t e = epoch_detail::global().epoch.load();
+                r.state.store(e << 1 | 1, std::memory_order_relaxed);
+                // the pin must be visible before any shared pointer is read.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+        epoch_guard(const epoch_guard&) = delete;
+        epoch_guard& operator=(const epoch_guard&) = delete;
+        ~epoch_guard() {
+            if (--r.nesting == 0)
+                r.state.store(0, std::memory_order_release);
+        }
+
+    private:
+        epoch_detail::record    &r;
+    };
+
+    /* @fn epoch_retire()
+     * destroy(p) once no guard entered before this call is still
+     * alive. p must already be unreachable for new readers.
+     */
+    inline void epoch_retire(void *p, void (*destroy)(void*)) {
+        epoch_detail::domain    &d = epoch_detail::global();
+        epoch_detail::record    &r = epoch_detail::local();
+
+        // the unlink must be visible before the epoch is read.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        r.garbage.push_back(epoch_detail::retired{p, destroy, d.epoch.load()});
+        if (r.garbage.size() % epoch_detail::collect_every == 0) {
+            d.try_advance();
+            d.collect(&r);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ * Growth policies and huge pages for large my::vector buffers. Each
+ * case runs in a forked child, so that its peak resident set
+ * (VmHWM) and peak address space (VmPeak) are its own; both are
+ * read from /proc/self/status. "legacy" reproduces the old
+ * behaviour, where resize(n) reserved 2n. Linux only.
+ *
+ * build: g++ -std=c++14 -O2 growth_bench.cpp -o growth_bench
+ */
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "vector.hpp"
+
+typedef std::chrono::steady_clock    clock_type;
+
+// resize(n) asked for 2n slots before growth became a policy.
+struct grow_legacy {
+    static size_t next(size_t cap, size_t needed, size_t) {
+        return std::max(2 * cap, 2 * needed);
+    }
+};
+
+/* @struct record
+ * 16 bytes that are not trivially relocatable, so growth has to
+ * move every element into a new block while the old one is alive.
+ */
+struct record {
+    double    key;
+    long      id;
+
+    record(): key(0), id(0) {}
+    record(const record &r) noexcept: key(r.key), id(r.id) {}
+    record& operator=(const record &r) noexcept { key = r.key; id = r.id; return *this; }
+};
+
+long status_kb(const char *field) {
+    std::ifstream    in("/proc/self/status");
+    std::string      line;
+
+    while (std::getline(in, line))
+        if (line.compare(0, std::string(field).size(), field) == 0)
+            return std::stol(line.substr(line.find(':') + 1));
+    return -1;
+}
+
+const size_t    N = 50000000;
+
+/* @fn resize_steps()
+ * Grow by resize() in 1% steps, writing each new slot, as a job
+ * that appends a chunk of results at a time does.
+ */
+template <class Vec>
+double resize_steps(void) {
+    Vec     vec;
+    auto    start = clock_type::now();
+
+    for (size_t n = N / 100; n <= N; n += N / 100) {
+        size_t old = vec.size();
+        vec.resize(n);
+        for (size_t i = old; i < n; ++i)
+            vec[i] = static_cast<double>(i);
+    }
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+template <class Vec>
+double push_records(void) {
+    Vec     vec;
+    record  r;
+    auto    start = clock_type::now();
+
+    for (size_t i = 0; i < N / 2; ++i) {
+        r.id = static_cast<long>(i);
+        vec.push_back(r);
+    }
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+/* @fn random_reads()
+ * 10^7 dependent random reads over a 1 GB array; the working set
+ * is far beyond the TLB reach of 4 KB pages.
+ */
+template <class Vec>
+double random_reads(void) {
+    const size_t    n = size_t(1) << 27;
+    Vec             vec;
+    vec.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        vec[i] = static_cast<double>((i * 2654435761u) & (n - 1));
+
+    auto      start = clock_type::now();
+    size_t    j = 0;
+    for (size_t k = 0; k < 10000000; ++k)
+        j = static_cast<size_t>(vec[j]) ^ (k & 7);
+    double ms = std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+    if (j == size_t(-1))
+        std::cout << j;
+    return ms;
+}
+
+void run(const char *test, const char *variant, double (*fn)(void)) {
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        double ms = fn();
+        std::cout << std::setw(14) << test << std::setw(14) << variant
+                  << std::fixed << std::setprecision(1) << std::setw(10) << ms
+                  << std::setw(14) << status_kb("VmHWM") / 1024
+                  << std::setw(14) << status_kb("VmPeak") / 1024 << std::endl;
+        _exit(0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+}
+
+template <class G>
+using dvec = my::vector<double, my::allocator<double>, G>;
+template <class G>
+using rvec = my::vector<record, my::allocator<record>, G>;
+typedef my::vector<double, my::huge_page_allocator<double>>    huge_dvec;
+typedef my::vector<record, my::huge_page_allocator<record>>    huge_rvec;
+
+int
+main(void) {
+    std::cout << std::setw(14) << "test" << std::setw(14) << "policy"
+              << std::setw(10) << "ms" << std::setw(14) << "peak RSS MB"
+              << std::setw(14) << "peak VM MB" << std::endl;
+
+    run("resize_steps", "legacy", resize_steps<dvec<grow_legacy>>);
+    run("resize_steps", "double", resize_steps<dvec<my::grow_double>>);
+    run("resize_steps", "by_half", resize_steps<dvec<my::grow_by_half>>);
+    run("resize_steps", "exact", resize_steps<dvec<my::grow_exact>>);
+    run("resize_steps", "page_rounded", resize_steps<dvec<my::grow_page_rounded<>>>);
+    run("resize_steps", "huge_pages", resize_steps<huge_dvec>);
+
+    run("push_records", "legacy", push_records<rvec<grow_legacy>>);
+    run("push_records", "double", push_records<rvec<my::grow_double>>);
+    run("push_records", "by_half", push_records<rvec<my::grow_by_half>>);
+    run("push_records", "page_rounded", push_records<rvec<my::grow_page_rounded<>>>);
+    run("push_records", "huge_pages", push_records<huge_rvec>);
+
+    run("random_reads", "double", random_reads<dvec<my::grow_double>>);
+    run("random_reads", "huge_pages", random_reads<huge_dvec>);
+
+    return 0;
+}
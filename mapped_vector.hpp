@@ -0,0 +1,336 @@
+#ifndef M_MAPPED_VECTOR
+#define M_MAPPED_VECTOR
+
+#include <string>
+#include <cstdint>        // uint64_t
+#include <cstring>        // memcpy(), memcmp(), memset()
+#include <cerrno>
+#include <system_error>   // system_error
+#include <stdexcept>      // runtime_error
+#include <type_traits>
+#include <iterator>       // distance()
+
+#include <fcntl.h>        // open()
+#include <unistd.h>       // ftruncate(), close(), sysconf()
+#include <sys/mman.h>     // mmap(), mremap(), munmap(), madvise(), msync()
+#include <sys/stat.h>     // fstat()
+
+namespace my {
+    /* @class mapped_vector
+     * A vector of trivially copyable elements kept in a file through
+     * mmap(), for data larger than memory or kept between runs. The
+     * file starts with a 64-byte header recording the element size
+     * and count, followed by the elements themselves; the file length
+     * is the capacity. Opening an existing file maps it in place, no
+     * element is read or copied. Growth extends the file with
+     * ftruncate() and the mapping with mremap(). Writes reach the
+     * file when the kernel flushes the pages; sync() forces them out.
+     * Linux only (mremap). Errors from the system calls are thrown as
+     * std::system_error.
+     */
+    template <typename T>
+    class mapped_vector {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "mapped_vector needs trivially copyable elements");
+        static_assert(alignof(T) <= 64, "elements are stored at a 64-byte offset");
+    public:
+        typedef size_t     size_type;
+        typedef T          value_type;
+        typedef T*         iterator;
+        typedef const T*   const_iterator;
+
+        // access patterns for advise().
+        enum class access { normal, sequential, random, will_need, dont_need };
+
+        // constructors and destructor.
+        explicit mapped_vector(const std::string &path);
+        mapped_vector(const mapped_vector&) = delete;
+        mapped_vector(mapped_vector &&vec);
+        ~mapped_vector() { close(); }
+
+        // assginments.
+        mapped_vector& operator=(const mapped_vector&) = delete;
+        mapped_vector& operator=(mapped_vector &&vec);
+
+        // iterator.
+        iterator begin() { return b; }
+        const_iterator begin() const { return b; }
+        iterator end() { return b + size(); }
+        const_iterator end() const { return b + size(); }
+
+        const_iterator cbegin() const { return b; }
+        const_iterator bend() const { return b + size(); }
+
+        // size.
+        size_type size(void) const { return h ? h->size : 0; }
+        void resize(size_type n);
+        void resize(size_type n, const value_type &val);
+        size_type capacity(void) const { return cap; }
+        bool empty(void) const { return size() == 0; }
+        void reserve(size_type n);
+        void shrink_to_fit(void);
+
+        // access.
+        T& operator[](size_type n) { return b[n]; }
+        const T& operator[](size_type n) const { return b[n]; }
+        T& front(void) { return b[0]; }
+        const T& front(void) const { return b[0]; }
+        T& back(void) {return b[size() - 1]; }
+        const T& back(void) const { return b[size() - 1]; }
+
+        // modifiers; the range of append() must not point into *this.
+        void push_back(const value_type &val);
+        void pop_back(void) { --h->size; }
+        template <class Iter>
+        void append(Iter first, Iter last);
+        void clear() { h->size = 0; }
+
+        /*
+         * Paging hints and durability. advise() passes the pattern
+         * to madvise() for the whole mapping; sync() writes dirty
+         * pages back with msync(), waiting for the disk unless wait
+         * is false. close() unmaps and closes the file early.
+         */
+        void advise(access pattern);
+        void sync(bool wait = true);
+        void close(void);
+
+        const std::string& path(void) const { return name; }
+
+    private:
+        /*
+         * The first 64 bytes of the file; the elements follow, so
+         * they are aligned for any T the static_assert lets in.
+         */
+        struct header {
+            char        magic[8];
+            uint64_t    elem_size;
+            uint64_t    size;
+            char        pad[40];
+        };
+        static_assert(sizeof(header) == 64, "header must be 64 bytes");
+        static const char* magic(void) { return "myvec01"; }
+
+        static size_t page_size(void) {
+            static const size_t ps = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            return ps;
+        }
+        // bytes of a file holding n elements, rounded up to pages.
+        static size_t bytes_for(size_type n) {
+            size_t bytes = sizeof(header) + n * sizeof(T);
+            return (bytes + page_size() - 1) / page_size() * page_size();
+        }
+        static void fail(const char *what) {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+        void remap(size_t bytes);
+
+    private:
+        std::string    name;
+        int            fd;
+        void           *map;
+        size_t         map_bytes;
+        header         *h;
+        T              *b;
+        size_type      cap;
+    };
+
+    template <typename T>
+    mapped_vector<T>::mapped_vector(const std::string &path)
+    : name(path), fd(-1), map(nullptr), map_bytes(0), h(nullptr), b(nullptr), cap(0) {
+        struct stat st;
+
+        if ((fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644)) < 0)
+            fail("mapped_vector: open");
+        if (fstat(fd, &st) < 0) {
+            int err = errno;
+            ::close(fd);
+            errno = err;
+            fail("mapped_vector: fstat");
+        }
+
+        bool fresh = st.st_size == 0;
+        size_t bytes = fresh ? bytes_for(0) : static_cast<size_t>(st.st_size);
+        try {
+            if (fresh && ftruncate(fd, bytes) < 0)
+                fail("mapped_vector: ftruncate");
+            if (bytes < sizeof(header))
+                throw std::runtime_error("mapped_vector: " + path + " is too short");
+            map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (map == MAP_FAILED) {
+                map = nullptr;
+                fail("mapped_vector: mmap");
+            }
+            map_bytes = bytes;
+            h = static_cast<header*>(map);
+            if (fresh) {
+                std::memcpy(h->magic, magic(), sizeof(h->magic));
+                h->elem_size = sizeof(T);
+                h->size = 0;
+            } else if (std::memcmp(h->magic, magic(), sizeof(h->magic)) != 0 ||
+                       h->elem_size != sizeof(T)) {
+                throw std::runtime_error("mapped_vector: " + path +
+                                         " does not hold elements of this type");
+            }
+            b = reinterpret_cast<T*>(h + 1);
+            cap = (map_bytes - sizeof(header)) / sizeof(T);
+            if (h->size > cap)
+                throw std::runtime_error("mapped_vector: " + path + " is truncated");
+        } catch (...) {
+            close();
+            throw;
+        }
+    }
+
+    template <typename T>
+    mapped_vector<T>::mapped_vector(mapped_vector &&vec)
+    : name(std::move(vec.name)), fd(vec.fd), map(vec.map), map_bytes(vec.map_bytes),
+      h(vec.h), b(vec.b), cap(vec.cap) {
+        vec.fd = -1;
+        vec.map = nullptr;
+        vec.map_bytes = 0;
+        vec.h = nullptr;
+        vec.b = nullptr;
+        vec.cap = 0;
+    }
+
+    template <typename T>
+    mapped_vector<T>&
+    mapped_vector<T>::operator=(mapped_vector &&vec) {
+        if (this != &vec) {
+            close();
+            name = std::move(vec.name);
+            fd = vec.fd; map = vec.map; map_bytes = vec.map_bytes;
+            h = vec.h; b = vec.b; cap = vec.cap;
+            vec.fd = -1;
+            vec.map = nullptr;
+            vec.map_bytes = 0;
+            vec.h = nullptr;
+            vec.b = nullptr;
+            vec.cap = 0;
+        }
+        return *this;
+    }
+
+    template <typename T>
+    void
+    mapped_vector<T>::close(void) {
+        if (map != nullptr)
+            munmap(map, map_bytes);
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+        map = nullptr;
+        map_bytes = 0;
+        h = nullptr;
+        b = nullptr;
+        cap = 0;
+    }
+
+    /*
+     * Growing resizes the file first, then the mapping; shrinking
+     * the mapping first, then the file. mremap() may move the
+     * mapping, so every pointer into it is refreshed as soon as it
+     * returns: if the shrinking ftruncate() then fails, the object
+     * still describes the smaller mapping, over a longer file.
+     */
+    template <typename T>
+    void
+    mapped_vector<T>::remap(size_t bytes) {
+        bool shrink = bytes < map_bytes;
+
+        if (!shrink && ftruncate(fd, bytes) < 0)
+            fail("mapped_vector: ftruncate");
+        void *p = mremap(map, map_bytes, bytes, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED)
+            fail("mapped_vector: mremap");
+        map = p;
+        map_bytes = bytes;
+        h = static_cast<header*>(map);
+        b = reinterpret_cast<T*>(h + 1);
+        cap = (map_bytes - sizeof(header)) / sizeof(T);
+        if (shrink && ftruncate(fd, bytes) < 0)
+            fail("mapped_vector: ftruncate");
+    }
+
+    template <typename T>
+    void
+    mapped_vector<T>::reserve(size_type n) {
+        if (n > cap)
+            remap(bytes_for(n));
+    }
+
+    template <typename T>
+    void
+    mapped_vector<T>::shrink_to_fit(void) {
+        size_t bytes = bytes_for(size());
+        if (bytes < map_bytes)
+            remap(bytes);
+    }
+
+    template <typename T>
+    void
+    mapped_vector<T>::resize(size_type n) {
+        reserve(n);
+        // slots past size() may still hold popped elements.
+        if (n > size())
+            std::memset(static_cast<void*>(b + size()), 0, (n - size()) * sizeof(T));
+        h->size = n;
+    }
+
+    template <typename T>
+    void
+    mapped_vector<T>::resize(size_type n, const value_type &val) {
+        reserve(n);
+        for (size_type i = size(); i < n; ++i)
+            b[i] = val;
+        h->size = n;
+    }
+
+    template <typename T>
+    void
+    mapped_vector<T>::push_back(const value_type &val) {
+        if (size() == cap) {
+            // val may live in the mapping that is about to move.
+            T tmp = val;
+            reserve(cap ? 2 * cap : page_size() / sizeof(T) + 1);
+            b[h->size++] = tmp;
+            return;
+        }
+        b[h->size++] = val;
+    }
+
+    template <typename T>
+    template <class Iter>
+    void
+    mapped_vector<T>::append(Iter first, Iter last) {
+        typedef typename std::iterator_traits<Iter>::iterator_category    category;
+
+        if (std::is_base_of<std::forward_iterator_tag, category>::value) {
+            size_type n = size() + static_cast<size_type>(std::distance(first, last));
+            if (n > cap)
+                reserve(n > 2 * cap ? n : 2 * cap);
+        }
+        for ( ; first != last; ++first)
+            push_back(*first);
+    }
+
+    template <typename T>
+    void
+    mapped_vector<T>::advise(access pattern) {
+        static const int advice[] = {
+            MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED, MADV_DONTNEED
+        };
+        if (map != nullptr && madvise(map, map_bytes, advice[static_cast<int>(pattern)]) < 0)
+            fail("mapped_vector: madvise");
+    }
+
+    template <typename T>
+    void
+    mapped_vector<T>::sync(bool wait) {
+        if (map != nullptr && msync(map, map_bytes, wait ? MS_SYNC : MS_ASYNC) < 0)
+            fail("mapped_vector: msync");
+    }
+}
+
+#endif
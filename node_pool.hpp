@@ -0,0 +1,164 @@
+#ifndef M_NODE_POOL
+#define M_NODE_POOL
+
+#include <cstddef>    // size_t, max_align_t
+#include <cstdlib>    // malloc(), free(), posix_memalign()
+#include <new>        // bad_alloc
+#include <utility>    // swap()
+
+namespace my {
+    /* @class node_pool
+     * Fixed-size blocks for the nodes of a linked container. Blocks
+     * are carved out of slabs that double in size up to max_slab
+     * nodes; a freed block goes on a LIFO free list and is the next
+     * one handed out, while it is still warm in cache. release()
+     * frees every slab at once without looking at the blocks, so the
+     * owner must have destroyed the objects in them first (or not
+     * need to, for trivially destructible ones). Not thread-safe.
+     */
+    template <typename Node>
+    class node_pool {
+    public:
+        node_pool(): slabs(nullptr), cur(nullptr), last(nullptr), free_list(nullptr),
+                     next_count(first_slab), slab_total(0) {}
+        node_pool(const node_pool&) = delete;
+        node_pool(node_pool &&pool): node_pool() { swap(pool); }
+        node_pool& operator=(const node_pool&) = delete;
+        node_pool& operator=(node_pool &&pool) {
+            if (this != &pool) {
+                release();
+                swap(pool);
+            }
+            return *this;
+        }
+        ~node_pool() { release(); }
+
+        // raw storage for one Node.
+        void* allocate(void);
+        void deallocate(void *p);
+        /*
+         * Makes the next n allocate() calls, free list aside, come
+         * from one slab, one block after another. Whatever is left of
+         * the current slab is given up if it is too small.
+         */
+        void reserve(size_t n);
+        void release(void);
+        void swap(node_pool &pool);
+
+        // slabs currently held, and their total size in bytes.
+        size_t slab_count(void) const;
+        size_t bytes(void) const { return slab_total; }
+
+    private:
+        union block {
+            block    *next;
+            alignas(Node) unsigned char    storage[sizeof(Node)];
+        };
+        struct slab {
+            slab      *next;
+            size_t    bytes;
+        };
+        static const size_t    first_slab = 64;
+        static const size_t    max_slab = 16384;
+
+        // the blocks of a slab start at the first aligned address after it.
+        static const size_t    header = (sizeof(slab) + alignof(block) - 1) /
+                                        alignof(block) * alignof(block);
+        void new_slab(size_t count);
+
+    private:
+        slab      *slabs;
+        block     *cur;         // next never-used block of the newest slab.
+        block     *last;        // end of the newest slab.
+        block     *free_list;
+        size_t    next_count;
+        size_t    slab_total;
+    };
+
+    template <typename Node>
+    void
+    node_pool<Node>::new_slab(size_t count) {
+        size_t bytes = header + count * sizeof(block);
+        void *p = nullptr;
+
+        // over-aligned nodes, e.g. cache-line sized ones, need more than malloc().
+        if (alignof(block) <= alignof(std::max_align_t))
+            p = std::malloc(bytes);
+        else if (posix_memalign(&p, alignof(block), bytes) != 0)
+            p = nullptr;
+        if (p == nullptr)
+            throw std::bad_alloc();
+        slab *s = static_cast<slab*>(p);
+        s->next = slabs;
+        s->bytes = bytes;
+        slabs = s;
+        cur = reinterpret_cast<block*>(reinterpret_cast<char*>(s) + header);
+        last = cur + count;
+        slab_total += bytes;
+    }
+
+    template <typename Node>
+    void*
+    node_pool<Node>::allocate(void) {
+        if (block *b = free_list) {
+            free_list = b->next;
+            return b;
+        }
+        if (cur == last) {
+            new_slab(next_count);
+            if (next_count < max_slab)
+                next_count *= 2;
+        }
+        return cur++;
+    }
+
+    template <typename Node>
+    void
+    node_pool<Node>::deallocate(void *p) {
+        block *b = static_cast<block*>(p);
+        b->next = free_list;
+        free_list = b;
+    }
+
+    template <typename Node>
+    void
+    node_pool<Node>::reserve(size_t n) {
+        if (static_cast<size_t>(last - cur) < n)
+            new_slab(n);
+    }
+
+    template <typename Node>
+    void
+    node_pool<Node>::release(void) {
+        while (slabs != nullptr) {
+            slab *next = slabs->next;
+            std::free(slabs);
+            slabs = next;
+        }
+        cur = last = free_list = nullptr;
+        next_count = first_slab;
+        slab_total = 0;
+    }
+
+    template <typename Node>
+    void
+    node_pool<Node>::swap(node_pool &pool) {
+        std::swap(slabs, pool.slabs);
+        std::swap(cur, pool.cur);
+        std::swap(last, pool.last);
+        std::swap(free_list, pool.free_list);
+        std::swap(next_count, pool.next_count);
+        std::swap(slab_total, pool.slab_total);
+    }
+
+    template <typename Node>
+    size_t
+    node_pool<Node>::slab_count(void) const {
+        size_t n = 0;
+        for (slab *s = slabs; s != nullptr; s = s->next)
+            ++n;
+        return n;
+    }
+}
+
+#endif
@@ -0,0 +1,333 @@
+#ifndef M_PERSISTENT_SET
+#define M_PERSISTENT_SET
+
+#include <atomic>
+#include <cstddef>     // size_t
+#include <functional>  // less
+#include <algorithm>   // max()
+#include <utility>     // swap()
+
+namespace my {
+    /* @class persistent_set
+     * An ordered set whose copies are snapshots. Nodes never change
+     * once built and are shared between versions through atomic
+     * reference counts, so copying a set is O(1): it takes one more
+     * reference to the root. An update copies only the nodes on its
+     * path, O(log n) of them since the tree is AVL balanced, and
+     * leaves every other version as it was.
+     *
+     * Each persistent_set object is used by one thread at a time,
+     * like any container, but a copy can be handed to another thread
+     * and read there without locks while the original keeps being
+     * updated: nothing either of them can reach is ever written
+     * again. Whichever version lets go of a node last frees it, on
+     * whatever thread that happens, so nodes come from the global
+     * heap rather than a per-tree pool.
+     */
+    template <typename T, class Compare = std::less<T>>
+    class persistent_set {
+    public:
+        typedef T          value_type;
+        typedef size_t     size_type;
+        typedef Compare    key_compare;
+
+        // constructors and destructor; copies share every node.
+        explicit persistent_set(const Compare& c = Compare()): root(nullptr), _size(0), comp(c) {}
+        persistent_set(const persistent_set& s): root(retain(s.root)), _size(s._size), comp(s.comp) {}
+        persistent_set(persistent_set&& s): root(s.root), _size(s._size), comp(s.comp) {
+            s.root = nullptr;
+            s._size = 0;
+        }
+        ~persistent_set() {release(root);}
+
+        // operators.
+        persistent_set& operator=(persistent_set s) {swap(s); return *this;}
+
+        // a version that later updates of this one do not affect; O(1).
+        persistent_set snapshot(void) const {return *this;}
+
+        // operations; insert() and remove() return whether they changed the set.
+        bool insert(const value_type& k);
+        bool remove(const value_type& k);
+        void clear(void) {release(root); root = nullptr; _size = 0;}
+        void swap(persistent_set& s);
+
+        bool contains(const value_type& k) const;
+        template <class F>
+        void for_each(F f) const {for_each_in(root, f);}
+        // f(key) for every key in [lo, hi), in order.
+        template <class F>
+        void for_each_in_range(const value_type& lo, const value_type& hi, F f) const {
+            for_each_in_range(root, lo, hi, f);
+        }
+
+        size_type size(void) const {return _size;}
+        bool empty(void) const {return _size == 0;}
+        size_type height(void) const {return static_cast<size_type>(height(root));}
+
+    private:
+        struct node {
+            mutable std::atomic<size_t>    refs;
+            int                            height;
+            const node                     *left;
+            const node                     *right;
+            value_type                     key;
+
+            node(const value_type &k, const node *l, const node *r)
+            : refs(1), height(1 + std::max(persistent_set::height(l), persistent_set::height(r))),
+              left(l), right(r), key(k) {}
+        };
+
+        /*
+         * Every const node* handed between these functions carries
+         * one reference: the callee takes over the ones it is given
+         * and the caller owns the one returned. An update that finds
+         * nothing to change returns its input subtree unchanged,
+         * which is how callers above tell that nothing changed.
+         */
+        static const node* retain(const node *nd) {
+            if (nd)
+                nd->refs.fetch_add(1, std::memory_order_relaxed);
+            return nd;
+        }
+        static void release(const node *nd);
+        // one reference, released at the end of the scope unless taken.
+        struct holder {
+            const node    *p;
+            explicit holder(const node *nd): p(nd) {}
+            holder(const holder&) = delete;
+            ~holder() {release(p);}
+            const node* take(void) {const node *nd = p; p = nullptr; return nd;}
+        };
+        static int height(const node *nd) {return nd ? nd->height : 0;}
+        static const node* make(const value_type &k, const node *l, const node *r);
+        static const node* balance(const value_type &k, const node *l, const node *r);
+
+        const node* insert(const node *nd, const value_type &k);
+        const node* remove(const node *nd, const value_type &k);
+        static const node* remove_min(const node *nd, const node *&min);
+
+        template <class F>
+        static void for_each_in(const node *nd, F &f);
+        template <class F>
+        void for_each_in_range(const node *nd, const value_type &lo,
+                               const value_type &hi, F &f) const;
+
+    private:
+        const node    *root;
+        size_type     _size;
+        Compare       comp;
+    };
+
+    template <typename T, class Compare>
+    void
+    persistent_set<T, Compare>::swap(persistent_set& s) {
+        std::swap(root, s.root);
+        std::swap(_size, s._size);
+        std::swap(comp, s.comp);
+    }
+
+    /*
+     * The last owner frees the node and lets go of its children;
+     * the recursion is as deep as the tree is tall.
+     */
+    template <typename T, class Compare>
+    void
+    persistent_set<T, Compare>::release(const node *nd) {
+        if (nd == nullptr || nd->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        const node *l = nd->left, *r = nd->right;
+        delete nd;
+        release(l);
+        release(r);
+    }
+
+    template <typename T, class Compare>
+    const typename persistent_set<T, Compare>::node *
+    persistent_set<T, Compare>::make(const value_type &k, const node *l, const node *r) {
+        try {
+            return new node(k, l, r);
+        } catch (...) {
+            release(l);
+            release(r);
+            throw;
+        }
+    }
+
+    /*
+     * A new node for k over l and r, rotated if their heights are
+     * more than one apart. Rotations build new nodes for the ones
+     * they move and share the subtrees below them; the holders give
+     * back whatever is left over, also when a key's copy throws.
+     */
+    template <typename T, class Compare>
+    const typename persistent_set<T, Compare>::node *
+    persistent_set<T, Compare>::balance(const value_type &k, const node *l, const node *r) {
+        holder    hl(l), hr(r);
+
+        if (height(l) > height(r) + 1) {
+            if (height(l->left) >= height(l->right)) {
+                holder b(make(k, retain(l->right), hr.take()));
+                return make(l->key, retain(l->left), b.take());
+            }
+            const node *lr = l->right;
+            holder b(make(k, retain(lr->right), hr.take()));
+            holder a(make(l->key, retain(l->left), retain(lr->left)));
+            return make(lr->key, a.take(), b.take());
+        }
+        if (height(r) > height(l) + 1) {
+            if (height(r->right) >= height(r->left)) {
+                holder a(make(k, hl.take(), retain(r->left)));
+                return make(r->key, a.take(), retain(r->right));
+            }
+            const node *rl = r->left;
+            holder a(make(k, hl.take(), retain(rl->left)));
+            holder b(make(r->key, retain(rl->right), retain(r->right)));
+            return make(rl->key, a.take(), b.take());
+        }
+        return make(k, hl.take(), hr.take());
+    }
+
+    template <typename T, class Compare>
+    const typename persistent_set<T, Compare>::node *
+    persistent_set<T, Compare>::insert(const node *nd, const value_type &k) {
+        if (nd == nullptr)
+            return make(k, nullptr, nullptr);
+
+        if (comp(k, nd->key)) {
+            const node *l = insert(nd->left, k);
+            if (l == nd->left) {
+                release(l);
+                return retain(nd);
+            }
+            return balance(nd->key, l, retain(nd->right));
+        }
+        if (comp(nd->key, k)) {
+            const node *r = insert(nd->right, k);
+            if (r == nd->right) {
+                release(r);
+                return retain(nd);
+            }
+            return balance(nd->key, retain(nd->left), r);
+        }
+        return retain(nd);
+    }
+
+    // takes the smallest node of nd out, handing it back in min.
+    template <typename T, class Compare>
+    const typename persistent_set<T, Compare>::node *
+    persistent_set<T, Compare>::remove_min(const node *nd, const node *&min) {
+        if (nd->left == nullptr) {
+            min = nd;
+            return retain(nd->right);
+        }
+        const node *l = remove_min(nd->left, min);
+        return balance(nd->key, l, retain(nd->right));
+    }
+
+    template <typename T, class Compare>
+    const typename persistent_set<T, Compare>::node *
+    persistent_set<T, Compare>::remove(const node *nd, const value_type &k) {
+        if (nd == nullptr)
+            return nullptr;
+
+        if (comp(k, nd->key)) {
+            const node *l = remove(nd->left, k);
+            if (l == nd->left) {
+                release(l);
+                return retain(nd);
+            }
+            return balance(nd->key, l, retain(nd->right));
+        }
+        if (comp(nd->key, k)) {
+            const node *r = remove(nd->right, k);
+            if (r == nd->right) {
+                release(r);
+                return retain(nd);
+            }
+            return balance(nd->key, retain(nd->left), r);
+        }
+
+        if (nd->left == nullptr)
+            return retain(nd->right);
+        if (nd->right == nullptr)
+            return retain(nd->left);
+        const node *min = nullptr;
+        const node *r = remove_min(nd->right, min);
+        return balance(min->key, retain(nd->left), r);
+    }
+
+    template <typename T, class Compare>
+    bool
+    persistent_set<T, Compare>::insert(const value_type& k) {
+        const node *nd = insert(root, k);
+
+        if (nd == root) {
+            release(nd);
+            return false;
+        }
+        release(root);
+        root = nd;
+        ++_size;
+        return true;
+    }
+
+    template <typename T, class Compare>
+    bool
+    persistent_set<T, Compare>::remove(const value_type& k) {
+        const node *nd = remove(root, k);
+
+        if (nd == root) {
+            release(nd);
+            return false;
+        }
+        release(root);
+        root = nd;
+        --_size;
+        return true;
+    }
+
+    template <typename T, class Compare>
+    bool
+    persistent_set<T, Compare>::contains(const value_type& k) const {
+        const node *nd = root;
+
+        while (nd != nullptr)
+            if (comp(k, nd->key))
+                nd = nd->left;
+            else if (comp(nd->key, k))
+                nd = nd->right;
+            else
+                return true;
+        return false;
+    }
+
+    template <typename T, class Compare>
+    template <class F>
+    void
+    persistent_set<T, Compare>::for_each_in(const node *nd, F &f) {
+        if (nd == nullptr)
+            return;
+        for_each_in(nd->left, f);
+        f(nd->key);
+        for_each_in(nd->right, f);
+    }
+
+    template <typename T, class Compare>
+    template <class F>
+    void
+    persistent_set<T, Compare>::for_each_in_range(const node *nd, const value_type &lo,
+                                                  const value_type &hi, F &f) const {
+        if (nd == nullptr)
+            return;
+        bool above_lo = !comp(nd->key, lo), below_hi = comp(nd->key, hi);
+        if (above_lo)
+            for_each_in_range(nd->left, lo, hi, f);
+        if (above_lo && below_hi)
+            f(nd->key);
+        if (below_hi)
+            for_each_in_range(nd->right, lo, hi, f);
+    }
+}
+
+#endif
@@ -0,0 +1,127 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "persistent_set.hpp"
+
+// counts live keys, so leaks and over-copying both show up.
+struct tracked {
+    static long live;
+    int         v;
+
+    tracked(int x): v(x) {++live;}
+    tracked(const tracked &t): v(t.v) {++live;}
+    ~tracked() {--live;}
+    bool operator<(const tracked &t) const {return v < t.v;}
+};
+long tracked::live = 0;
+
+/*
+ * A snapshot after every update, each checked at the end against
+ * the std::set it should still match.
+ */
+void version_test(void) {
+    {
+        my::persistent_set<tracked> set;
+        std::set<int> ref;
+        std::vector<my::persistent_set<tracked>> versions;
+        std::vector<std::set<int>> refs;
+        std::mt19937 e(1);
+
+        for (int i = 0; i < 3000; ++i) {
+            int k = static_cast<int>(e() % 1000);
+            if (i % 3 == 2)
+                assert(set.remove(k) == (ref.erase(k) == 1));
+            else
+                assert(set.insert(k) == ref.insert(k).second);
+            versions.push_back(set.snapshot());
+            refs.push_back(ref);
+        }
+        for (size_t i = 0; i < versions.size(); ++i) {
+            std::vector<int> got;
+            versions[i].for_each([&got](const tracked &t) {got.push_back(t.v);});
+            assert(versions[i].size() == refs[i].size());
+            assert(std::equal(got.begin(), got.end(), refs[i].begin(), refs[i].end()));
+        }
+        for (int k = -1; k <= 1000; ++k)
+            assert(set.contains(k) == (ref.count(k) == 1));
+
+        std::vector<int> got;
+        set.for_each_in_range(200, 400, [&got](const tracked &t) {got.push_back(t.v);});
+        assert(std::equal(got.begin(), got.end(), ref.lower_bound(200), ref.lower_bound(400)));
+
+        // versions share all but their paths: far fewer keys than 3000 full copies.
+        double bound = 1.45 * std::log2(ref.size() + 2.0);
+        assert(set.height() <= bound);
+        assert(tracked::live < static_cast<long>(ref.size() + 3000 * 3 * bound));
+
+        versions.clear();
+        assert(tracked::live == static_cast<long>(set.size()));
+        my::persistent_set<tracked> other(set);
+        set.clear();
+        assert(tracked::live == static_cast<long>(other.size()));
+    }
+    assert(tracked::live == 0);
+}
+
+/*
+ * A writer publishes a snapshot after every batch of updates;
+ * readers check each one they pick up while the writer goes on.
+ * Every snapshot i holds the keys [0, 100 (i + 1)) minus the
+ * multiples of 7 below 100 i.
+ */
+void thread_test(void) {
+    std::mutex m;
+    my::persistent_set<int> published;
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+
+    for (int r = 0; r < 4; ++r)
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                my::persistent_set<int> s;
+                {
+                    std::lock_guard<std::mutex> l(m);
+                    s = published;
+                }
+                if (s.empty())
+                    continue;
+                int top = 0;
+                s.for_each([&top](int k) {top = std::max(top, k);});
+                int batches = top / 100 + 1;
+                size_t expect = 100 * batches - (100 * (batches - 1) + 6) / 7;
+                assert(s.size() == expect);
+                for (int k = 0; k < 100 * batches; k += 13)
+                    assert(s.contains(k) == (k >= 100 * (batches - 1) || k % 7 != 0));
+            }
+        });
+
+    my::persistent_set<int> set;
+    for (int b = 0; b < 300; ++b) {
+        for (int k = 100 * b; k < 100 * (b + 1); ++k)
+            set.insert(k);
+        if (b > 0)
+            for (int k = 100 * (b - 1); k < 100 * b; ++k)
+                if (k % 7 == 0)
+                    set.remove(k);
+        std::lock_guard<std::mutex> l(m);
+        published = set.snapshot();
+    }
+    done = true;
+    for (auto &t : readers)
+        t.join();
+}
+
+int
+main(void) {
+    version_test();
+    thread_test();
+    std::cout << "persistent_set tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,410 @@
+#ifndef M_SIMD
+#define M_SIMD
+
+#include <cstddef>    // size_t
+#include <cstdint>    // int32_t, int64_t
+#include <cstring>    // memcpy()
+
+#include "vector.hpp"
+
+/*
+ * Vectorized kernels over contiguous float/double arrays: fill,
+ * copy, axpy, sum, min, max and argmax. On x86-64 each kernel has an
+ * AVX2 build, chosen at run time when the CPU supports it, and an
+ * SSE2 build (always available on x86-64); elsewhere plain loops are
+ * used. The kernels are written once with GCC vector extensions and
+ * instantiated for each register width. min, max and argmax expect
+ * n > 0 and no NaNs; sums are accumulated in several lanes, so they
+ * can differ from a left-to-right loop in the last bits.
+ */
+namespace my {
+    namespace simd {
+        namespace detail {
+            typedef double    d2 __attribute__((vector_size(16)));
+            typedef double    d4 __attribute__((vector_size(32)));
+            typedef float     f4 __attribute__((vector_size(16)));
+            typedef float     f8 __attribute__((vector_size(32)));
+
+            /* @struct lanes
+             * Scalar type, lane count and a same-width integer vector
+             * (for argmax indices) of each register type.
+             */
+            template <typename V> struct lanes;
+            template <> struct lanes<d2> {
+                typedef double     scalar;
+                typedef int64_t    index_v __attribute__((vector_size(16)));
+                static const size_t n = 2;
+            };
+            template <> struct lanes<d4> {
+                typedef double     scalar;
+                typedef int64_t    index_v __attribute__((vector_size(32)));
+                static const size_t n = 4;
+            };
+            template <> struct lanes<f4> {
+                typedef float      scalar;
+                typedef int32_t    index_v __attribute__((vector_size(16)));
+                static const size_t n = 4;
+            };
+            template <> struct lanes<f8> {
+                typedef float      scalar;
+                typedef int32_t    index_v __attribute__((vector_size(32)));
+                static const size_t n = 8;
+            };
+
+            /*
+             * The kernels are always inlined into a wrapper whose
+             * target attribute decides which instructions the vector
+             * operations become, so their by-value vector arguments
+             * never cross an ABI boundary and GCC's -Wpsabi note about
+             * them does not apply.
+             */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#define M_SIMD_KERNEL inline __attribute__((always_inline))
+
+            template <typename V>
+            M_SIMD_KERNEL V load(const typename lanes<V>::scalar *p) {
+                V v;
+                std::memcpy(&v, p, sizeof(V));
+                return v;
+            }
+
+            template <typename V>
+            M_SIMD_KERNEL void store(typename lanes<V>::scalar *p, const V &v) {
+                std::memcpy(p, &v, sizeof(V));
+            }
+
+            template <typename V>
+            M_SIMD_KERNEL V splat(typename lanes<V>::scalar x) {
+                V v;
+                for (size_t i = 0; i < lanes<V>::n; ++i)
+                    v[i] = x;
+                return v;
+            }
+
+            template <typename V, typename T>
+            M_SIMD_KERNEL void fill_kernel(T *p, size_t n, T x) {
+                const size_t L = lanes<V>::n;
+                V v = splat<V>(x);
+                size_t i = 0;
+
+                for ( ; i + L <= n; i += L)
+                    store(p + i, v);
+                for ( ; i < n; ++i)
+                    p[i] = x;
+            }
+
+            template <typename V, typename T>
+            M_SIMD_KERNEL void axpy_kernel(T a, const T *x, T *y, size_t n) {
+                const size_t L = lanes<V>::n;
+                V va = splat<V>(a);
+                size_t i = 0;
+
+                for ( ; i + 2 * L <= n; i += 2 * L) {
+                    V y0 = load<V>(y + i) + va * load<V>(x + i);
+                    V y1 = load<V>(y + i + L) + va * load<V>(x + i + L);
+                    store(y + i, y0);
+                    store(y + i + L, y1);
+                }
+                for ( ; i < n; ++i)
+                    y[i] += a * x[i];
+            }
+
+            template <typename V, typename T>
+            M_SIMD_KERNEL T sum_kernel(const T *p, size_t n) {
+                const size_t L = lanes<V>::n;
+                V s0 = splat<V>(0), s1 = s0, s2 = s0, s3 = s0;
+                size_t i = 0;
+
+                // four independent chains hide the add latency.
+                for ( ; i + 4 * L <= n; i += 4 * L) {
+                    s0 += load<V>(p + i);
+                    s1 += load<V>(p + i + L);
+                    s2 += load<V>(p + i + 2 * L);
+                    s3 += load<V>(p + i + 3 * L);
+                }
+                for ( ; i + L <= n; i += L)
+                    s0 += load<V>(p + i);
+                s0 = (s0 + s1) + (s2 + s3);
+
+                T total = 0;
+                for (size_t k = 0; k < L; ++k)
+                    total += s0[k];
+                for ( ; i < n; ++i)
+                    total += p[i];
+                return total;
+            }
+
+            template <typename V, typename T, bool Max>
+            M_SIMD_KERNEL T extreme_kernel(const T *p, size_t n) {
+                const size_t L = lanes<V>::n;
+                size_t i = 0;
+                T best = p[0];
+
+                if (n >= 2 * L) {
+                    V m0 = load<V>(p), m1 = load<V>(p + L);
+                    for (i = 2 * L; i + 2 * L <= n; i += 2 * L) {
+                        V v0 = load<V>(p + i), v1 = load<V>(p + i + L);
+                        m0 = Max ? (v0 > m0 ? v0 : m0) : (v0 < m0 ? v0 : m0);
+                        m1 = Max ? (v1 > m1 ? v1 : m1) : (v1 < m1 ? v1 : m1);
+                    }
+                    m0 = Max ? (m1 > m0 ? m1 : m0) : (m1 < m0 ? m1 : m0);
+                    best = m0[0];
+                    for (size_t k = 1; k < L; ++k)
+                        if (Max ? m0[k] > best : m0[k] < best)
+                            best = m0[k];
+                }
+                for ( ; i < n; ++i)
+                    if (Max ? p[i] > best : p[i] < best)
+                        best = p[i];
+                return best;
+            }
+
+            /*
+             * Each lane keeps its largest value and where it was seen,
+             * in four independent pairs of registers so that the
+             * compare and blend latencies overlap; pair j holds the
+             * base of the block and adds j * L at the end. Strict
+             * comparisons keep the first position, and ties between
+             * lanes go to the smaller index.
+             */
+            template <typename V, typename T>
+            M_SIMD_KERNEL size_t argmax_kernel(const T *p, size_t n) {
+                typedef typename lanes<V>::index_v    I;
+                const size_t L = lanes<V>::n;
+                size_t i = 0, best_i = 0;
+                T best = p[0];
+
+                if (n >= 4 * L) {
+                    V b0 = load<V>(p), b1 = load<V>(p + L);
+                    V b2 = load<V>(p + 2 * L), b3 = load<V>(p + 3 * L);
+                    I idx, step;
+                    for (size_t k = 0; k < L; ++k) {
+                        idx[k] = k;
+                        step[k] = 4 * L;
+                    }
+                    I i0 = idx, i1 = idx, i2 = idx, i3 = idx;
+                    for (i = 4 * L; i + 4 * L <= n; i += 4 * L) {
+                        V v0 = load<V>(p + i), v1 = load<V>(p + i + L);
+                        V v2 = load<V>(p + i + 2 * L), v3 = load<V>(p + i + 3 * L);
+                        idx += step;
+                        I g0 = v0 > b0, g1 = v1 > b1, g2 = v2 > b2, g3 = v3 > b3;
+                        i0 = g0 ? idx : i0;
+                        i1 = g1 ? idx : i1;
+                        i2 = g2 ? idx : i2;
+                        i3 = g3 ? idx : i3;
+                        b0 = v0 > b0 ? v0 : b0;
+                        b1 = v1 > b1 ? v1 : b1;
+                        b2 = v2 > b2 ? v2 : b2;
+                        b3 = v3 > b3 ? v3 : b3;
+                    }
+                    const V bv[4] = { b0, b1, b2, b3 };
+                    const I bi[4] = { i0, i1, i2, i3 };
+                    best = b0[0];
+                    best_i = i0[0];
+                    for (size_t j = 0; j < 4; ++j)
+                        for (size_t k = 0; k < L; ++k) {
+                            size_t at = bi[j][k] + j * L;
+                            if (bv[j][k] > best || (bv[j][k] == best && at < best_i)) {
+                                best = bv[j][k];
+                                best_i = at;
+                            }
+                        }
+                }
+                for ( ; i < n; ++i)
+                    if (p[i] > best) {
+                        best = p[i];
+                        best_i = i;
+                    }
+                return best_i;
+            }
+
+#undef M_SIMD_KERNEL
+#pragma GCC diagnostic pop
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define M_SIMD_X86 1
+            inline bool has_avx2(void) {
+                static const bool avx2 = __builtin_cpu_supports("avx2");
+                return avx2;
+            }
+
+#define M_SIMD_AVX2 __attribute__((target("avx2")))
+            /*
+             * One entry point per instruction set; the SSE2 ones are
+             * compiled for the x86-64 baseline.
+             */
+            template <typename T> struct regs;
+            template <> struct regs<double> { typedef d2 sse; typedef d4 avx; };
+            template <> struct regs<float> { typedef f4 sse; typedef f8 avx; };
+
+            template <typename T> M_SIMD_AVX2 void fill_avx2(T *p, size_t n, T x)
+            { fill_kernel<typename regs<T>::avx>(p, n, x); }
+            template <typename T> void fill_sse2(T *p, size_t n, T x)
+            { fill_kernel<typename regs<T>::sse>(p, n, x); }
+
+            template <typename T> M_SIMD_AVX2 void axpy_avx2(T a, const T *x, T *y, size_t n)
+            { axpy_kernel<typename regs<T>::avx>(a, x, y, n); }
+            template <typename T> void axpy_sse2(T a, const T *x, T *y, size_t n)
+            { axpy_kernel<typename regs<T>::sse>(a, x, y, n); }
+
+            template <typename T> M_SIMD_AVX2 T sum_avx2(const T *p, size_t n)
+            { return sum_kernel<typename regs<T>::avx>(p, n); }
+            template <typename T> T sum_sse2(const T *p, size_t n)
+            { return sum_kernel<typename regs<T>::sse>(p, n); }
+
+            template <typename T, bool Max> M_SIMD_AVX2 T extreme_avx2(const T *p, size_t n)
+            { return extreme_kernel<typename regs<T>::avx, T, Max>(p, n); }
+            template <typename T, bool Max> T extreme_sse2(const T *p, size_t n)
+            { return extreme_kernel<typename regs<T>::sse, T, Max>(p, n); }
+
+            template <typename T> M_SIMD_AVX2 size_t argmax_avx2(const T *p, size_t n)
+            { return argmax_kernel<typename regs<T>::avx>(p, n); }
+            template <typename T> size_t argmax_sse2(const T *p, size_t n)
+            { return argmax_kernel<typename regs<T>::sse>(p, n); }
+#undef M_SIMD_AVX2
+#endif
+
+            /*
+             * Portable fallbacks, also the reference the kernels are
+             * checked against.
+             */
+            template <typename T>
+            T sum_scalar(const T *p, size_t n) {
+                T total = 0;
+                for (size_t i = 0; i < n; ++i)
+                    total += p[i];
+                return total;
+            }
+
+            template <typename T, bool Max>
+            T extreme_scalar(const T *p, size_t n) {
+                T best = p[0];
+                for (size_t i = 1; i < n; ++i)
+                    if (Max ? p[i] > best : p[i] < best)
+                        best = p[i];
+                return best;
+            }
+
+            template <typename T>
+            size_t argmax_scalar(const T *p, size_t n) {
+                size_t best = 0;
+                for (size_t i = 1; i < n; ++i)
+                    if (p[i] > p[best])
+                        best = i;
+                return best;
+            }
+        }
+
+        /* @fn fill()
+         * Set p[0..n) to x.
+         */
+        template <typename T>
+        void fill(T *p, size_t n, T x) {
+#ifdef M_SIMD_X86
+            if (detail::has_avx2())
+                return detail::fill_avx2(p, n, x);
+            return detail::fill_sse2(p, n, x);
+#else
+            for (size_t i = 0; i < n; ++i)
+                p[i] = x;
+#endif
+        }
+
+        /* @fn copy()
+         * Copy src[0..n) to dst; the ranges must not overlap. The C
+         * library's memcpy is already dispatched per CPU, so this is
+         * a plain call.
+         */
+        template <typename T>
+        void copy(T *dst, const T *src, size_t n) {
+            std::memcpy(dst, src, n * sizeof(T));
+        }
+
+        /* @fn axpy()
+         * y[i] += a * x[i] for i in [0, n).
+         */
+        template <typename T>
+        void axpy(T a, const T *x, T *y, size_t n) {
+#ifdef M_SIMD_X86
+            if (detail::has_avx2())
+                return detail::axpy_avx2(a, x, y, n);
+            return detail::axpy_sse2(a, x, y, n);
+#else
+            for (size_t i = 0; i < n; ++i)
+                y[i] += a * x[i];
+#endif
+        }
+
+        template <typename T>
+        T sum(const T *p, size_t n) {
+#ifdef M_SIMD_X86
+            if (detail::has_avx2())
+                return detail::sum_avx2(p, n);
+            return detail::sum_sse2(p, n);
+#else
+            return detail::sum_scalar(p, n);
+#endif
+        }
+
+        template <typename T>
+        T min(const T *p, size_t n) {
+#ifdef M_SIMD_X86
+            if (detail::has_avx2())
+                return detail::extreme_avx2<T, false>(p, n);
+            return detail::extreme_sse2<T, false>(p, n);
+#else
+            return detail::extreme_scalar<T, false>(p, n);
+#endif
+        }
+
+        template <typename T>
+        T max(const T *p, size_t n) {
+#ifdef M_SIMD_X86
+            if (detail::has_avx2())
+                return detail::extreme_avx2<T, true>(p, n);
+            return detail::extreme_sse2<T, true>(p, n);
+#else
+            return detail::extreme_scalar<T, true>(p, n);
+#endif
+        }
+
+        /* @fn argmax()
+         * Index of the first largest element.
+         */
+        template <typename T>
+        size_t argmax(const T *p, size_t n) {
+#ifdef M_SIMD_X86
+            if (detail::has_avx2())
+                return detail::argmax_avx2(p, n);
+            return detail::argmax_sse2(p, n);
+#else
+            return detail::argmax_scalar(p, n);
+#endif
+        }
+
+        // the same kernels over a whole my::vector.
+        template <typename T, class A, class G>
+        void fill(vector<T, A, G> &v, T x) { fill(v.begin(), v.size(), x); }
+        template <typename T, class A, class G>
+        void copy(vector<T, A, G> &dst, const vector<T, A, G> &src) {
+            copy(dst.begin(), src.begin(), src.size() < dst.size() ? src.size() : dst.size());
+        }
+        template <typename T, class A, class G>
+        void axpy(T a, const vector<T, A, G> &x, vector<T, A, G> &y) {
+            axpy(a, x.begin(), y.begin(), x.size() < y.size() ? x.size() : y.size());
+        }
+        template <typename T, class A, class G>
+        T sum(const vector<T, A, G> &v) { return sum(v.begin(), v.size()); }
+        template <typename T, class A, class G>
+        T min(const vector<T, A, G> &v) { return min(v.begin(), v.size()); }
+        template <typename T, class A, class G>
+        T max(const vector<T, A, G> &v) { return max(v.begin(), v.size()); }
+        template <typename T, class A, class G>
+        size_t argmax(const vector<T, A, G> &v) { return argmax(v.begin(), v.size()); }
+    }
+}
+
+#undef M_SIMD_X86
+
+#endif
@@ -0,0 +1,498 @@
+#ifndef M_SMALL_VECTOR
+#define M_SMALL_VECTOR
+
+#include <initializer_list>
+#include <utility>    // move()
+#include <new>        // operator new(), placement new
+#include <memory>     // uninitialized_copy(), uninitialized_fill()
+#include <iterator>   // make_move_iterator(), distance()
+#include <algorithm>  // move(), copy(), max()
+#include <type_traits>
+
+#include "vector.hpp"
+
+namespace my {
+    /*
+     * A vector that keeps up to N elements in storage embedded in
+     * the object itself and only goes to the heap once it outgrows
+     * them. The interface mirrors my::vector, so a container can be
+     * switched from one to the other by changing a type alias.
+     */
+    template <typename T, size_t N>
+    class small_vector {
+        static_assert(N > 0, "small_vector needs at least one inline slot");
+    public:
+        typedef size_t     size_type;
+        typedef T          value_type;
+        typedef T*         iterator;
+        typedef const T*   const_iterator;
+
+        // constructors and destructor.
+        small_vector();
+        small_vector(size_type size);
+        small_vector(size_type size, const value_type &val);
+        template <class Itr, typename = typename detail::enable_if_iterator<Itr>::type>
+        small_vector(Itr begin, Itr end);
+        small_vector(const small_vector &vec);
+        small_vector(std::initializer_list<T> il);
+        small_vector(small_vector &&vec);
+
+        ~small_vector() { detail::destroy(b, b + s); deallocate(); }
+
+        // assginments.
+        small_vector& operator=(const small_vector &vec);
+        small_vector& operator=(small_vector &&vec);
+        small_vector& operator=(std::initializer_list<T> il);
+
+        // iterator.
+        iterator begin() { return b; }
+        const_iterator begin() const { return b; }
+        iterator end() { return b + s; }
+        const_iterator end() const { return b + s; }
+
+        const_iterator cbegin() const { return b; }
+        const_iterator bend() const { return b + s; }
+
+        // size.
+        size_type size(void) const { return s; }
+        void resize(size_type n);
+        void resize(size_type n, const value_type &val);
+        size_type capacity(void) const { return cap; }
+        bool empty(void) const { return s == 0; }
+        void reserve(size_type n);
+        // back into the inline buffer if the elements fit, else a heap buffer of size().
+        void shrink_to_fit(void);
+        // whether the elements still live in the inline buffer.
+        bool is_inline(void) const { return b == inline_begin(); }
+
+        // access.
+        T& operator[](size_type n) { return b[n]; }
+        const T& operator[](size_type n) const { return b[n]; }
+        T& front(void) { return b[0]; }
+        const T& front(void) const { return b[0]; }
+        T& back(void) {return b[s - 1]; }
+        const T& back(void) const { return b[s - 1]; }
+
+        // modifiers.
+        void push_back(const value_type &val);
+        void push_back(value_type &&val);
+        void pop_back(void) { b[--s].~T(); }
+        template <class... Args> T& emplace_back(Args&&... args);
+        template <class... Args> iterator emplace(const_iterator pos, Args&&... args);
+        iterator insert(const_iterator pos, const value_type &val);
+        iterator insert(const_iterator pos, size_type n, const value_type &val);
+        template <class Iter, typename = typename detail::enable_if_iterator<Iter>::type>
+        iterator insert(const_iterator pos, Iter pb, Iter pe);
+        iterator insert(const_iterator pos, value_type &&val);
+        iterator insert(const_iterator pos, std::initializer_list<value_type> il);
+        iterator erase(const_iterator pos);
+        iterator erase(const_iterator pb, const_iterator pe);
+
+        // range operations, as in my::vector.
+        template <class Iter, typename = typename detail::enable_if_iterator<Iter>::type>
+        void append(Iter first, Iter last) { insert(end(), first, last); }
+        template <class Iter, typename = typename detail::enable_if_iterator<Iter>::type>
+        void assign(Iter first, Iter last);
+
+        void clear() { detail::destroy(b, b + s); s = 0; }
+
+    private:
+        T* inline_begin(void) { return reinterpret_cast<T*>(&buf); }
+        const T* inline_begin(void) const { return reinterpret_cast<const T*>(&buf); }
+        static T* allocate(size_type n) { return static_cast<T*>(::operator new(n * sizeof(T))); }
+        void deallocate(void);
+        void reallocate(size_type n);
+        template <class... Args>
+        void grow_emplace(size_type idx, Args&&... args);
+        template <class Iter>
+        void insert_range(size_type idx, Iter first, Iter last, std::input_iterator_tag);
+        template <class Iter>
+        void insert_range(size_type idx, Iter first, Iter last, std::forward_iterator_tag);
+        template <class Iter>
+        void assign_range(Iter first, Iter last, std::input_iterator_tag);
+        template <class Iter>
+        void assign_range(Iter first, Iter last, std::forward_iterator_tag);
+
+    private:
+        T                         *b;
+        size_type                 s;
+        size_type                 cap;
+        typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type buf;
+    };
+
+    template <typename T, size_t N>
+    void
+    small_vector<T, N>::deallocate(void) {
+        if (!is_inline())
+            ::operator delete(b);
+    }
+
+    /*
+     * Move the live elements into a heap buffer of n slots. Only
+     * shrink_to_fit() moves them back into the inline buffer; growing
+     * never does.
+     */
+    template <typename T, size_t N>
+    void
+    small_vector<T, N>::reallocate(size_type n) {
+        T *temp = allocate(n);
+
+        try {
+            detail::relocate(b, b + s, temp);
+        } catch (...) {
+            ::operator delete(temp);
+            throw;
+        }
+        deallocate();
+        b = temp;
+        cap = n;
+    }
+
+    template <typename T, size_t N>
+    small_vector<T, N>::small_vector()
+    : b(inline_begin()), s(0), cap(N) {}
+
+    template <typename T, size_t N>
+    small_vector<T, N>::small_vector(size_type size)
+    : b(inline_begin()), s(0), cap(N) {
+        reserve(size);
+        for ( ; s < size; ++s)
+            ::new (static_cast<void*>(b + s)) T();
+    }
+
+    template <typename T, size_t N>
+    small_vector<T, N>::small_vector(size_type size, const value_type &val)
+    : b(inline_begin()), s(0), cap(N) {
+        reserve(size);
+        std::uninitialized_fill_n(b, size, val);
+        s = size;
+    }
+
+    template <typename T, size_t N>
+    template <class Itr, typename>
+    small_vector<T, N>::small_vector(Itr begin, Itr end)
+    : b(inline_begin()), s(0), cap(N) {
+        append(begin, end);
+    }
+
+    template <typename T, size_t N>
+    small_vector<T, N>::small_vector(const small_vector &vec)
+    : b(inline_begin()), s(0), cap(N) {
+        reserve(vec.s);
+        std::uninitialized_copy(vec.b, vec.b + vec.s, b);
+        s = vec.s;
+    }
+
+    template <typename T, size_t N>
+    small_vector<T, N>::small_vector(std::initializer_list<T> il)
+    : b(inline_begin()), s(0), cap(N) {
+        reserve(il.size());
+        std::uninitialized_copy(il.begin(), il.end(), b);
+        s = il.size();
+    }
+
+    /*
+     * A heap buffer can be stolen; inline elements have to be
+     * moved one by one since they live inside vec.
+     */
+    template <typename T, size_t N>
+    small_vector<T, N>::small_vector(small_vector &&vec)
+    : b(inline_begin()), s(0), cap(N) {
+        if (vec.is_inline()) {
+            detail::relocate(vec.b, vec.b + vec.s, b);
+            s = vec.s;
+        } else {
+            b = vec.b; s = vec.s; cap = vec.cap;
+            vec.b = vec.inline_begin(); vec.cap = N;
+        }
+        vec.s = 0;
+    }
+
+    template <typename T, size_t N>
+    small_vector<T, N> &
+    small_vector<T, N>::operator=(const small_vector &vec) {
+        if (this != &vec)
+            assign(vec.b, vec.b + vec.s);
+
+        return *this;
+    }
+
+    template <typename T, size_t N>
+    small_vector<T, N> &
+    small_vector<T, N>::operator=(small_vector &&vec) {
+        if (this == &vec)
+            return *this;
+
+        clear();
+        if (vec.is_inline()) {
+            reserve(vec.s);
+            detail::relocate(vec.b, vec.b + vec.s, b);
+            s = vec.s;
+        } else {
+            deallocate();
+            b = vec.b; s = vec.s; cap = vec.cap;
+            vec.b = vec.inline_begin(); vec.cap = N;
+        }
+        vec.s = 0;
+
+        return *this;
+    }
+
+    template <typename T, size_t N>
+    small_vector<T, N> &
+    small_vector<T, N>::operator=(std::initializer_list<T> il) {
+        assign(il.begin(), il.end());
+
+        return *this;
+    }
+
+    template <typename T, size_t N>
+    void
+    small_vector<T, N>::resize(size_type n) {
+        reserve(n);
+        for ( ; s < n; ++s)
+            ::new (static_cast<void*>(b + s)) T();
+        detail::destroy(b + n, b + s);
+        s = n;
+    }
+
+    template <typename T, size_t N>
+    void
+    small_vector<T, N>::resize(size_type n, const value_type &val) {
+        if (cap < n) {
+            value_type tmp(val);
+            reserve(std::max(n, 2 * cap));
+            std::uninitialized_fill(b + s, b + n, tmp);
+        } else if (s < n) {
+            std::uninitialized_fill(b + s, b + n, val);
+        } else {
+            detail::destroy(b + n, b + s);
+        }
+        s = n;
+    }
+
+    template <typename T, size_t N>
+    void
+    small_vector<T, N>::reserve(size_type n) {
+        if (cap < n)
+            reallocate(n);
+    }
+
+    template <typename T, size_t N>
+    void
+    small_vector<T, N>::shrink_to_fit(void) {
+        if (is_inline() || cap == s)
+            return;
+        if (s > N)
+            return reallocate(s);
+        T *heap = b;
+        detail::relocate(heap, heap + s, inline_begin());
+        ::operator delete(heap);
+        b = inline_begin();
+        cap = N;
+    }
+
+    template <typename T, size_t N>
+    void
+    small_vector<T, N>::push_back(const value_type &val) {
+        emplace_back(val);
+    }
+
+    template <typename T, size_t N>
+    void
+    small_vector<T, N>::push_back(value_type &&val) {
+        emplace_back(std::move(val));
+    }
+
+    template <typename T, size_t N>
+    template <class... Args>
+    void
+    small_vector<T, N>::grow_emplace(size_type idx, Args&&... args) {
+        T *temp = allocate(2 * cap);
+
+        try {
+            ::new (static_cast<void*>(temp + idx)) T(std::forward<Args>(args)...);
+            detail::relocate_around(b, b + idx, b + s, temp, 1);
+        } catch (...) {
+            ::operator delete(temp);
+            throw;
+        }
+        deallocate();
+        b = temp;
+        cap = 2 * cap;
+    }
+
+    template <typename T, size_t N>
+    template <class... Args>
+    T&
+    small_vector<T, N>::emplace_back(Args&&... args) {
+        if (cap < s + 1)
+            grow_emplace(s, std::forward<Args>(args)...);
+        else
+            ::new (static_cast<void*>(b + s)) T(std::forward<Args>(args)...);
+        return b[s++];
+    }
+
+    template <typename T, size_t N>
+    template <class... Args>
+    typename small_vector<T, N>::iterator
+    small_vector<T, N>::emplace(const_iterator pos, Args&&... args) {
+        size_type idx = pos - b;
+
+        if (cap < s + 1) {
+            grow_emplace(idx, std::forward<Args>(args)...);
+        } else if (idx == s) {
+            ::new (static_cast<void*>(b + s)) T(std::forward<Args>(args)...);
+        } else {
+            value_type tmp(std::forward<Args>(args)...);
+            detail::insert_at(b + idx, b + s, std::move(tmp));
+        }
+        ++s;
+
+        return b + idx;
+    }
+
+    template <typename T, size_t N>
+    typename small_vector<T, N>::iterator
+    small_vector<T, N>::insert(const_iterator pos, const value_type &val) {
+        return emplace(pos, val);
+    }
+
+    template <typename T, size_t N>
+    typename small_vector<T, N>::iterator
+    small_vector<T, N>::insert(const_iterator pos, value_type &&val) {
+        size_type idx = pos - b;
+
+        if (cap < s + 1 || idx == s)
+            return emplace(pos, std::move(val));
+        detail::insert_at(b + idx, b + s, std::move(val));
+        ++s;
+
+        return b + idx;
+    }
+
+    template <typename T, size_t N>
+    typename small_vector<T, N>::iterator
+    small_vector<T, N>::insert(const_iterator pos, size_type n, const value_type &val) {
+        size_type idx = pos - b;
+        value_type tmp(val);
+
+        insert_range(idx, detail::repeat_iterator<T>(&tmp, 0),
+                     detail::repeat_iterator<T>(&tmp, n),
+                     std::forward_iterator_tag());
+        return b + idx;
+    }
+
+    template <typename T, size_t N>
+    template <class Iter, typename>
+    typename small_vector<T, N>::iterator
+    small_vector<T, N>::insert(const_iterator pos, Iter pb, Iter pe) {
+        size_type idx = pos - b;
+
+        insert_range(idx, pb, pe, typename detail::iterator_category<Iter>::type());
+        return b + idx;
+    }
+
+    template <typename T, size_t N>
+    template <class Iter>
+    void
+    small_vector<T, N>::insert_range(size_type idx, Iter first, Iter last, std::input_iterator_tag) {
+        if (idx == s) {
+            for ( ; first != last; ++first)
+                push_back(*first);
+            return;
+        }
+
+        vector<T> buffer(first, last);
+        insert_range(idx, std::make_move_iterator(buffer.begin()),
+                     std::make_move_iterator(buffer.end()),
+                     std::forward_iterator_tag());
+    }
+
+    template <typename T, size_t N>
+    template <class Iter>
+    void
+    small_vector<T, N>::insert_range(size_type idx, Iter first, Iter last, std::forward_iterator_tag) {
+        size_type n = std::distance(first, last);
+
+        if (n == 0)
+            return;
+        if (cap < s + n) {
+            size_type n_cap = std::max(2 * cap, s + n);
+            T *temp = allocate(n_cap);
+
+            try {
+                detail::relocate_with_gap(b, b + idx, b + s, temp, first, last, n);
+            } catch (...) {
+                ::operator delete(temp);
+                throw;
+            }
+            deallocate();
+            b = temp;
+            cap = n_cap;
+        } else {
+            detail::insert_range(b + idx, b + s, first, last, n);
+        }
+        s += n;
+    }
+
+    template <typename T, size_t N>
+    template <class Iter, typename>
+    void
+    small_vector<T, N>::assign(Iter first, Iter last) {
+        assign_range(first, last, typename detail::iterator_category<Iter>::type());
+    }
+
+    template <typename T, size_t N>
+    template <class Iter>
+    void
+    small_vector<T, N>::assign_range(Iter first, Iter last, std::input_iterator_tag) {
+        clear();
+        for ( ; first != last; ++first)
+            push_back(*first);
+    }
+
+    template <typename T, size_t N>
+    template <class Iter>
+    void
+    small_vector<T, N>::assign_range(Iter first, Iter last, std::forward_iterator_tag) {
+        size_type n = std::distance(first, last);
+
+        if (cap < n) {
+            clear();
+            reserve(n);
+            std::uninitialized_copy(first, last, b);
+        } else if (s < n) {
+            Iter mid = first;
+            std::advance(mid, s);
+            std::copy(first, mid, b);
+            std::uninitialized_copy(mid, last, b + s);
+        } else {
+            detail::destroy(std::copy(first, last, b), b + s);
+        }
+        s = n;
+    }
+
+    template <typename T, size_t N>
+    typename small_vector<T, N>::iterator
+    small_vector<T, N>::insert(const_iterator pos, std::initializer_list<T> il) {
+        return insert(pos, il.begin(), il.end());
+    }
+
+    template <typename T, size_t N>
+    typename small_vector<T, N>::iterator
+    small_vector<T, N>::erase(const_iterator pos) {
+        return erase(pos, pos + 1);
+    }
+
+    template <typename T, size_t N>
+    typename small_vector<T, N>::iterator
+    small_vector<T, N>::erase(const_iterator pb, const_iterator pe) {
+        iterator first = b + (pb - b), last = b + (pe - b);
+
+        s = detail::erase_range(first, last, b + s) - b;
+        return first;
+    }
+}
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * Compare my::small_vector<int, N> against my::vector<int> on
+ * short sequences: heap allocations are counted through the
+ * global operator new (small_vector) and a counting allocator
+ * (my::vector), time is measured with steady_clock.
+ *
+ * build: g++ -std=c++14 -O2 small_vector_bench.cpp -o small_vector_bench
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <new>
+
+#include "vector.hpp"
+#include "small_vector.hpp"
+
+static size_t allocations = 0;
+
+void* operator new(size_t n) {
+    ++allocations;
+    if (void *p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+template <typename T>
+struct counting_allocator: my::allocator<T> {
+    T* allocate(size_t n) { ++allocations; return my::allocator<T>::allocate(n); }
+    T* reallocate(T *p, size_t old_n, size_t n) {
+        ++allocations;
+        return my::allocator<T>::reallocate(p, old_n, n);
+    }
+};
+
+typedef my::vector<int, counting_allocator<int>>    int_vector;
+
+typedef std::chrono::steady_clock    clock_type;
+
+struct result {
+    double    ns;
+    size_t    allocs;
+    long      check;
+};
+
+/* @fn temporaries()
+ * Build and drop many short vectors, as a neighbor list or a
+ * crossover buffer would be.
+ */
+template <class Vec>
+result temporaries(size_t rounds, size_t len) {
+    result    r = {0.0, 0, 0};
+    size_t    before = allocations;
+    auto      start = clock_type::now();
+
+    for (size_t i = 0; i < rounds; ++i) {
+        Vec vec;
+        for (size_t j = 0; j < len; ++j)
+            vec.push_back(static_cast<int>(i + j));
+        for (auto &v : vec)
+            r.check += v;
+    }
+
+    r.ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / rounds;
+    r.allocs = allocations - before;
+    return r;
+}
+
+/* @fn traversal()
+ * Keep many short vectors alive in one array and sum them in
+ * random order; inline elements sit next to their owner.
+ */
+template <class Vec>
+result traversal(size_t count, size_t len) {
+    result                r = {0.0, 0, 0};
+    my::vector<Vec>       all;
+    my::vector<size_t>    order;
+    std::mt19937          e(42);
+
+    for (size_t i = 0; i < count; ++i) {
+        all.push_back(Vec());
+        for (size_t j = 0; j < len; ++j)
+            all.back().push_back(static_cast<int>(i ^ j));
+        order.push_back(i);
+    }
+    for (size_t i = count - 1; i > 0; --i)
+        std::swap(order[i], order[std::uniform_int_distribution<size_t>(0, i)(e)]);
+
+    size_t    before = allocations;
+    auto      start = clock_type::now();
+    for (size_t i = 0; i < count; ++i)
+        for (auto &v : all[order[i]])
+            r.check += v;
+    r.ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / count;
+    r.allocs = allocations - before;
+    return r;
+}
+
+void print(const char *test, const char *type, size_t len, const result& r) {
+    std::cout << std::setw(12) << test << std::setw(22) << type
+              << std::setw(6) << len << std::setw(12) << std::fixed
+              << std::setprecision(1) << r.ns << std::setw(12) << r.allocs
+              << "   (" << r.check << ")" << std::endl;
+}
+
+template <size_t N>
+void run(size_t rounds, size_t count) {
+    std::string name = "small_vector<int," + std::to_string(N) + ">";
+
+    print("temporaries", "vector<int>", N, temporaries<int_vector>(rounds, N));
+    print("temporaries", name.c_str(), N, temporaries<my::small_vector<int, N>>(rounds, N));
+    print("traversal", "vector<int>", N, traversal<int_vector>(count, N));
+    print("traversal", name.c_str(), N, traversal<my::small_vector<int, N>>(count, N));
+}
+
+int
+main(void) {
+    const size_t rounds = 1000000, count = 1000000;
+
+    std::cout << std::setw(12) << "test" << std::setw(22) << "type"
+              << std::setw(6) << "len" << std::setw(12) << "ns/vector"
+              << std::setw(12) << "allocs" << std::endl;
+    run<2>(rounds, count);
+    run<4>(rounds, count);
+    run<8>(rounds, count);
+    run<16>(rounds, count);
+
+    return 0;
+}
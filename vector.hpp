@@ -3,27 +3,362 @@
 
 #include <iostream>
 #include <initializer_list>
-#include <utility>    // move()
+#include <utility>    // move(), move_if_noexcept()
+#include <new>        // operator new(), placement new
+#include <memory>     // uninitialized_copy(), uninitialized_fill_n()
+#include <iterator>   // make_move_iterator(), iterator_traits
+#include <algorithm>  // move(), move_backward(), copy(), max()
+#include <type_traits>
+#include <cstdlib>    // malloc(), realloc(), free()
+#include <cstring>    // memcpy(), memmove()
+
+#include "allocator.hpp"
 
 namespace my {
+    /* @struct is_trivially_relocatable
+     * Whether moving a T to a new address and dropping the old
+     * object can be done by copying its bytes. This holds for every
+     * trivially copyable type; specialize it to true_type for a user
+     * type that owns resources but keeps no pointers into itself,
+     * e.g.
+     *     template <> struct my::is_trivially_relocatable<buffer>
+     *     : std::true_type {};
+     */
     template <typename T>
+    struct is_trivially_relocatable
+    : std::integral_constant<bool, std::is_trivially_copyable<T>::value> {};
+
+    namespace detail {
+        /*
+         * Element management shared by the containers in this
+         * directory. All of them keep a buffer whose first s slots
+         * hold constructed objects and whose remaining slots are
+         * raw memory. Each helper has a byte-wise overload picked at
+         * compile time for trivially relocatable types.
+         */
+        template <typename T>
+        struct relocatable_tag
+        : std::integral_constant<bool, is_trivially_relocatable<T>::value> {};
+
+        template <typename T>
+        void
+        destroy(T *first, T *last) {
+            if (!std::is_trivially_destructible<T>::value)
+                for ( ; first != last; ++first)
+                    first->~T();
+        }
+
+        /*
+         * Move [first, last) into the raw memory at dest and destroy
+         * the sources. Elements are moved only when the move
+         * constructor cannot throw (or when T cannot be copied at
+         * all); otherwise they are copied, so that a throwing
+         * constructor leaves the source range untouched.
+         */
+        template <typename T>
+        T*
+        uninitialized_move_if_noexcept(T *first, T *last, T *dest) {
+            typedef typename std::conditional<
+                        std::is_nothrow_move_constructible<T>::value ||
+                        !std::is_copy_constructible<T>::value,
+                        std::move_iterator<T*>, T*>::type iter;
+
+            return std::uninitialized_copy(iter(first), iter(last), dest);
+        }
+
+        template <typename T>
+        void
+        relocate(T *first, T *last, T *dest, std::false_type) {
+            uninitialized_move_if_noexcept(first, last, dest);
+            destroy(first, last);
+        }
+
+        template <typename T>
+        void
+        relocate(T *first, T *last, T *dest, std::true_type) {
+            if (first != last)
+                std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first),
+                            (last - first) * sizeof(T));
+        }
+
+        template <typename T>
+        void
+        relocate(T *first, T *last, T *dest) {
+            relocate(first, last, dest, relocatable_tag<T>());
+        }
+
+        /*
+         * Build an element from val at pos, shifting [pos, end) one
+         * slot to the right first; the slot at end must be raw
+         * memory. If the construction throws, the range is left as
+         * it was.
+         */
+        template <typename T>
+        void
+        insert_at(T *pos, T *end, T &&val, std::false_type) {
+            if (pos == end) {
+                ::new (static_cast<void*>(end)) T(std::move(val));
+                return;
+            }
+            ::new (static_cast<void*>(end)) T(std::move(*(end - 1)));
+            std::move_backward(pos, end - 1, end);
+            *pos = std::move(val);
+        }
+
+        template <typename T>
+        void
+        insert_at(T *pos, T *end, T &&val, std::true_type) {
+            std::memmove(static_cast<void*>(pos + 1), static_cast<const void*>(pos),
+                         (end - pos) * sizeof(T));
+            try {
+                ::new (static_cast<void*>(pos)) T(std::move(val));
+            } catch (...) {
+                std::memmove(static_cast<void*>(pos), static_cast<const void*>(pos + 1),
+                             (end - pos) * sizeof(T));
+                throw;
+            }
+        }
+
+        template <typename T>
+        void
+        insert_at(T *pos, T *end, T &&val) {
+            insert_at(pos, end, std::move(val), relocatable_tag<T>());
+        }
+
+        /*
+         * Remove [first, last) from the live range [first, end) and
+         * return the new end.
+         */
+        template <typename T>
+        T*
+        erase_range(T *first, T *last, T *end, std::false_type) {
+            T *new_end = std::move(last, end, first);
+            destroy(new_end, end);
+            return new_end;
+        }
+
+        template <typename T>
+        T*
+        erase_range(T *first, T *last, T *end, std::true_type) {
+            destroy(first, last);
+            std::memmove(static_cast<void*>(first), static_cast<const void*>(last),
+                         (end - last) * sizeof(T));
+            return first + (end - last);
+        }
+
+        template <typename T>
+        T*
+        erase_range(T *first, T *last, T *end) {
+            if (first == last)
+                return end;
+            return erase_range(first, last, end, relocatable_tag<T>());
+        }
+
+        /*
+         * Build the n elements of [first, last) at pos, shifting
+         * [pos, end) n slots to the right; the n slots past end must
+         * be raw memory. The tail is shifted once, whatever n is.
+         */
+        template <typename T, class Iter>
+        void
+        insert_range(T *pos, T *end, Iter first, Iter last, size_t n, std::false_type) {
+            size_t after = end - pos;
+
+            if (after > n) {
+                uninitialized_move_if_noexcept(end - n, end, end);
+                std::move_backward(pos, end - n, end);
+                std::copy(first, last, pos);
+            } else {
+                Iter mid = first;
+                std::advance(mid, after);
+                T *p = std::uninitialized_copy(mid, last, end);
+                try {
+                    uninitialized_move_if_noexcept(pos, end, p);
+                } catch (...) {
+                    destroy(end, p);
+                    throw;
+                }
+                std::copy(first, mid, pos);
+            }
+        }
+
+        template <typename T, class Iter>
+        void
+        insert_range(T *pos, T *end, Iter first, Iter last, size_t n, std::true_type) {
+            std::memmove(static_cast<void*>(pos + n), static_cast<const void*>(pos),
+                         (end - pos) * sizeof(T));
+            try {
+                std::uninitialized_copy(first, last, pos);
+            } catch (...) {
+                std::memmove(static_cast<void*>(pos), static_cast<const void*>(pos + n),
+                             (end - pos) * sizeof(T));
+                throw;
+            }
+        }
+
+        template <typename T, class Iter>
+        void
+        insert_range(T *pos, T *end, Iter first, Iter last, size_t n) {
+            insert_range(pos, end, first, last, n, relocatable_tag<T>());
+        }
+
+        /*
+         * Relocate [b, pos) and [pos, end) into the fresh buffer dest
+         * around a gap of n slots at dest + (pos - b) which the caller
+         * has already filled: one pass over the old elements however
+         * many are inserted. If anything throws, dest holds no objects
+         * and [b, end) is untouched; on success the old elements are
+         * destroyed.
+         */
+        template <typename T>
+        void
+        relocate_around(T *b, T *pos, T *end, T *dest, size_t n) {
+            T *gap = dest + (pos - b);
+
+            if (relocatable_tag<T>::value) {
+                relocate(b, pos, dest);
+                relocate(pos, end, gap + n);
+                return;
+            }
+            try {
+                uninitialized_move_if_noexcept(b, pos, dest);
+            } catch (...) {
+                destroy(gap, gap + n);
+                throw;
+            }
+            try {
+                uninitialized_move_if_noexcept(pos, end, gap + n);
+            } catch (...) {
+                destroy(dest, gap + n);
+                throw;
+            }
+            destroy(b, end);
+        }
+
+        template <typename T, class Iter>
+        void
+        relocate_with_gap(T *b, T *pos, T *end, T *dest,
+                          Iter first, Iter last, size_t n) {
+            std::uninitialized_copy(first, last, dest + (pos - b));
+            relocate_around(b, pos, end, dest, n);
+        }
+
+        /* @class repeat_iterator
+         * A forward iterator that yields the same value n times, so
+         * that insert(pos, n, val) can share the range code.
+         */
+        template <typename T>
+        class repeat_iterator {
+        public:
+            typedef std::forward_iterator_tag    iterator_category;
+            typedef T                            value_type;
+            typedef ptrdiff_t                    difference_type;
+            typedef const T*                     pointer;
+            typedef const T&                     reference;
+
+            repeat_iterator(const T *v, size_t n): val(v), cnt(n) {}
+
+            reference operator*() const { return *val; }
+            pointer operator->() const { return val; }
+            repeat_iterator& operator++() { ++cnt; return *this; }
+            repeat_iterator operator++(int) { repeat_iterator r(*this); ++cnt; return r; }
+            bool operator==(const repeat_iterator &it) const { return cnt == it.cnt; }
+            bool operator!=(const repeat_iterator &it) const { return cnt != it.cnt; }
+
+        private:
+            const T    *val;
+            size_t     cnt;
+        };
+
+        // excludes integral arguments from the iterator-pair overloads.
+        template <class Iter>
+        struct enable_if_iterator
+        : std::enable_if<!std::is_integral<Iter>::value> {};
+
+        template <class Iter>
+        struct iterator_category {
+            typedef typename std::iterator_traits<Iter>::iterator_category type;
+        };
+
+        // whether Alloc provides reallocate(p, old_n, new_n).
+        template <class Alloc>
+        struct has_reallocate {
+            template <class A>
+            static std::true_type test(decltype(std::declval<A&>().reallocate(
+                    static_cast<typename A::value_type*>(nullptr), size_t(), size_t()))*);
+            template <class A>
+            static std::false_type test(...);
+
+            static const bool value = decltype(test<Alloc>(nullptr))::value;
+        };
+
+        template <class Alloc, typename T>
+        T*
+        reallocate(Alloc &a, T *p, size_t old_n, size_t n) {
+            if (p == nullptr)
+                return a.allocate(n);
+            return a.reallocate(p, old_n, n);
+        }
+    }
+
+    /*
+     * Growth policies for my::vector. When cap slots are too few for
+     * needed elements of elem_size bytes, next(cap, needed, elem_size)
+     * gives the new capacity, which must be at least needed.
+     */
+    struct grow_double {
+        static size_t next(size_t cap, size_t needed, size_t) {
+            size_t n = cap ? 2 * cap : 10;
+            return n < needed ? needed : n;
+        }
+    };
+
+    // 1.5x wastes less space, and freed blocks can be reused sooner.
+    struct grow_by_half {
+        static size_t next(size_t cap, size_t needed, size_t) {
+            size_t n = cap ? cap + cap / 2 : 10;
+            return n < needed ? needed : n;
+        }
+    };
+
+    // no spare room at all; every growth reallocates.
+    struct grow_exact {
+        static size_t next(size_t, size_t needed, size_t) { return needed; }
+    };
+
+    // Base's capacity rounded up to whole pages of Page bytes.
+    template <class Base = grow_double, size_t Page = 4096>
+    struct grow_page_rounded {
+        static size_t next(size_t cap, size_t needed, size_t elem_size) {
+            size_t bytes = Base::next(cap, needed, elem_size) * elem_size;
+            return (bytes + Page - 1) / Page * Page / elem_size;
+        }
+    };
+
+    template <typename T, class Alloc = allocator<T>, class Growth = grow_double>
     class vector {
     public:
         typedef size_t     size_type;
         typedef T          value_type;
         typedef T*         iterator;
         typedef const T*   const_iterator;
+        typedef Alloc      allocator_type;
+        typedef Growth     growth_policy;
 
         // constructors and destructor.
-        vector(size_type size = 0);
-        vector(size_type size, const value_type &val);
-        template <class Itr>
-        vector(Itr begin, Itr end);
+        vector();
+        vector(size_type size);
+        explicit vector(const allocator_type &alloc);
+        vector(size_type size, const value_type &val,
+               const allocator_type &alloc = allocator_type());
+        template <class Itr, typename = typename detail::enable_if_iterator<Itr>::type>
+        vector(Itr begin, Itr end, const allocator_type &alloc = allocator_type());
         vector(const vector &vec);
-        vector(std::initializer_list<T> il);
+        vector(std::initializer_list<T> il,
+               const allocator_type &alloc = allocator_type());
         vector(vector &&vec);
 
-        ~vector() {s = 0; cap = 0; delete [] b;}
+        ~vector() { detail::destroy(b, b + s); deallocate(b, cap); s = 0; cap = 0; }
 
         // assginments.
         vector& operator=(const vector &vec);
@@ -46,6 +381,7 @@ namespace my {
         size_type capacity(void) const { return cap; }
         bool empty(void) const { return s == 0; }
         void reserve(size_type n);
+        void shrink_to_fit(void);
 
         // access.
         T& operator[](size_type n) { return b[n]; }
@@ -58,24 +394,134 @@ namespace my {
         // modifiers.
         void push_back(const value_type &val);
         void push_back(value_type &&val);
-        void pop_back(void) { s--; }
+        void pop_back(void) { b[--s].~T(); }
+        template <class... Args> T& emplace_back(Args&&... args);
+        template <class... Args> iterator emplace(const_iterator pos, Args&&... args);
         iterator insert(const_iterator pos, const value_type &val);
         iterator insert(const_iterator pos, size_type n, const value_type &val);
-        template <class Iter> iterator insert(const_iterator pos, Iter pb, Iter pe);
+        template <class Iter, typename = typename detail::enable_if_iterator<Iter>::type>
+        iterator insert(const_iterator pos, Iter pb, Iter pe);
         iterator insert(const_iterator pos, value_type &&val);
         iterator insert(const_iterator pos, std::initializer_list<value_type> il);
         iterator erase(const_iterator pos);
         iterator erase(const_iterator pb, const_iterator pe);
 
-        void clear() { s= 0; }
+        /*
+         * Range operations. A forward range is measured first, so
+         * the buffer is reallocated at most once and the tail is
+         * shifted once; an input range is buffered. The range must
+         * not point into *this.
+         */
+        template <class Iter, typename = typename detail::enable_if_iterator<Iter>::type>
+        void append(Iter first, Iter last) { insert(end(), first, last); }
+        template <class Iter, typename = typename detail::enable_if_iterator<Iter>::type>
+        void assign(Iter first, Iter last);
+
+        void clear() { detail::destroy(b, b + s); s = 0; }
+
+    private:
+        /*
+         * The buffer [b, b + cap) is raw memory: only the first
+         * s slots hold constructed objects, the rest are left
+         * uninitialized until an element is built in place.
+         */
+        T* allocate(size_type n);
+        size_type grown(size_type needed) const {
+            return Growth::next(cap, needed, sizeof(T));
+        }
+        void deallocate(T *p, size_type n);
+        void reallocate(size_type n);
+        void reallocate(size_type n, std::false_type);
+        void reallocate(size_type n, std::true_type);
+        typedef std::integral_constant<bool,
+                    detail::relocatable_tag<T>::value &&
+                    detail::has_reallocate<Alloc>::value> realloc_tag;
+        template <class... Args>
+        void grow_emplace(size_type idx, Args&&... args);
+        template <class... Args>
+        void grow_emplace(std::false_type, size_type idx, Args&&... args);
+        template <class... Args>
+        void grow_emplace(std::true_type, size_type idx, Args&&... args);
+        template <class Iter>
+        void insert_range(size_type idx, Iter first, Iter last, std::input_iterator_tag);
+        template <class Iter>
+        void insert_range(size_type idx, Iter first, Iter last, std::forward_iterator_tag);
+        template <class Iter>
+        void assign_range(Iter first, Iter last, std::input_iterator_tag);
+        template <class Iter>
+        void assign_range(Iter first, Iter last, std::forward_iterator_tag);
+
+    public:
+        allocator_type get_allocator(void) const { return a; }
 
     private:
         T                         *b;
         size_type                 s;
         size_type                 cap;
-        static const size_type    init_cap = 10;
+        allocator_type            a;
     };
 
+    /*
+     * A vector whose buffer starts on a cache line and is padded to
+     * whole lines, for the kernels in simd.hpp.
+     */
+    template <typename T>
+    using aligned_vector = vector<T, aligned_allocator<T, 64>>;
+
+    template <typename T, class Alloc, class Growth>
+    T*
+    vector<T, Alloc, Growth>::allocate(size_type n) {
+        if (n == 0)
+            return nullptr;
+        return a.allocate(n);
+    }
+
+    template <typename T, class Alloc, class Growth>
+    void
+    vector<T, Alloc, Growth>::deallocate(T *p, size_type n) {
+        if (p != nullptr)
+            a.deallocate(p, n);
+    }
+
+    /*
+     * Move the live elements into a buffer of n slots. Trivially
+     * relocatable elements let an allocator with reallocate()
+     * (realloc() for my::allocator) grow the block in place or move
+     * it with a single copy.
+     */
+    template <typename T, class Alloc, class Growth>
+    void
+    vector<T, Alloc, Growth>::reallocate(size_type n) {
+        reallocate(n, realloc_tag());
+    }
+
+    template <typename T, class Alloc, class Growth>
+    void
+    vector<T, Alloc, Growth>::reallocate(size_type n, std::true_type) {
+        b = detail::reallocate(a, b, cap, n);
+        cap = n;
+    }
+
+    template <typename T, class Alloc, class Growth>
+    void
+    vector<T, Alloc, Growth>::reallocate(size_type n, std::false_type) {
+        T *temp = allocate(n);
+
+        try {
+            detail::relocate(b, b + s, temp);
+        } catch (...) {
+            deallocate(temp, n);
+            throw;
+        }
+        deallocate(b, cap);
+        b = temp;
+        cap = n;
+    }
+
+    template <typename T, class Alloc, class Growth>
+    vector<T, Alloc, Growth>::vector()
+    : b(nullptr), s(0), cap(0) {}
+
     /*
      * At the first time, this function is writted as
      * follows:
@@ -89,218 +535,390 @@ namespace my {
      * argument should not be rewritten here, i.e.,
      * simply written as size_type size not size_type = 0.
      */
-    template <typename T>
-    vector<T>::vector(size_type size)
-    : b(nullptr), s(size), cap(init_cap + size) {
-        cap = init_cap + size;
-        b = new T[cap];
+    template <typename T, class Alloc, class Growth>
+    vector<T, Alloc, Growth>::vector(size_type size)
+    : b(nullptr), s(0), cap(size) {
+        b = allocate(cap);
+        for ( ; s < size; ++s)
+            ::new (static_cast<void*>(b + s)) T();
     }
 
-    template <typename T>
-    vector<T>::vector(size_type size, const value_type &val)
-    : b(nullptr), s(size), cap(init_cap + size) {
-        b = new T[cap];
-
-        for (size_type i = 0; i < size; ++i)
-            b[i] = val;
+    template <typename T, class Alloc, class Growth>
+    vector<T, Alloc, Growth>::vector(const allocator_type &alloc)
+    : b(nullptr), s(0), cap(0), a(alloc) {}
+
+    template <typename T, class Alloc, class Growth>
+    vector<T, Alloc, Growth>::vector(size_type size, const value_type &val,
+                             const allocator_type &alloc)
+    : b(nullptr), s(0), cap(size), a(alloc) {
+        b = allocate(cap);
+        std::uninitialized_fill_n(b, size, val);
+        s = size;
     }
 
-   template <typename T>
-   template <class Itr>
-   vector<T>::vector(Itr begin, Itr end)
-   : b(nullptr), s(0), cap(init_cap) {
-       b = new T[cap];
-       for ( ; begin != end; ++s, ++begin) {
-           if (cap < s)
-               reserve(2 * cap);
-           b[s] = *begin;
-       }
+   template <typename T, class Alloc, class Growth>
+   template <class Itr, typename>
+   vector<T, Alloc, Growth>::vector(Itr begin, Itr end, const allocator_type &alloc)
+   : b(nullptr), s(0), cap(0), a(alloc) {
+       append(begin, end);
    }
 
-   template <typename T>
-   vector<T>::vector(const vector &vec)
-   : b(nullptr), s(vec.size()),
-     cap(vec.capacity()) {
-       b = new T[cap];
-       for (size_type i = 0; i < s; ++i)
-           b[i];
+   template <typename T, class Alloc, class Growth>
+   vector<T, Alloc, Growth>::vector(const vector &vec)
+   : b(nullptr), s(0), cap(vec.s), a(vec.a) {
+       b = allocate(cap);
+       std::uninitialized_copy(vec.b, vec.b + vec.s, b);
+       s = vec.s;
    }
 
-   template <typename T>
-   vector<T>::vector(std::initializer_list<T> il)
-   : b(nullptr), s(0), cap(il.size() * 2) {
-       b = new T[cap];
-       for (auto &e : il)
-           b[s++] = e;
+   template <typename T, class Alloc, class Growth>
+   vector<T, Alloc, Growth>::vector(std::initializer_list<T> il, const allocator_type &alloc)
+   : b(nullptr), s(0), cap(il.size()), a(alloc) {
+       b = allocate(cap);
+       std::uninitialized_copy(il.begin(), il.end(), b);
+       s = il.size();
    }
 
-   template <typename T>
-   vector<T>::vector(vector &&vec)
-   : b(vec.b), s(vec.s), cap(vec.cap) {
+   template <typename T, class Alloc, class Growth>
+   vector<T, Alloc, Growth>::vector(vector &&vec)
+   : b(vec.b), s(vec.s), cap(vec.cap), a(vec.a) {
        vec.b = nullptr;
        vec.s = 0;
        vec.cap = 0;
    }
 
-   template <typename T>
-   vector<T> &
-   vector<T>::operator=(const vector &vec) {
-       if (cap < vec.s) {
-           cap = 2 * vec.s;
-           reserve(cap);
-       }
-       
-       s = 0;
-       for ( ; s < vec.s; ++s)
-           b[s] = vec.b[s];
+   template <typename T, class Alloc, class Growth>
+   vector<T, Alloc, Growth> &
+   vector<T, Alloc, Growth>::operator=(const vector &vec) {
+       if (this != &vec)
+           assign(vec.b, vec.b + vec.s);
 
        return *this;
    }
 
-   template <typename T>
-   vector<T> &
-   vector<T>::operator=(vector &&vec) {
-       delete [] b;
-       b = vec.b; s = vec.s; cap = vec.cap;
+   template <typename T, class Alloc, class Growth>
+   vector<T, Alloc, Growth> &
+   vector<T, Alloc, Growth>::operator=(vector &&vec) {
+       if (this == &vec)
+           return *this;
+
+       // the allocator travels with the buffer.
+       detail::destroy(b, b + s);
+       deallocate(b, cap);
+       b = vec.b; s = vec.s; cap = vec.cap; a = vec.a;
 
        vec.b = nullptr; vec.s = 0; vec.cap = 0;
 
        return *this;
    }
 
-   template <typename T>
-   vector<T> &
-   vector<T>::operator=(std::initializer_list<T> il) {
-       if (cap < il.size()) {
-           cap = 2 * il.size();
-           reserve(cap);
-       }
-
-       s = 0;
-       for (auto &i : il)
-           b[s++] = i;
+   template <typename T, class Alloc, class Growth>
+   vector<T, Alloc, Growth> &
+   vector<T, Alloc, Growth>::operator=(std::initializer_list<T> il) {
+       assign(il.begin(), il.end());
 
        return *this;
    }
 
-    template <typename T>
+    template <typename T, class Alloc, class Growth>
     void
-    vector<T>::resize(size_type n) {
-        if (cap <= n)
-            reserve(2 * n);
+    vector<T, Alloc, Growth>::resize(size_type n) {
+        if (cap < n)
+            reserve(grown(n));
+        for ( ; s < n; ++s)
+            ::new (static_cast<void*>(b + s)) T();
+        detail::destroy(b + n, b + s);
         s = n;
     }
 
-    template <typename T>
+    template <typename T, class Alloc, class Growth>
     void
-    vector<T>::push_back(const value_type &val) {
-        if (cap < s + 1) {
-            cap = 2 * cap;
-            reserve(cap);
+    vector<T, Alloc, Growth>::push_back(const value_type &val) {
+        emplace_back(val);
+    }
+
+    template <typename T, class Alloc, class Growth>
+    void
+    vector<T, Alloc, Growth>::push_back(value_type &&val) {
+        emplace_back(std::move(val));
+    }
+
+    template <typename T, class Alloc, class Growth>
+    template <class... Args>
+    void
+    vector<T, Alloc, Growth>::grow_emplace(size_type idx, Args&&... args) {
+        grow_emplace(realloc_tag(), idx, std::forward<Args>(args)...);
+    }
+
+    /*
+     * Build the new element straight in a grown buffer at slot idx,
+     * then relocate the old elements around it. The arguments may
+     * refer to elements of *this: they are used before anything
+     * moves.
+     */
+    template <typename T, class Alloc, class Growth>
+    template <class... Args>
+    void
+    vector<T, Alloc, Growth>::grow_emplace(std::false_type, size_type idx, Args&&... args) {
+        size_type n_cap = grown(s + 1);
+        T *temp = allocate(n_cap);
+
+        try {
+            ::new (static_cast<void*>(temp + idx)) T(std::forward<Args>(args)...);
+            detail::relocate_around(b, b + idx, b + s, temp, 1);
+        } catch (...) {
+            deallocate(temp, n_cap);
+            throw;
         }
-        b[s++] = val;
+        deallocate(b, cap);
+        b = temp;
+        cap = n_cap;
     }
 
-    template <typename T>
+    /*
+     * The block can be grown by reallocate(), which may move it, so
+     * the element is built aside first in case the arguments refer
+     * to elements of *this.
+     */
+    template <typename T, class Alloc, class Growth>
+    template <class... Args>
     void
-    vector<T>::push_back(value_type &&val) {
+    vector<T, Alloc, Growth>::grow_emplace(std::true_type, size_type idx, Args&&... args) {
+        value_type tmp(std::forward<Args>(args)...);
+
+        reallocate(grown(s + 1));
+        detail::insert_at(b + idx, b + s, std::move(tmp));
+    }
+
+    template <typename T, class Alloc, class Growth>
+    template <class... Args>
+    T&
+    vector<T, Alloc, Growth>::emplace_back(Args&&... args) {
+        if (cap < s + 1)
+            grow_emplace(s, std::forward<Args>(args)...);
+        else
+            ::new (static_cast<void*>(b + s)) T(std::forward<Args>(args)...);
+        return b[s++];
+    }
+
+    /*
+     * At the end or when the buffer grows the element is built in
+     * place. Otherwise it is built aside and moved into the hole,
+     * since the arguments may refer to elements about to shift.
+     */
+    template <typename T, class Alloc, class Growth>
+    template <class... Args>
+    typename vector<T, Alloc, Growth>::iterator
+    vector<T, Alloc, Growth>::emplace(const_iterator pos, Args&&... args) {
+        size_type idx = pos - b;
+
         if (cap < s + 1) {
-            cap = 2 * cap;
-            reserve(cap);
+            grow_emplace(idx, std::forward<Args>(args)...);
+        } else if (idx == s) {
+            ::new (static_cast<void*>(b + s)) T(std::forward<Args>(args)...);
+        } else {
+            value_type tmp(std::forward<Args>(args)...);
+            detail::insert_at(b + idx, b + s, std::move(tmp));
         }
-        b[s++] = std::move(val);
+        ++s;
+
+        return b + idx;
     }
 
-    template <typename T>
+    template <typename T, class Alloc, class Growth>
     void
-    vector<T>::resize(size_type n, const value_type &val) {
-        if (cap <= n)
-            reserve(2 * n);
-        for (size_type i = s; i < n; ++i)
-            b[i] = val;
+    vector<T, Alloc, Growth>::resize(size_type n, const value_type &val) {
+        if (cap < n) {
+            value_type tmp(val);
+            reserve(grown(n));
+            std::uninitialized_fill(b + s, b + n, tmp);
+        } else if (s < n) {
+            std::uninitialized_fill(b + s, b + n, val);
+        } else {
+            detail::destroy(b + n, b + s);
+        }
         s = n;
     }
 
-    template <typename T>
+    template <typename T, class Alloc, class Growth>
     void
-    vector<T>::reserve(size_type n) {
-        if (cap < n) {
-            cap = n;
-            T *temp = new T[cap];
-            for (size_type i = 0; i < s; ++i)
-                temp[i] = b[i];
-            delete [] b;
-            b = temp;
+    vector<T, Alloc, Growth>::reserve(size_type n) {
+        if (cap < n)
+            reallocate(n);
+    }
+
+    template <typename T, class Alloc, class Growth>
+    void
+    vector<T, Alloc, Growth>::shrink_to_fit(void) {
+        if (cap == s)
+            return;
+        if (s == 0) {
+            deallocate(b, cap);
+            b = nullptr;
+            cap = 0;
+            return;
         }
+        reallocate(s);
     }
 
-    template <typename T>
-    typename vector<T>::iterator
-    vector<T>::insert(const_iterator pos, const value_type &val) {
-        if (cap < s + 1) {
-            cap = 2 * cap;
-            reserve(cap);
+    template <typename T, class Alloc, class Growth>
+    typename vector<T, Alloc, Growth>::iterator
+    vector<T, Alloc, Growth>::insert(const_iterator pos, const value_type &val) {
+        return emplace(pos, val);
+    }
+
+    template <typename T, class Alloc, class Growth>
+    typename vector<T, Alloc, Growth>::iterator
+    vector<T, Alloc, Growth>::insert(const_iterator pos, value_type &&val) {
+        size_type idx = pos - b;
+
+        if (cap < s + 1 || idx == s)
+            return emplace(pos, std::move(val));
+        detail::insert_at(b + idx, b + s, std::move(val));
+        ++s;
+
+        return b + idx;
+    }
+
+    template <typename T, class Alloc, class Growth>
+    typename vector<T, Alloc, Growth>::iterator
+    vector<T, Alloc, Growth>::insert(const_iterator pos, size_type n, const value_type &val) {
+        size_type idx = pos - b;
+        // val may live in this vector.
+        value_type tmp(val);
+
+        insert_range(idx, detail::repeat_iterator<T>(&tmp, 0),
+                     detail::repeat_iterator<T>(&tmp, n),
+                     std::forward_iterator_tag());
+        return b + idx;
+    }
+
+    template <typename T, class Alloc, class Growth>
+    template <class Iter, typename>
+    typename vector<T, Alloc, Growth>::iterator
+    vector<T, Alloc, Growth>::insert(const_iterator pos, Iter pb, Iter pe) {
+        size_type idx = pos - b;
+
+        insert_range(idx, pb, pe, typename detail::iterator_category<Iter>::type());
+        return b + idx;
+    }
+
+    /*
+     * An input range can only be walked once, so a middle insert
+     * collects it first and then moves it in as a forward range.
+     */
+    template <typename T, class Alloc, class Growth>
+    template <class Iter>
+    void
+    vector<T, Alloc, Growth>::insert_range(size_type idx, Iter first, Iter last, std::input_iterator_tag) {
+        if (idx == s) {
+            for ( ; first != last; ++first)
+                push_back(*first);
+            return;
         }
-        for (iterator iter = b + s; iter != pos; --iter)
-            *iter = *(iter - 1);
-        *pos = val; s++;
 
-        return pos;
+        vector buffer(first, last, a);
+        insert_range(idx, std::make_move_iterator(buffer.begin()),
+                     std::make_move_iterator(buffer.end()),
+                     std::forward_iterator_tag());
     }
 
-    template <typename T>
-    typename vector<T>::iterator
-    vector<T>::insert(const_iterator pos, value_type &&val) {
-        if (cap < s + 1) {
-            cap = 2 * cap;
-            reserve(cap);
+    template <typename T, class Alloc, class Growth>
+    template <class Iter>
+    void
+    vector<T, Alloc, Growth>::insert_range(size_type idx, Iter first, Iter last, std::forward_iterator_tag) {
+        size_type n = std::distance(first, last);
+
+        if (n == 0)
+            return;
+        if (cap < s + n) {
+            size_type n_cap = grown(s + n);
+            T *temp = allocate(n_cap);
+
+            try {
+                detail::relocate_with_gap(b, b + idx, b + s, temp, first, last, n);
+            } catch (...) {
+                deallocate(temp, n_cap);
+                throw;
+            }
+            deallocate(b, cap);
+            b = temp;
+            cap = n_cap;
+        } else {
+            detail::insert_range(b + idx, b + s, first, last, n);
         }
-        for (iterator iter = b + s; iter != pos; --iter)
-            *iter = *(iter - 1);
-        *pos = std::move(val); s++;
+        s += n;
+    }
 
-        return pos;
+    template <typename T, class Alloc, class Growth>
+    template <class Iter, typename>
+    void
+    vector<T, Alloc, Growth>::assign(Iter first, Iter last) {
+        assign_range(first, last, typename detail::iterator_category<Iter>::type());
     }
 
-    template <typename T>
-    typename vector<T>::iterator
-    vector<T>::insert(const_iterator pos, size_type n, const value_type &val) {
-        while (n--)
-            insert(val);
-        return pos;
+    template <typename T, class Alloc, class Growth>
+    template <class Iter>
+    void
+    vector<T, Alloc, Growth>::assign_range(Iter first, Iter last, std::input_iterator_tag) {
+        clear();
+        for ( ; first != last; ++first)
+            push_back(*first);
     }
 
-    template <typename T>
+    /*
+     * Existing elements are assigned over; a new buffer is only
+     * taken when the range does not fit.
+     */
+    template <typename T, class Alloc, class Growth>
     template <class Iter>
-    typename vector<T>::iterator
-    vector<T>::insert(const_iterator pos, Iter pb, Iter pe) {
-        for (Iter iter = pb; iter != pe; ++iter)
-            insert(pos, *iter);
-        return pos;
+    void
+    vector<T, Alloc, Growth>::assign_range(Iter first, Iter last, std::forward_iterator_tag) {
+        size_type n = std::distance(first, last);
+
+        if (cap < n) {
+            T *temp = allocate(n);
+
+            try {
+                std::uninitialized_copy(first, last, temp);
+            } catch (...) {
+                deallocate(temp, n);
+                throw;
+            }
+            clear();
+            deallocate(b, cap);
+            b = temp;
+            cap = n;
+        } else if (s < n) {
+            Iter mid = first;
+            std::advance(mid, s);
+            std::copy(first, mid, b);
+            std::uninitialized_copy(mid, last, b + s);
+        } else {
+            detail::destroy(std::copy(first, last, b), b + s);
+        }
+        s = n;
     }
 
-    template <typename T>
-    typename vector<T>::iterator
-    vector<T>::insert(const_iterator pos, std::initializer_list<T> il) {
-        for (auto &i : il)
-            insert(i);
-        return pos;
+    template <typename T, class Alloc, class Growth>
+    typename vector<T, Alloc, Growth>::iterator
+    vector<T, Alloc, Growth>::insert(const_iterator pos, std::initializer_list<T> il) {
+        return insert(pos, il.begin(), il.end());
     }
 
-    template <typename T>
-    typename vector<T>::iterator
-    vector<T>::erase(const_iterator pos) {
-        for (iterator iter = pos; iter - b != s; ++iter)
-            *iter = *(iter + 1);
-        return pos;
+    template <typename T, class Alloc, class Growth>
+    typename vector<T, Alloc, Growth>::iterator
+    vector<T, Alloc, Growth>::erase(const_iterator pos) {
+        return erase(pos, pos + 1);
     }
 
-    template <typename T>
-    typename vector<T>::iterator
-    vector<T>::erase(const_iterator pb, const_iterator pe) {
-        for (size_type i = pe - pb; i >= 0; --i)
-            erase(pb);
-        return pb;
+    template <typename T, class Alloc, class Growth>
+    typename vector<T, Alloc, Growth>::iterator
+    vector<T, Alloc, Growth>::erase(const_iterator pb, const_iterator pe) {
+        iterator first = b + (pb - b), last = b + (pe - b);
+
+        s = detail::erase_range(first, last, b + s) - b;
+        return first;
     }
 }
 
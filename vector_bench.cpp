@@ -0,0 +1,244 @@
+/*
+ * my::vector against std::vector: growth by push_back, push_back
+ * after reserve, insert/erase at the front, middle and back, copy
+ * construction and assignment, move and iteration, for int, double,
+ * std::string and a 64-byte POD at sizes from 10 to 10^7.
+ *
+ * malloc() and friends are interposed to count allocations, which
+ * covers both containers (my::allocator calls malloc() directly,
+ * std::allocator through operator new) and the strings' own buffers.
+ * The interposition relies on glibc's __libc_* entry points.
+ *
+ * One CSV row per measurement goes to stdout:
+ *     operation,type,container,size,unit,ns_per_op,allocations
+ * unit says what an op is: one element for whole-container
+ * operations, one call for insert, erase and move. allocations are
+ * per repetition of the operation.
+ *
+ * build: g++ -std=c++14 -O2 vector_bench.cpp -o vector_bench
+ * run:   ./vector_bench [max_size] > vector.csv
+ */
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstddef>
+
+#include "vector.hpp"
+
+extern "C" {
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void  __libc_free(void*);
+}
+
+static size_t allocations = 0;
+
+extern "C" {
+    void* malloc(size_t n) { ++allocations; return __libc_malloc(n); }
+    void* calloc(size_t n, size_t m) { ++allocations; return __libc_calloc(n, m); }
+    void* realloc(void *p, size_t n) { ++allocations; return __libc_realloc(p, n); }
+    void  free(void *p) { __libc_free(p); }
+}
+
+typedef std::chrono::steady_clock    clock_type;
+
+/* @struct pod64
+ * A trivially copyable element of one cache line.
+ */
+struct pod64 {
+    double    v[8];
+};
+
+static_assert(sizeof(pod64) == 64, "pod64 must be 64 bytes");
+
+template <typename T> T make(size_t i);
+template <> int make<int>(size_t i) { return static_cast<int>(i); }
+template <> double make<double>(size_t i) { return i * 0.5; }
+// long enough to live outside the small-string buffer.
+template <> std::string make<std::string>(size_t i) {
+    return "element number " + std::to_string(i);
+}
+template <> pod64 make<pod64>(size_t i) {
+    pod64 p = {{0}};
+    p.v[0] = static_cast<double>(i);
+    return p;
+}
+
+inline size_t weight(int x) { return static_cast<size_t>(x); }
+inline size_t weight(double x) { return static_cast<size_t>(x); }
+inline size_t weight(const std::string &x) { return x.size(); }
+inline size_t weight(const pod64 &x) { return static_cast<size_t>(x.v[0]); }
+
+static volatile size_t    sink;
+
+template <class Vec>
+Vec filled(size_t n) {
+    Vec vec;
+    for (size_t i = 0; i < n; ++i)
+        vec.push_back(make<typename Vec::value_type>(i));
+    return vec;
+}
+
+struct result {
+    double    ns;
+    double    allocs;
+};
+
+/* @fn measure()
+ * Run op reps times and report the time per op and allocations
+ * per repetition. The clock is read once around all repetitions,
+ * or around each one when an untimed setup has to run before it.
+ */
+template <class Op>
+result measure(size_t reps, size_t ops_per_rep, Op op) {
+    size_t    before = allocations;
+    auto      start = clock_type::now();
+
+    for (size_t r = 0; r < reps; ++r)
+        op();
+    double ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+    result res = { ns / (reps * ops_per_rep),
+                   static_cast<double>(allocations - before) / reps };
+    return res;
+}
+
+template <class Setup, class Op>
+result measure(size_t reps, size_t ops_per_rep, Setup setup, Op op) {
+    double    ns = 0;
+    size_t    allocs = 0;
+
+    for (size_t r = 0; r < reps; ++r) {
+        setup();
+        size_t before = allocations;
+        auto start = clock_type::now();
+        op();
+        ns += std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+        allocs += allocations - before;
+    }
+    result res = { ns / (reps * ops_per_rep), static_cast<double>(allocs) / reps };
+    return res;
+}
+
+void row(const char *op, const char *type, const char *container,
+         size_t n, const char *unit, const result &r) {
+    std::cout << op << ',' << type << ',' << container << ',' << n << ','
+              << unit << ',' << r.ns << ',' << r.allocs << '\n';
+}
+
+/*
+ * Repetitions so that each measurement touches about 10^6
+ * elements, and insert/erase counts that keep the front and middle
+ * cases from going quadratic at large sizes.
+ */
+inline size_t reps_for(size_t n) { return n >= 1000000 ? 1 : 1000000 / n; }
+inline size_t edits_for(size_t n) {
+    size_t k = 1000000 / n;
+    return k < 1 ? 1 : (k > 1000 ? 1000 : k);
+}
+
+template <class Vec>
+void run(const char *type, const char *container, size_t n) {
+    typedef typename Vec::value_type    T;
+    const size_t    reps = reps_for(n);
+    const T         x = make<T>(n);
+
+    row("push_back", type, container, n, "element", measure(reps, n, [&] {
+        Vec vec;
+        for (size_t i = 0; i < n; ++i)
+            vec.push_back(x);
+        sink = vec.size();
+    }));
+
+    row("reserve_push_back", type, container, n, "element", measure(reps, n, [&] {
+        Vec vec;
+        vec.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            vec.push_back(x);
+        sink = vec.size();
+    }));
+
+    // insert k elements, then erase them again, at three positions.
+    const size_t    k = edits_for(n);
+    const size_t    edit_reps = reps_for(n * k) < 100 ? reps_for(n * k) : 100;
+    Vec             vec = filled<Vec>(n);
+    const char      *where[] = { "front", "middle", "back" };
+
+    for (int w = 0; w < 3; ++w) {
+        auto pos = [&](Vec &v) -> size_t {
+            return w == 0 ? 0 : (w == 1 ? v.size() / 2 : v.size());
+        };
+        std::string ins = std::string("insert_") + where[w];
+        std::string era = std::string("erase_") + where[w];
+
+        row(ins.c_str(), type, container, n, "call",
+            measure(edit_reps, k, [&] {
+                while (vec.size() > n)
+                    vec.pop_back();
+            }, [&] {
+                for (size_t i = 0; i < k; ++i)
+                    vec.insert(vec.begin() + pos(vec), x);
+            }));
+        row(era.c_str(), type, container, n, "call",
+            measure(edit_reps, k, [&] {
+                while (vec.size() < n + k)
+                    vec.push_back(x);
+            }, [&] {
+                for (size_t i = 0; i < k; ++i)
+                    vec.erase(vec.begin() + (w == 2 ? vec.size() - 1 : pos(vec)));
+            }));
+        while (vec.size() > n)
+            vec.pop_back();
+    }
+
+    const Vec src = filled<Vec>(n);
+
+    row("copy_construct", type, container, n, "element", measure(reps, n, [&] {
+        Vec copy(src);
+        sink = copy.size();
+    }));
+
+    Vec dst = filled<Vec>(n);
+    row("copy_assign", type, container, n, "element", measure(reps, n, [&] {
+        dst = src;
+        sink = dst.size();
+    }));
+
+    Vec from = filled<Vec>(n);
+    row("move", type, container, n, "call", measure(reps, 2, [&] {
+        Vec to(std::move(from));
+        from = std::move(to);
+        sink = from.size();
+    }));
+
+    row("iterate", type, container, n, "element", measure(reps, n, [&] {
+        size_t sum = 0;
+        for (const T &v : src)
+            sum += weight(v);
+        sink = sum;
+    }));
+}
+
+template <typename T>
+void run_type(const char *type, size_t max_size) {
+    for (size_t n = 10; n <= max_size; n *= 10) {
+        run<std::vector<T>>(type, "std::vector", n);
+        run<my::vector<T>>(type, "my::vector", n);
+        std::cout.flush();
+    }
+}
+
+int
+main(int argc, char **argv) {
+    size_t max_size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+    std::cout << "operation,type,container,size,unit,ns_per_op,allocations\n";
+    run_type<int>("int", max_size);
+    run_type<double>("double", max_size);
+    run_type<std::string>("std::string", max_size);
+    run_type<pod64>("pod64", max_size);
+
+    return 0;
+}
@@ -0,0 +1,472 @@
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <iterator>
+#include <list>
+#include <cassert>
+#include <cstdio>
+#include <cstdint>
+
+#include "vector.hpp"
+#include "small_vector.hpp"
+#include "simd.hpp"
+#include "mapped_vector.hpp"
+
+/*
+ * An element type that counts how many objects are alive and
+ * how they were created, so that the tests can check that the
+ * spare capacity of my::vector holds no constructed objects.
+ */
+struct tracked {
+    static int    alive;
+    static int    copies;
+    static int    moves;
+
+    tracked(int v = 0): value(v) { ++alive; }
+    tracked(int v, int scale): value(v * scale) { ++alive; }
+    tracked(const tracked& t): value(t.value) { ++alive; ++copies; }
+    tracked(tracked&& t) noexcept: value(t.value) { ++alive; ++moves; t.value = -1; }
+    ~tracked() { --alive; }
+
+    tracked& operator=(const tracked& t) { value = t.value; ++copies; return *this; }
+    tracked& operator=(tracked&& t) noexcept { value = t.value; ++moves; t.value = -1; return *this; }
+
+    static void reset(void) { copies = moves = 0; }
+
+    int    value;
+};
+
+int tracked::alive = 0;
+int tracked::copies = 0;
+int tracked::moves = 0;
+
+template <class Vec>
+void storage_test(const char* name) {
+    {
+        Vec vec;
+        assert(tracked::alive == 0);
+
+        for (int i = 0; i < 100; ++i)
+            vec.push_back(tracked(i));
+        assert(tracked::alive == 100);
+        assert(vec.capacity() >= 100);
+
+        // growth moves (noexcept) instead of copying.
+        tracked::reset();
+        vec.reserve(4 * vec.capacity());
+        assert(tracked::copies == 0 && tracked::moves == 100);
+        assert(tracked::alive == 100);
+
+        vec.resize(10);
+        assert(tracked::alive == 10);
+        vec.resize(20, tracked(7));
+        assert(tracked::alive == 20 && vec.back().value == 7);
+
+        vec.pop_back();
+        assert(tracked::alive == 19);
+
+        vec.insert(vec.begin() + 3, tracked(42));
+        assert(vec[3].value == 42 && vec[4].value == 3);
+        assert(tracked::alive == 20);
+
+        vec.erase(vec.begin() + 3);
+        assert(vec[3].value == 3 && tracked::alive == 19);
+
+        vec.erase(vec.begin(), vec.begin() + 5);
+        assert(vec.size() == 14 && vec[0].value == 5);
+        assert(tracked::alive == 14);
+
+        Vec cp(vec);
+        assert(cp.size() == vec.size() && cp[0].value == 5);
+        assert(tracked::alive == 28);
+
+        cp = Vec(3, tracked(1));
+        assert(cp.size() == 3 && tracked::alive == 17);
+
+        vec.clear();
+        assert(vec.empty() && tracked::alive == 3);
+    }
+    assert(tracked::alive == 0);
+    std::cout << name << ": storage_test passed" << std::endl;
+}
+
+/*
+ * Not trivially copyable, but declared trivially relocatable:
+ * growth, insert and erase must shift it by bytes without calling
+ * any of its constructors.
+ */
+struct relocatable: tracked {
+    relocatable(int v = 0): tracked(v) {}
+};
+
+namespace my {
+    template <> struct is_trivially_relocatable<relocatable>: std::true_type {};
+}
+
+void relocate_test(void) {
+    {
+        my::vector<relocatable> vec;
+
+        for (int i = 0; i < 1000; ++i)
+            vec.push_back(relocatable(i));
+        tracked::reset();
+        vec.reserve(10 * vec.capacity());
+        vec.insert(vec.begin() + 500, relocatable(-5));
+        vec.erase(vec.begin() + 10, vec.begin() + 20);
+        // only the inserted temporary is moved into place.
+        assert(tracked::copies == 0 && tracked::moves == 1);
+        assert(vec.size() == 991 && vec[9].value == 9 && vec[10].value == 20);
+        assert(vec[490].value == -5 && vec[491].value == 500);
+        assert(tracked::alive == 991);
+    }
+    assert(tracked::alive == 0);
+
+    my::vector<double> vec(0);
+    for (int i = 0; i < 100000; ++i)
+        vec.insert(vec.begin() + vec.size() / 2, static_cast<double>(i));
+    for (int i = 0; i < 50000; ++i)
+        vec.erase(vec.begin() + vec.size() / 2);
+    assert(vec.size() == 50000 && vec.front() == 1.0 && vec.back() == 0.0);
+    std::cout << "relocate_test passed" << std::endl;
+}
+
+template <class Vec>
+void range_test(const char* name) {
+    {
+        std::list<tracked> src, init;
+
+        for (int i = 0; i < 100; ++i)
+            init.push_back(tracked(i));
+        for (int i = 0; i < 50; ++i)
+            src.push_back(tracked(1000 + i));
+        // a forward range is measured: the buffer fits exactly.
+        Vec vec(init.begin(), init.end());
+        init.clear();
+        assert(vec.capacity() == 100);
+
+        // one reallocation; each old element is moved exactly once.
+        tracked::reset();
+        vec.insert(vec.begin() + 10, src.begin(), src.end());
+        assert(tracked::copies == 50 && tracked::moves == 100);
+        assert(vec.size() == 150 && vec[9].value == 9);
+        assert(vec[10].value == 1000 && vec[59].value == 1049 && vec[60].value == 10);
+
+        // in place: the tail is shifted once.
+        vec.reserve(1000);
+        tracked::reset();
+        vec.insert(vec.begin() + 140, src.begin(), src.end());
+        assert(tracked::copies == 50 && tracked::moves == 10);
+        assert(vec.size() == 200 && vec[140].value == 1000 && vec[190].value == 90);
+
+        vec.insert(vec.begin(), 3, tracked(-1));
+        assert(vec.size() == 203 && vec[2].value == -1 && vec[3].value == 0);
+
+        vec.assign(src.begin(), src.end());
+        assert(vec.size() == 50 && vec[49].value == 1049);
+        vec.append(src.begin(), src.end());
+        assert(vec.size() == 100 && vec[50].value == 1000);
+        assert(tracked::alive == 150);
+    }
+    assert(tracked::alive == 0);
+
+    {
+        std::istringstream is("1 2 3 4 5");
+        Vec vec{tracked(0), tracked(9)};
+        vec.insert(vec.begin() + 1, std::istream_iterator<int>(is),
+                   std::istream_iterator<int>());
+        assert(vec.size() == 7 && vec[1].value == 1 && vec[5].value == 5 && vec[6].value == 9);
+    }
+
+    std::cout << name << ": range_test passed" << std::endl;
+}
+
+template <class Vec>
+void emplace_test(const char* name) {
+    {
+        Vec vec;
+
+        // built in place: no temporary is copied or moved.
+        vec.reserve(100);
+        tracked::reset();
+        for (int i = 0; i < 100; ++i) {
+            tracked &t = vec.emplace_back(i, 2);
+            assert(t.value == 2 * i && &t == &vec.back());
+        }
+        assert(tracked::copies == 0 && tracked::moves == 0);
+
+        // a growing emplace_back only moves the old elements.
+        while (vec.size() < vec.capacity())
+            vec.emplace_back(0);
+        size_t old_size = vec.size();
+        tracked::reset();
+        vec.emplace_back(4, 4);
+        assert(tracked::copies == 0 && tracked::moves == static_cast<int>(old_size));
+        assert(vec.back().value == 16);
+        while (vec.size() > 100)
+            vec.pop_back();
+
+        vec.reserve(vec.size() + 10);
+        tracked::reset();
+        vec.emplace(vec.end(), 7, 3);
+        assert(tracked::copies == 0 && tracked::moves == 0 && vec.back().value == 21);
+
+        // in the middle: the tail shifts and the new element is moved in once.
+        tracked::reset();
+        auto it = vec.emplace(vec.begin() + 1, 5, 5);
+        assert(tracked::copies == 0 && tracked::moves == 1 + 100);
+        assert(it == vec.begin() + 1 && it->value == 25 && vec[2].value == 2);
+
+        // arguments that alias an element survive a growing emplace_back.
+        while (vec.size() < vec.capacity())
+            vec.emplace_back(0);
+        vec.emplace_back(vec[1]);
+        assert(vec.back().value == 25);
+    }
+    assert(tracked::alive == 0);
+    std::cout << name << ": emplace_test passed" << std::endl;
+}
+
+void arena_test(void) {
+    my::arena                    ar(4096);
+    my::arena_allocator<int>     alloc(ar);
+
+    {
+        my::vector<int, my::arena_allocator<int>> vec(alloc);
+
+        vec.push_back(0);
+        const int *first = vec.begin();
+        // the newest block of the arena grows in place.
+        for (int i = 1; i < 200; ++i)
+            vec.push_back(i);
+        assert(vec.begin() == first && vec.size() == 200 && vec[199] == 199);
+
+        my::vector<int, my::arena_allocator<int>> other(vec.begin(), vec.end(), alloc);
+        other.insert(other.begin(), 5, -1);
+        assert(other.size() == 205 && other[5] == 0 && other.get_allocator() == alloc);
+    }
+    {
+        my::arena_allocator<tracked> talloc(ar);
+        my::vector<tracked, my::arena_allocator<tracked>> vec(talloc);
+
+        for (int i = 0; i < 100; ++i)
+            vec.emplace_back(i);
+        vec.erase(vec.begin(), vec.begin() + 50);
+        assert(vec.size() == 50 && vec[0].value == 50 && tracked::alive == 50);
+    }
+    assert(tracked::alive == 0);
+
+    // after release() the next batch reuses the same memory.
+    ar.release();
+    assert(ar.used() == 0);
+    my::vector<int, my::arena_allocator<int>> vec(alloc);
+    vec.push_back(1);
+    void *p = vec.begin();
+    ar.release();
+    my::vector<int, my::arena_allocator<int>> again(alloc);
+    again.push_back(2);
+    assert(static_cast<void*>(again.begin()) == p);
+
+    // aligning the next block past the end of a chunk opens a new one.
+    struct alignas(64) line { double v[8]; };
+    my::arena odd(1000);
+    assert(odd.allocate(999, 1) != nullptr);
+    char *q = static_cast<char*>(odd.allocate(8, 16));
+    assert(reinterpret_cast<uintptr_t>(q) % 16 == 0);
+    q[0] = q[7] = 1;
+    my::arena_allocator<line> lalloc(odd);
+    my::vector<line, my::arena_allocator<line>> lines(lalloc);
+    for (int i = 0; i < 100; ++i) {
+        lines.push_back(line());
+        lines.back().v[7] = i;
+        assert(reinterpret_cast<uintptr_t>(lines.begin()) % 64 == 0);
+    }
+    assert(lines[99].v[7] == 99);
+
+    std::cout << "arena_test passed" << std::endl;
+}
+
+void aligned_test(void) {
+    my::aligned_vector<double> vec(3, 1.0);
+
+    // every reallocation keeps the buffer on a cache line.
+    for (int i = 0; i < 1000; ++i) {
+        vec.push_back(i);
+        assert(reinterpret_cast<uintptr_t>(vec.begin()) % 64 == 0);
+    }
+    assert(my::simd::sum(vec) == 3 + 999 * 1000 / 2);
+    assert(my::simd::argmax(vec) == 1002 && my::simd::min(vec) == 0);
+
+    std::cout << "aligned_test passed" << std::endl;
+}
+
+void mapped_test(void) {
+    struct point { double x, y; int id; };
+    std::string path = "/tmp/mapped_test." + std::to_string(getpid());
+
+    {
+        my::mapped_vector<point> vec(path);
+        assert(vec.empty());
+        for (int i = 0; i < 100000; ++i)
+            vec.push_back(point{i * 0.5, -i * 0.5, i});
+        vec.advise(my::mapped_vector<point>::access::sequential);
+        vec.sync();
+        assert(vec.size() == 100000 && vec.back().id == 99999);
+    }
+    {
+        // reopening maps the same elements back in.
+        my::mapped_vector<point> vec(path);
+        assert(vec.size() == 100000 && vec[1234].id == 1234 && vec[1234].y == -617);
+        vec.resize(10);
+        vec.shrink_to_fit();
+        vec.resize(20);
+        assert(vec[9].id == 9 && vec[10].id == 0);
+
+        my::mapped_vector<point> other(std::move(vec));
+        assert(other.size() == 20 && vec.size() == 0);
+    }
+    try {
+        my::mapped_vector<int> wrong(path);
+        assert(false);
+    } catch (const std::runtime_error&) {
+    }
+    std::remove(path.c_str());
+
+    std::cout << "mapped_test passed" << std::endl;
+}
+
+void growth_test(void) {
+    // a single resize allocates what it is asked for.
+    my::vector<int> vec;
+    vec.resize(1000);
+    assert(vec.capacity() == 1000);
+    vec.push_back(1);
+    assert(vec.capacity() == 2000);
+    vec.resize(10);
+    vec.shrink_to_fit();
+    assert(vec.capacity() == 10 && vec.size() == 10);
+    vec.clear();
+    vec.shrink_to_fit();
+    assert(vec.capacity() == 0 && vec.begin() == nullptr);
+
+    my::vector<tracked, my::allocator<tracked>, my::grow_by_half> half;
+    for (int i = 0; i < 11; ++i)
+        half.emplace_back(i);
+    assert(half.capacity() == 15 && half[10].value == 10);
+    half.shrink_to_fit();
+    assert(half.capacity() == 11 && tracked::alive == 11);
+
+    my::vector<int, my::allocator<int>, my::grow_exact> exact;
+    for (int i = 0; i < 5; ++i)
+        exact.push_back(i);
+    assert(exact.capacity() == 5);
+
+    my::vector<char, my::allocator<char>, my::grow_page_rounded<>> paged;
+    paged.push_back('a');
+    assert(paged.capacity() == 4096);
+
+    // a huge page block grows by remapping and keeps its contents.
+    my::vector<long, my::huge_page_allocator<long>> big;
+    for (long i = 0; i < 2000000; ++i)
+        big.push_back(i);
+    assert(reinterpret_cast<uintptr_t>(big.begin()) % (2 << 20) == 0);
+    for (long i = 0; i < 2000000; i += 4099)
+        assert(big[i] == i);
+    big.resize(100);
+    big.shrink_to_fit();
+    assert(big.size() == 100 && big[99] == 99);
+
+    my::vector<tracked, my::huge_page_allocator<tracked>> objects;
+    for (int i = 0; i < 1000000; ++i)
+        objects.emplace_back(i);
+    assert(objects.back().value == 999999);
+    objects.clear();
+    objects.shrink_to_fit();
+
+    std::cout << "growth_test passed" << std::endl;
+}
+
+void string_test(void) {
+    my::vector<std::string> vec{"alpha", "beta", "gamma"};
+
+    for (int i = 0; i < 50; ++i)
+        vec.push_back(vec[i % 3]);
+    vec.insert(vec.begin(), vec.back());
+    assert(vec.size() == 54 && vec[0] == vec.back());
+
+    for (auto &s : vec)
+        std::cout << s << " ";
+    std::cout << std::endl;
+}
+
+void small_vector_test(void) {
+    {
+        my::small_vector<tracked, 4> vec;
+        assert(vec.is_inline() && vec.capacity() == 4);
+
+        for (int i = 0; i < 4; ++i)
+            vec.push_back(tracked(i));
+        assert(vec.is_inline() && tracked::alive == 4);
+
+        // moving an inline vector moves its elements.
+        my::small_vector<tracked, 4> other(std::move(vec));
+        assert(other.is_inline() && other.size() == 4 && vec.empty());
+        assert(tracked::alive == 4);
+
+        other.push_back(tracked(4));
+        assert(!other.is_inline() && other.size() == 5 && other[4].value == 4);
+
+        // moving a spilled vector steals its heap buffer.
+        tracked::reset();
+        vec = std::move(other);
+        assert(tracked::moves == 0 && vec.size() == 5);
+        assert(other.is_inline() && other.empty());
+
+        // shrink_to_fit() trims the heap buffer, then returns inline.
+        vec.reserve(100);
+        vec.shrink_to_fit();
+        assert(!vec.is_inline() && vec.capacity() == 5 && vec[4].value == 4);
+        vec.pop_back();
+        vec.pop_back();
+        vec.shrink_to_fit();
+        assert(vec.is_inline() && vec.capacity() == 4 && vec.size() == 3);
+        assert(vec[0].value == 0 && vec[2].value == 2 && tracked::alive == 3);
+        vec.shrink_to_fit();
+        assert(vec.is_inline() && vec.capacity() == 4);
+        vec.push_back(tracked(7));
+        vec.push_back(tracked(8));
+        assert(!vec.is_inline() && vec[4].value == 8);
+
+        my::small_vector<std::string, 2> strs(10, std::string(40, 'x'));
+        strs.resize(1);
+        strs.shrink_to_fit();
+        assert(strs.is_inline() && strs[0] == std::string(40, 'x'));
+    }
+    assert(tracked::alive == 0);
+    std::cout << "small_vector_test passed" << std::endl;
+}
+
+int
+main(void) {
+    storage_test<my::vector<tracked>>("vector");
+    storage_test<my::small_vector<tracked, 4>>("small_vector");
+    small_vector_test();
+    relocate_test();
+    range_test<my::vector<tracked>>("vector");
+    range_test<my::small_vector<tracked, 8>>("small_vector");
+    emplace_test<my::vector<tracked>>("vector");
+    emplace_test<my::small_vector<tracked, 8>>("small_vector");
+    arena_test();
+    aligned_test();
+    mapped_test();
+    growth_test();
+    assert(tracked::alive == 0);
+
+    // integral arguments select the (count, value) overloads.
+    my::vector<int> ints(5, 3);
+    assert(ints.size() == 5 && ints[4] == 3);
+    ints.insert(ints.begin(), 2, 7);
+    assert(ints.size() == 7 && ints[1] == 7 && ints[2] == 3);
+    string_test();
+
+    return 0;
+}